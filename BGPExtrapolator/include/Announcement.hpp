@@ -14,6 +14,16 @@ struct AnnouncementStaticData {
     int64_t timestamp;
 
     std::string prefixString;
+
+    // Where the seeded AS_PATH of this announcement lives in the graph's path arena.
+    // Only filled in when the graph retains seeded paths (needed to re-seed a prefix block in delta mode)
+    uint64_t seededPathOffset;
+    uint32_t seededPathLength;
+
+    AnnouncementStaticData() : originASN(0), timestamp(0), seededPathOffset(0), seededPathLength(0) {
+        prefix.global_id = 0;
+        prefix.block_id = 0;
+    }
 };
 
 /**
@@ -0,0 +1,233 @@
+#pragma once
+
+/**
+ * C API of libbgpextrapolator, for services that embed the extrapolator instead of running it and parsing its results files.
+ *
+ * A graph is built from a relationships file (or from relationships in memory) or loaded from a checkpoint, seeded with announcements
+ *  (a file, or an array in memory), propagated, and then read in place:
+ *  - bgpx_graph_rib_row points into the local ribs themselves, a run of cells of one AS. Nothing is copied or formatted
+ *  - bgpx_graph_announcement points into the static data the cells refer to (origin, prefix, timestamp)
+ *  - bgpx_graph_traceback follows the received from IDs into a buffer of the caller
+ * Pointers handed out stay valid until the graph is seeded, propagated again or destroyed.
+ *
+ * Prefix blocks are the columns of the local ribs, numbered as in the prefix_block_id column of the announcements.
+ * AS IDs are the rows, see bgpx_graph_asn_to_id. Removed stubs (stub removal) have no ID, but can be traced back.
+ *
+ * Every function that can fail returns a status, with the reason in bgpx_last_error (per thread). No C++ exception crosses the API.
+ * A graph may be read from several threads at once, but must not be read while it is being seeded or propagated.
+ *
+ * The API only grows: a function or struct is never changed once released. BGPX_API_VERSION goes up with every addition.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(BGPX_SHARED)
+    #ifdef BGPX_BUILDING_LIBRARY
+        #define BGPX_API __declspec(dllexport)
+    #else
+        #define BGPX_API __declspec(dllimport)
+    #endif
+#elif defined(__GNUC__)
+    #define BGPX_API __attribute__((visibility("default")))
+#else
+    #define BGPX_API
+#endif
+
+#define BGPX_API_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bgpx_graph bgpx_graph;
+
+typedef enum {
+    BGPX_OK = 0,
+    BGPX_ERROR_INVALID_ARGUMENT = 1,
+    BGPX_ERROR_IO = 2,
+    BGPX_ERROR_NOT_FOUND = 3,
+    BGPX_ERROR_BUFFER_TOO_SMALL = 4,
+    BGPX_ERROR_INTERNAL = 5
+} bgpx_status;
+
+typedef enum {
+    BGPX_TIMESTAMP_DISABLED = 0,
+    BGPX_TIMESTAMP_PREFER_NEWER = 1,
+    BGPX_TIMESTAMP_PREFER_OLDER = 2
+} bgpx_timestamp_comparison;
+
+typedef enum {
+    BGPX_TIEBRAKING_RANDOM = 0,
+    BGPX_TIEBRAKING_PREFER_LOWEST_ASN = 1
+} bgpx_tiebraking_method;
+
+/**
+ * One AS of the relationships dataset, the same as a row of the relationships file
+ */
+typedef struct {
+    uint32_t asn;
+    int32_t propagation_rank;
+    int stub;
+
+    const uint32_t *providers;
+    size_t num_providers;
+    const uint32_t *peers;
+    size_t num_peers;
+    const uint32_t *customers;
+    size_t num_customers;
+    const uint32_t *stubs;
+    size_t num_stubs;
+} bgpx_relationship;
+
+/**
+ * One announcement, the same as a row of the announcements file. Only read while seeding
+ */
+typedef struct {
+    const char *prefix;
+    const uint32_t *as_path;
+    size_t as_path_length;
+    int64_t timestamp;
+    uint32_t prefix_id;
+    uint32_t prefix_block_id;
+} bgpx_announcement;
+
+/**
+ * Seeding options, see the seeding options of the launch file. bgpx_seeding_config_init sets the defaults
+ */
+typedef struct {
+    int origin_only;
+    bgpx_timestamp_comparison timestamp_comparison;
+    bgpx_tiebraking_method tiebraking_method;
+} bgpx_seeding_config;
+
+/**
+ * A local rib cell, laid out exactly as the cells of the graph (12 bytes)
+ */
+typedef struct {
+    // AS ID the announcement was received from, the AS itself at the origin (or from a removed stub origin, with a path length of 2)
+    uint32_t received_from_id;
+    // See bgpx_graph_announcement
+    uint32_t static_data_index;
+    uint8_t seeded;
+    // 0 if the AS has no route for the prefix block
+    uint8_t path_length;
+    uint8_t relationship;
+} bgpx_rib_cell;
+
+/**
+ * The announcement a cell refers to. The prefix points into the graph
+ */
+typedef struct {
+    const char *prefix;
+    uint32_t origin_asn;
+    int64_t timestamp;
+    uint32_t prefix_id;
+    uint32_t prefix_block_id;
+} bgpx_announcement_data;
+
+BGPX_API int bgpx_api_version(void);
+
+/**
+ * @return why the last call on this thread failed, empty if it did not
+ */
+BGPX_API const char* bgpx_last_error(void);
+
+//***** Building and loading
+
+/**
+ * @param relationships_file -> Relationships TSV or raw CAIDA as-rel/as-rel2 file (plain, or compressed if the library was built with zlib/libzstd)
+ * @param stub_removal -> Whether to leave out the stubs (see the stub_removal launch option)
+ * @param num_threads -> Threads that rank the ASes of a raw CAIDA file, then used by propagation (see bgpx_graph_set_num_threads). 0 is treated as 1
+ * @param graph -> Set to the new graph, destroyed with bgpx_graph_destroy
+ */
+BGPX_API bgpx_status bgpx_graph_create(const char *relationships_file, int stub_removal, size_t num_threads, bgpx_graph **graph);
+
+/**
+ * Same as above, for relationships that are already in memory (only read during the call)
+ */
+BGPX_API bgpx_status bgpx_graph_create_from_relationships(const bgpx_relationship *relationships, size_t num_relationships, int stub_removal, bgpx_graph **graph);
+
+/**
+ * @param checkpoint_file -> File written by bgpx_graph_write_checkpoint (or the checkpoint launch options)
+ */
+BGPX_API bgpx_status bgpx_graph_load_checkpoint(const char *checkpoint_file, bgpx_graph **graph);
+
+BGPX_API bgpx_status bgpx_graph_write_checkpoint(const bgpx_graph *graph, const char *checkpoint_file);
+
+BGPX_API void bgpx_graph_destroy(bgpx_graph *graph);
+
+/**
+ * @param num_threads -> Threads used by propagation, including the calling one. 0 is treated as 1
+ */
+BGPX_API bgpx_status bgpx_graph_set_num_threads(bgpx_graph *graph, size_t num_threads);
+
+//***** Seeding and propagation
+
+BGPX_API void bgpx_seeding_config_init(bgpx_seeding_config *config);
+
+/**
+ * Resets the local ribs and seeds the announcements, sized for the given number of prefix blocks
+ *
+ * @param num_prefix_blocks -> One past the highest prefix_block_id of the announcements
+ * @param config -> Seeding options, NULL for the defaults
+ */
+BGPX_API bgpx_status bgpx_graph_seed(bgpx_graph *graph, const bgpx_announcement *announcements, size_t num_announcements, uint32_t num_prefix_blocks,
+    const bgpx_seeding_config *config);
+
+/**
+ * Same as above, from an announcements file
+ */
+BGPX_API bgpx_status bgpx_graph_seed_file(bgpx_graph *graph, const char *announcements_file, const bgpx_seeding_config *config);
+
+BGPX_API bgpx_status bgpx_graph_propagate(bgpx_graph *graph);
+
+//***** Reading the local ribs
+
+BGPX_API size_t bgpx_graph_num_ases(const bgpx_graph *graph);
+BGPX_API size_t bgpx_graph_num_prefix_blocks(const bgpx_graph *graph);
+
+/**
+ * @param id -> Set to the row of the AS in the local ribs
+ * @return BGPX_ERROR_NOT_FOUND if the AS has no row (not in the graph, or a removed stub)
+ */
+BGPX_API bgpx_status bgpx_graph_asn_to_id(const bgpx_graph *graph, uint32_t asn, uint32_t *id);
+
+/**
+ * @return the ASN of the AS ID, 0 if there is no such ID
+ */
+BGPX_API uint32_t bgpx_graph_id_to_asn(const bgpx_graph *graph, uint32_t id);
+
+/**
+ * The cells of an AS are contiguous over a run of prefix blocks (all of them unless the local ribs are tiled), read them in place
+ *
+ * @param count -> Set to the number of cells of the AS from the returned one on (prefix blocks prefix_block_id, prefix_block_id + 1, ...)
+ * @return the cell of the AS for the prefix block, NULL if either is out of range
+ */
+BGPX_API const bgpx_rib_cell* bgpx_graph_rib_row(const bgpx_graph *graph, uint32_t id, uint32_t prefix_block_id, size_t *count);
+
+/**
+ * @param static_data_index -> static_data_index of a cell with a route
+ */
+BGPX_API bgpx_status bgpx_graph_announcement(const bgpx_graph *graph, uint32_t static_data_index, bgpx_announcement_data *announcement);
+
+/**
+ * The AS path an AS uses for a prefix block, from the AS to the origin (as written to the results). Removed stubs get the route of their provider
+ *
+ * @param path -> Filled with up to capacity ASNs
+ * @param path_length -> Set to the length of the whole path
+ * @return BGPX_ERROR_NOT_FOUND if the AS has no route for the prefix block, BGPX_ERROR_BUFFER_TOO_SMALL if the path did not fit
+ */
+BGPX_API bgpx_status bgpx_graph_traceback(const bgpx_graph *graph, uint32_t asn, uint32_t prefix_block_id, uint32_t *path, size_t capacity, size_t *path_length);
+
+/**
+ * Writes the results file, the same as the CLI does
+ *
+ * @param asns -> Local ribs to write, none (NULL, 0) writes all of them
+ * @return BGPX_ERROR_IO if the file could not be opened or written
+ */
+BGPX_API bgpx_status bgpx_graph_write_results(bgpx_graph *graph, const char *results_file, const uint32_t *asns, size_t num_asns);
+
+#ifdef __cplusplus
+}
+#endif
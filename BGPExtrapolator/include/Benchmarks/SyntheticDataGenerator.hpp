@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+
+#include "Defines.h"
+
+/**
+ * Shape of a synthetic dataset. Every field has a default, so only what is being varied needs to be set.
+ */
+struct SyntheticDataConfiguration {
+    // Same seed and configuration -> byte for byte the same files, on any platform
+    uint32_t seed;
+
+    size_t numASes;
+
+    // Number of tiers of the hierarchy (tier 0 is the clique at the top). Propagation ranks end up at most this deep
+    size_t rankDepth;
+
+    // Each tier is this many times larger than the tier above it
+    double tierGrowth;
+
+    // Providers per AS are drawn from a power law P(k) ~ k^-providerExponent, k in [1, maxProviders]
+    size_t maxProviders;
+    double providerExponent;
+
+    // Chance that an AS has peers at all, and the most peers (in its own tier) it may pick
+    double peeringProbability;
+    size_t maxPeers;
+
+    size_t numPrefixes;
+
+    // Announcements per prefix are uniform in [1, maxAnnouncementsPerPrefix], each from a random walk of up to maxPathLength ASes
+    size_t maxAnnouncementsPerPrefix;
+    size_t maxPathLength;
+
+    SyntheticDataConfiguration() : seed(1), numASes(10000), rankDepth(5), tierGrowth(4.0), maxProviders(6), providerExponent(2.0),
+        peeringProbability(0.3), maxPeers(8), numPrefixes(1000), maxAnnouncementsPerPrefix(4), maxPathLength(6) {
+
+    }
+};
+
+/**
+ * Generates a deterministic CAIDA like topology (relationships TSV, in the format of the propagation rank files the Graph reads)
+ *  and announcements for it (announcements TSV, the format SeedBlock reads), so the extrapolator can be benchmarked at any scale
+ *  without the real datasets.
+ *
+ * The topology is a hierarchy of tiers. Tier 0 is a full peering clique, every other AS buys transit from ASes in the tiers above it,
+ *  preferring ASes that already have many customers (preferential attachment), which gives the heavy tailed customer degrees of the real graph.
+ * Peering only happens within a tier. Ranks and stubs are derived from the result exactly as the real files define them.
+ *
+ * Only the random engine's raw output is used (its sequence is fixed by the standard), not the standard distributions (whose results are not),
+ *  so the output does not depend on the standard library.
+ */
+class SyntheticDataGenerator {
+private:
+    SyntheticDataConfiguration config;
+
+    std::vector<ASN> asns;
+    std::vector<size_t> tiers;
+    std::vector<std::vector<ASN_ID>> providers, peers, customers;
+    std::vector<uint32_t> ranks;
+
+    // Uniform in [0, bound)
+    static uint64_t Uniform(std::mt19937_64 &engine, const uint64_t bound);
+
+    // Uniform in [0, 1)
+    static double UniformReal(std::mt19937_64 &engine);
+
+    void GenerateTopology();
+    void ComputeRanks();
+
+public:
+    SyntheticDataGenerator(const SyntheticDataConfiguration &config);
+
+    inline size_t GetNumASes() const { return asns.size(); }
+    inline size_t GetMaximumRank() const { return ranks.empty() ? 0 : *std::max_element(ranks.begin(), ranks.end()); }
+    inline const std::vector<ASN>& GetASNs() const { return asns; }
+
+    /**
+     * @param filePath -> Relationships TSV to write (asn, peers, customers, providers, propagation_rank, stub, stubs)
+     * @return false if the file could not be written
+     */
+    bool WriteRelationships(const std::string &filePath) const;
+
+    /**
+     * @param filePath -> Announcements TSV to write (prefix, as_path, origin, timestamp, prefix_id, block_id, prefix_block_id)
+     * @return false if the file could not be written
+     */
+    bool WriteAnnouncements(const std::string &filePath) const;
+
+    /**
+     * Random AS_PATH strings as found in the announcements ("{1,2,3}"), for parser benchmarks
+     *
+     * @param count -> Number of paths
+     * @param pathLength -> ASNs per path
+     */
+    std::vector<std::string> GenerateASPathStrings(const size_t count, const size_t pathLength) const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Graphs/Graph.hpp"
+#include "BoundedQueue.hpp"
+
+/**
+ * Prefix blocks of an announcements file that are seeded and propagated together, parsed and renumbered densely from 0
+ */
+struct BlockBatch {
+    std::vector<ScenarioAnnouncement> announcements;
+    uint32_t numPrefixBlocks;
+};
+
+/**
+ * Where the time of a pipelined run went, in milliseconds. The stages run side by side, so their times add up to more than the total.
+ */
+struct PipelineTimings {
+    double planMilliseconds;
+    double parseMilliseconds;
+    double seedingMilliseconds;
+    double propagationMilliseconds;
+    double writeMilliseconds;
+
+    // Time the propagating stage waited for a parsed batch, and for the writer to give a buffer back
+    double parseStallMilliseconds;
+    double writeStallMilliseconds;
+
+    PipelineTimings() : planMilliseconds(0), parseMilliseconds(0), seedingMilliseconds(0), propagationMilliseconds(0), writeMilliseconds(0),
+        parseStallMilliseconds(0), writeStallMilliseconds(0) {
+
+    }
+};
+
+/**
+ * Runs the prefix blocks of an announcements file through the graph in batches, as a three stage pipeline: batch N+1 is parsed
+ *  (on its own thread) while batch N is seeded and propagated (on the calling thread and the thread pool of the graph)
+ *  and the results of batch N-1 are written (on its own thread). The whole run takes about as long as its slowest stage
+ *  rather than the sum of the three.
+ *
+ * Prefix blocks are independent during propagation, so the results are the same as those of a single SeedBlock, Propagate
+ *  and GenerateTracebackResultsCSV (in another order). Batches are contiguous prefix_block_id ranges of about batchRows rows
+ *  (never splitting a block), found with a quick pass over the file first. A batch is handed on as soon as all of its rows have been read,
+ *  so a file sorted by prefix_block_id streams through with only a few batches in memory.
+ *
+ * The local rib allocation is double buffered: the graph propagates into one while the writer reads the other (see Graph::SwapPropagatedBlocks),
+ *  both sized for a batch rather than for the whole file. The queues hold one batch each, so the pipeline never gets more than one batch ahead.
+ * Only for local ribs in memory (neither file backed nor NUMA placed), and without checkpoints, which need the state of every block at once.
+ */
+class BlockPipeline {
+private:
+    Graph &graph;
+    size_t batchRows;
+
+    PipelineTimings timings;
+    PropagationTimings propagationTimings;
+    PropagationStatisticsProfile statisticsProfile;
+    size_t numBatches;
+    size_t numRows;
+
+public:
+    /**
+     * @param graph -> Loaded graph to run the batches through
+     * @param batchRows -> About how many announcements to seed and propagate at once
+     */
+    BlockPipeline(Graph &graph, const size_t batchRows);
+
+    /**
+     * Splits the prefix blocks of an announcements file into batches of contiguous prefix_block_id ranges
+     *
+     * @param announcementsFilePath -> Announcements TSV
+     * @param batchRows -> About how many rows a batch holds (a batch holds at least one block)
+     * @param blockToBatch -> Filled with the batch of every prefix block, and its block ID within the batch
+     * @param rowsPerBatch -> Filled with the number of rows of every batch
+     * @param blocksPerBatch -> Filled with the number of prefix blocks of every batch
+     * @return false if the file could not be read or has no prefix_block_id column
+     */
+    static bool PlanBatches(const std::string &announcementsFilePath, const size_t batchRows, std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> &blockToBatch,
+        std::vector<size_t> &rowsPerBatch, std::vector<uint32_t> &blocksPerBatch);
+
+    /**
+     * Seeds, propagates and writes the results of every prefix block of an announcements file
+     *
+     * @param announcementsFilePath -> Announcements TSV
+     * @param config -> Seeding configuration, when there are no lanes
+     * @param lanes -> Configurations to evaluate side by side (see Graph::SeedBlock), empty for a single one
+     * @param resultsFilePaths -> One results file, or one per lane
+     * @param localRibsToDump -> ASNs of ASes to trace the route for all prefixes in the local rib
+     * @param filter -> Rows to write among those of the dumped ASes
+     * @param bytesWritten -> Filled with the number of bytes written to every results file
+     * @return false if the announcements or results files could not be read or written
+     */
+    bool Run(const std::string &announcementsFilePath, const SeedingConfiguration &config, const std::vector<LaneConfiguration> &lanes,
+        const std::vector<std::string> &resultsFilePaths, const std::vector<ASN> &localRibsToDump, const ResultsFilter &filter, std::vector<size_t> &bytesWritten);
+
+    inline const PipelineTimings& GetTimings() const { return timings; }
+
+    /**
+     * Phase and rank times of every batch propagated, added up
+     */
+    inline const PropagationTimings& GetPropagationTimings() const { return propagationTimings; }
+
+    /**
+     * Kernel statistics of every batch seeded and propagated, added up
+     */
+    inline const PropagationStatisticsProfile& GetPropagationStatistics() const { return statisticsProfile; }
+
+    inline size_t GetNumBatches() const { return numBatches; }
+    inline size_t GetNumRows() const { return numRows; }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * A queue between two threads (the stages of the block pipeline, a decompressor and its reader), holding at most capacity items.
+ * Push waits while it is full and Pop while it is empty. Once closed, Push drops its item and Pop returns false when nothing is left.
+ */
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed;
+
+    std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+
+public:
+    BoundedQueue(const size_t capacity) : capacity(capacity), closed(false) {
+
+    }
+
+    /**
+     * @return false if the queue was closed, the item is dropped
+     */
+    bool Push(T &&item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [&]() { return closed || items.size() < capacity; });
+        if (closed)
+            return false;
+
+        items.push_back(std::move(item));
+        notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * @return false if the queue was closed and nothing is left in it
+     */
+    bool Pop(T &item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [&]() { return closed || !items.empty(); });
+        if (items.empty())
+            return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Empties the queue and opens it again after Close
+     */
+    void Reopen() {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.clear();
+        closed = false;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <nlohmann/json.hpp>
+
+#include "Graphs/Graph.hpp"
+
+/**
+ * Runs experiments back to back on a graph that stays loaded, so a parameter sweep pays for loading the topology (and for allocating
+ *  the local ribs and the threads) once rather than once per experiment.
+ *
+ * Requests and responses are JSON lines, one request at a time, in order. An experiment request:
+ *  { "id": <anything, echoed back>, "announcements_file": "...", "output_folder": "...",
+ *    "seeding_origin_only": ..., "seeding_tiebraking_method": ..., "propagation_timestamp_comparison_method": ...,
+ *    "control_plane_traceback_asn": [...], "write_results_after_seeding": ..., "results_filter_prefixes": [...], "results_filter_origins": [...],
+ *    "results_filter_relationships": [...], "results_propagated_only": ... }
+ *  with the same meaning and defaults as in the launch configuration (only announcements_file and output_folder are required).
+ *  It is answered by { "id": ..., "status": "ok", "results_file": "...", "num_prefixes": ..., "results_bytes_written": ..., "timings_ms": {...} }
+ *  or { "id": ..., "status": "error", "error": "..." }, after which the server goes on with the next request.
+ *
+ * Queries about the routes of the last experiment (see Graph::BuildRouteIndex, built by the first query after an experiment):
+ *  { "command": "query", "prefix": "..." (or "prefix_block_id": ...), "asn": ... } -> { "route": { "prefix", "origin", "timestamp", "next_hop", "as_path" } }
+ *  { "command": "query", "prefix": "...", "origin": ... } or "next_hop": ... -> { "asns": [...] }, the ASes (stubs included) routing via it
+ *  { "command": "query", "prefix": "..." } -> { "origins": [ { "origin", "num_ases" } ] }
+ *
+ * { "command": "shutdown" } stops the server.
+ */
+class ExperimentServer {
+private:
+    Graph &graph;
+    size_t numServed;
+    bool shutdown;
+
+    /**
+     * Seeds, propagates and writes the results of one experiment
+     */
+    nlohmann::json RunExperiment(const nlohmann::json &request);
+
+    /**
+     * Answers a query about the routes of the last experiment
+     */
+    nlohmann::json RunQuery(const nlohmann::json &request);
+
+public:
+    ExperimentServer(Graph &graph);
+
+    /**
+     * @param line -> One request
+     * @return the response to it (a single line)
+     */
+    std::string HandleRequest(const std::string &line);
+
+    inline bool IsShutdown() const { return shutdown; }
+    inline size_t GetNumServed() const { return numServed; }
+
+    /**
+     * Serves requests until the end of the stream or a shutdown request
+     *
+     * @param requests -> Request lines
+     * @param responses -> Response lines, flushed after every one
+     */
+    void Serve(std::istream &requests, std::ostream &responses);
+
+    /**
+     * Listens on a UNIX domain socket and serves one connection at a time until a shutdown request. POSIX only.
+     *
+     * @param socketPath -> Path of the socket, replaced if it exists and removed when the server stops
+     * @return false if the socket could not be set up
+     */
+    bool ServeSocket(const std::string &socketPath);
+};
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+#include "Defines.h"
+
+/**
+ * ASN lookups of the graph (the ID of an AS, or the provider of a removed stub) in one 4 byte slot per ASN, found without hashing.
+ * Seeding looks up every ASN of every AS_PATH, so this is hit hundreds of millions of times on a full MRT dump.
+ *
+ * Two levels over the 32 bit ASN space, by the upper and lower 16 bits. Real ASNs are clustered: the 16 bit ASNs fill most of the first
+ *  page, and 32 bit ASNs are handed out in a few consecutive pages. Those pages are direct tables (one slot per lower half, a single load).
+ *  Pages with few ASNs (private and documentation ranges, stray values) keep their lower halves sorted instead, searched without branching,
+ *  so a scattered set of ASNs cannot blow up the table.
+ *
+ * A slot holds the ID of the AS or, with REMOVED_STUB set, the ID of the provider of a stub that has no ID of its own (stub removal).
+ * Built once from the topology, read only afterwards (safe to read from any number of threads).
+ */
+class ASNTable {
+public:
+    static const uint32_t NONE = 0xFFFFFFFF;
+    static const uint32_t REMOVED_STUB = 0x80000000;
+
+    struct Entry {
+        // ID of the AS, NONE if it has no local rib (not in the graph, or a removed stub)
+        ASN_ID id;
+        // ID of the provider if the AS is a removed stub, NONE otherwise
+        ASN_ID stubProviderID;
+    };
+
+private:
+    // A page with at least this many ASNs is a direct table: at most 64 slots of memory per ASN
+    static const uint32_t DIRECT_PAGE_MINIMUM = 1024;
+    // Up to this many pages with ASNs (4 MB of slots), every one of them is a direct table however few ASNs it has
+    static const uint32_t DIRECT_PAGES_ALWAYS = 16;
+    static const uint32_t PAGE_SIZE = 1 << 16;
+
+    struct Page {
+        // First slot of the page (in directSlots for a direct table, in sparseSlots otherwise), and its number of ASNs (PAGE_SIZE for a direct table)
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    // One per upper half of the ASN, only those up to the highest ASN
+    std::vector<Page> pages;
+
+    // One slot per lower half of every direct page
+    std::vector<uint32_t> directSlots;
+
+    // One slot per ASN of the sparse pages, along with the lower half of the ASN (sorted within every page)
+    std::vector<uint16_t> sparseKeys;
+    std::vector<uint32_t> sparseSlots;
+
+    // Every stub and the ID of its provider (removed or not), sorted by ASN
+    std::vector<std::pair<ASN, ASN_ID>> stubs;
+
+    inline uint32_t FindSlot(const ASN asn) const {
+        const uint32_t upper = asn >> 16;
+        if (upper >= pages.size())
+            return NONE;
+
+        const Page &page = pages[upper];
+        const uint16_t lower = asn & 0xFFFF;
+        if (page.count == PAGE_SIZE)
+            return directSlots[page.offset + lower];
+        if (page.count == 0)
+            return NONE;
+
+        // Sparse page: halve the range with conditional moves rather than branches, the keys are too few to predict
+        const uint16_t *base = sparseKeys.data() + page.offset;
+        uint32_t length = page.count;
+        while (length > 1) {
+            const uint32_t half = length / 2;
+            base = base[half] <= lower ? base + half : base;
+            length -= half;
+        }
+
+        return *base == lower ? sparseSlots[base - sparseKeys.data()] : NONE;
+    }
+
+public:
+    /**
+     * Replaces the table. When an ASN is listed more than once, the first ID (or provider) wins
+     *
+     * @param idToASN -> ASN of every ID
+     * @param stubToProviderID -> Stub ASNs and the ID of their provider, whether or not the stubs have an ID themselves
+     */
+    void Build(const std::vector<ASN> &idToASN, const std::vector<std::pair<ASN, ASN_ID>> &stubToProviderID);
+
+    /**
+     * @return the IDs of the ASN, both NONE if the graph does not know it
+     */
+    inline Entry Find(const ASN asn) const {
+        const uint32_t slot = FindSlot(asn);
+        Entry entry;
+        entry.id = (slot & REMOVED_STUB) == 0 ? slot : NONE;
+        entry.stubProviderID = slot != NONE && (slot & REMOVED_STUB) != 0 ? slot & ~REMOVED_STUB : NONE;
+        return entry;
+    }
+
+    inline bool FindID(const ASN asn, ASN_ID &id) const {
+        id = FindSlot(asn);
+        return (id & REMOVED_STUB) == 0;
+    }
+
+    /**
+     * Also knows the stubs that kept their ID, off the hot path
+     *
+     * @return the ID of the provider of the stub, NONE if the AS is not a stub
+     */
+    ASN_ID FindStubProviderID(const ASN asn) const;
+
+    inline const std::vector<std::pair<ASN, ASN_ID>>& GetStubs() const { return stubs; }
+
+    size_t GetMemoryUsage() const;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Defines.h"
+#include "ThreadPool.hpp"
+
+/**
+ * The neighbors of every AS of one kind, all in one array (CSR)
+ */
+struct Adjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> indices;
+
+    /**
+     * @param links -> (AS, neighbor) pairs sorted by AS
+     */
+    void Build(const size_t numASes, const std::vector<std::pair<uint32_t, uint32_t>> &links);
+
+    inline size_t Size(const uint32_t index) const { return offsets[index + 1] - offsets[index]; }
+};
+
+/**
+ * The ASes of a raw CAIDA file in the order of their ASNs, with their neighbors as indices into asns
+ */
+struct CAIDATopology {
+    std::vector<ASN> asns;
+    std::vector<int> ranks;
+    Adjacency providers, peers, customers;
+
+    /**
+     * A stub has a single provider and nothing else
+     */
+    inline bool IsStub(const uint32_t index) const { return providers.Size(index) == 1 && customers.Size(index) == 0 && peers.Size(index) == 0; }
+};
+
+/**
+ * Reads a raw CAIDA AS relationships file (serial-1 "as-rel" or serial-2 "as-rel2", plain or gzip/zstd compressed) into the adjacency of
+ *  every AS, with the columns the preprocessed TSV carries computed here: propagation_rank, stub and stubs. The graph is built straight
+ *  from the adjacency (see Graph::BuildRelationships), no row per AS is made.
+ *
+ * Lines are "<provider>|<customer>|-1" or "<peer>|<peer>|0", serial-2 adds the source of the inference after them. Comments start with '#'.
+ *
+ * The rank of an AS is 0 if it has no customers, one more than the highest rank of its customers otherwise. Ranks are found a rank at a time
+ *  (Kahn's topological sort over the customer to provider links): the ASes of a rank are split over the threads, and a provider joins the next
+ *  rank when its last customer is done. A cycle of customer to provider links would stop that, so it is reported and ranked without one of its links.
+ *
+ * A stub is listed in the stubs of its provider.
+ */
+class CAIDARelationships {
+public:
+    /**
+     * @return whether the file looks like a raw CAIDA relationships file rather than a relationships TSV (by its first line)
+     */
+    static bool IsCAIDAFile(const std::string &filePath);
+
+    /**
+     * @param threadPool -> Threads that rank the ASes
+     * @param topology -> Replaced by the ASes of the file
+     * @return false if the file could not be read or is corrupt, the reason is printed
+     */
+    static bool Read(const std::string &filePath, ThreadPool &threadPool, CAIDATopology &topology);
+};
@@ -6,8 +6,10 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <map>
 #include <memory>
+#include <algorithm>
 
 #include <limits>
 #include <rapidcsv.h>
@@ -17,6 +19,19 @@
 #include "Announcement.hpp"
 #include "LocalRibs.hpp"
 #include "LocalRibsTransposed.hpp"
+#include "RouteIndex.hpp"
+#include "ASNTable.hpp"
+#include "RibAggregates.hpp"
+#include "ResultsFilter.hpp"
+#include "ThreadPool.hpp"
+#include "PerfCounters.hpp"
+#include "PropagationStatistics.hpp"
+
+// Upper bound on the size of the peer staging buffer. The peer phase works through the prefixes in chunks that fit within this
+static const size_t PEER_STAGING_BUDGET_BYTES = 64 * 1024 * 1024;
+
+// Prefix blocks whose paths WriteTracebackResults formats side by side, also what MemoryPlanner budgets the results writer for
+static const uint32_t TRACEBACK_BLOCKS_PER_PASS = 32;
 
 enum TIMESTAMP_COMPARISON {
     DISABLED,
@@ -36,6 +51,71 @@ struct SeedingConfiguration {
     bool originOnly;
     TIMESTAMP_COMPARISON timestampComparison;
     TIEBRAKING_METHOD tiebrakingMethod;
+
+    SeedingConfiguration() : originOnly(false), timestampComparison(TIMESTAMP_COMPARISON::PREFER_NEWER), tiebrakingMethod(TIEBRAKING_METHOD::PREFER_LOWEST_ASN) {
+
+    }
+
+    /**
+     * Reads the seeding options of a launch configuration (seeding_origin_only, seeding_tiebraking_method, propagation_timestamp_comparison_method),
+     *  the ones that are not given keep their defaults
+     *
+     * @param json -> Launch configuration, or an experiment request of the server
+     * @param config -> Filled in
+     * @param error -> Why the options are invalid
+     * @return false if an option is invalid
+     */
+    static bool FromJSON(const nlohmann::json &json, SeedingConfiguration &config, std::string &error) {
+        auto origin_only_search = json.find("seeding_origin_only");
+        if (origin_only_search != json.end()) {
+            if (!origin_only_search.value().is_boolean()) {
+                error = "Expected boolean value for origin only!";
+                return false;
+            }
+
+            config.originOnly = origin_only_search.value().get<bool>();
+        }
+
+        auto tiebraking_search = json.find("seeding_tiebraking_method");
+        if (tiebraking_search != json.end()) {
+            std::string method = tiebraking_search.value().is_string() ? tiebraking_search.value().get<std::string>() : "";
+            if (method == "prefer_lowest_asn") {
+                config.tiebrakingMethod = TIEBRAKING_METHOD::PREFER_LOWEST_ASN;
+            } else if (method == "random") {
+                config.tiebrakingMethod = TIEBRAKING_METHOD::RANDOM;
+            } else {
+                error = "Unknown tiebraking method!";
+                return false;
+            }
+        }
+
+        auto timestamp_search = json.find("propagation_timestamp_comparison_method");
+        if (timestamp_search != json.end()) {
+            std::string method = timestamp_search.value().is_string() ? timestamp_search.value().get<std::string>() : "";
+            if (method == "prefer_newer") {
+                config.timestampComparison = TIMESTAMP_COMPARISON::PREFER_NEWER;
+            } else if (method == "prefer_older") {
+                config.timestampComparison = TIMESTAMP_COMPARISON::PREFER_OLDER;
+            } else if (method == "disabled") {
+                config.timestampComparison = TIMESTAMP_COMPARISON::DISABLED;
+            } else {
+                error = "Unknown Timestamp comparison method!";
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+/**
+ * One of the configurations evaluated side by side in a single propagation (see Graph::SeedBlock with lanes)
+ */
+struct LaneConfiguration {
+    SeedingConfiguration seeding;
+
+    // The complete provider preferences of this lane (see Graph::IsPrefferedProvider)
+    std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences;
 };
 
 /**
@@ -46,8 +126,183 @@ struct ASN_ASNID_PAIR {
     ASN_ID id;
 };
 
+/**
+ * The route an AS uses for a prefix block, see Graph::QueryRoute
+ */
+struct QueriedRoute {
+    std::string prefixString;
+    ASN originASN;
+    int64_t timestamp;
+
+    // The AS it was received from, -1 at the origin
+    int64_t nextHopASN;
+
+    // From the AS to the origin, as written to the results
+    std::vector<ASN> asPath;
+
+    QueriedRoute() : originASN(0), timestamp(0), nextHopASN(-1) {
+
+    }
+};
+
+/**
+ * One AS of the relationships dataset (a row of the relationships file)
+ */
+struct RelationshipInfo {
+    ASN asn;
+
+    // Assigned while building the graph, in the order of the rows
+    ASN_ID asnID;
+
+    int rank;
+    std::vector<ASN> peers, customers, providers, stubs;
+
+    RelationshipInfo() : asn(0), asnID(0), rank(0) {
+
+    }
+};
+
+/**
+ * An extra announcement to seed in a what-if scenario (see Graph::RunScenario)
+ */
+struct ScenarioAnnouncement {
+    std::vector<ASN> asPath;
+    Prefix prefix;
+    std::string prefixString;
+    int64_t timestamp;
+};
+
+/**
+ * The local ribs and static data of prefix blocks that have been propagated, taken out of the graph (see Graph::SwapPropagatedBlocks)
+ *  so that the results can be written while the graph seeds and propagates the next blocks in the other buffer
+ */
+struct PropagatedBlocks {
+    LocalRibs localRibs;
+    std::vector<AnnouncementStaticData> announcementStaticData;
+
+    inline const AnnouncementCachedData& GetCachedData_ReadOnly(const ASN_ID& asnID, const uint32_t& prefixBlockID) const {
+        return localRibs.GetAnnouncement_ReadOnly(asnID, prefixBlockID);
+    }
+
+    inline const AnnouncementStaticData& GetStaticData_ReadOnly(const size_t& index) const {
+        return announcementStaticData[index];
+    }
+
+    inline size_t GetNumStaticData() const { return announcementStaticData.size(); }
+    inline size_t GetNumPrefixes() const { return localRibs.GetNumPrefixes(); }
+};
+
+/**
+ * Where the time of propagation went, in milliseconds. Ranks are indexed by rank.
+ * When propagation is split into tiles or shards, the times of every tile/shard are added up (thread time, for shards running side by side)
+ */
+struct PropagationTimings {
+    double upMilliseconds;
+    double peersMilliseconds;
+    double downMilliseconds;
+
+    std::vector<double> upRankMilliseconds;
+    std::vector<double> downRankMilliseconds;
+
+    PropagationTimings() : upMilliseconds(0), peersMilliseconds(0), downMilliseconds(0) {
+
+    }
+
+    void Add(const PropagationTimings &other) {
+        upMilliseconds += other.upMilliseconds;
+        peersMilliseconds += other.peersMilliseconds;
+        downMilliseconds += other.downMilliseconds;
+
+        upRankMilliseconds.resize(std::max(upRankMilliseconds.size(), other.upRankMilliseconds.size()), 0);
+        for (size_t i = 0; i < other.upRankMilliseconds.size(); i++)
+            upRankMilliseconds[i] += other.upRankMilliseconds[i];
+
+        downRankMilliseconds.resize(std::max(downRankMilliseconds.size(), other.downRankMilliseconds.size()), 0);
+        for (size_t i = 0; i < other.downRankMilliseconds.size(); i++)
+            downRankMilliseconds[i] += other.downRankMilliseconds[i];
+    }
+};
+
+/**
+ * Hardware counters and local rib cells of one part of propagation (a phase or a rank), see Graph::SetProfiling.
+ * A cell is compared once for every neighbor it imports from, and replaced when the neighbor's announcement wins.
+ */
+struct PropagationProfileEntry {
+    PerfCounterValues counters;
+    uint64_t cellsCompared;
+    uint64_t cellsReplaced;
+
+    PropagationProfileEntry() : cellsCompared(0), cellsReplaced(0) {
+
+    }
+
+    void Add(const PropagationProfileEntry &other) {
+        counters.Add(other.counters);
+        cellsCompared += other.cellsCompared;
+        cellsReplaced += other.cellsReplaced;
+    }
+};
+
+/**
+ * Profile of propagation, added up over tiles and shards like PropagationTimings. Ranks are indexed by rank.
+ */
+struct PropagationProfile {
+    PropagationProfileEntry up;
+    PropagationProfileEntry peers;
+    PropagationProfileEntry down;
+
+    std::vector<PropagationProfileEntry> upRanks;
+    std::vector<PropagationProfileEntry> downRanks;
+
+    void Add(const PropagationProfile &other) {
+        up.Add(other.up);
+        peers.Add(other.peers);
+        down.Add(other.down);
+
+        upRanks.resize(std::max(upRanks.size(), other.upRanks.size()));
+        for (size_t i = 0; i < other.upRanks.size(); i++)
+            upRanks[i].Add(other.upRanks[i]);
+
+        downRanks.resize(std::max(downRanks.size(), other.downRanks.size()));
+        for (size_t i = 0; i < other.downRanks.size(); i++)
+            downRanks[i].Add(other.downRanks[i]);
+    }
+};
+
+/**
+ * Decisions of the seeding and propagation kernels (see PropagationStatistics.hpp) by phase and rank, added up over tiles and shards
+ *  like PropagationTimings. Only counted by builds with BGPX_STATISTICS, all zeros otherwise.
+ */
+struct PropagationStatisticsProfile {
+    PropagationStatistics seeding;
+    PropagationStatistics up;
+    PropagationStatistics peers;
+    PropagationStatistics down;
+
+    std::vector<PropagationStatistics> upRanks;
+    std::vector<PropagationStatistics> downRanks;
+
+    void Add(const PropagationStatisticsProfile &other) {
+        seeding.Add(other.seeding);
+        up.Add(other.up);
+        peers.Add(other.peers);
+        down.Add(other.down);
+
+        upRanks.resize(std::max(upRanks.size(), other.upRanks.size()));
+        for (size_t i = 0; i < other.upRanks.size(); i++)
+            upRanks[i].Add(other.upRanks[i]);
+
+        downRanks.resize(std::max(downRanks.size(), other.downRanks.size()));
+        for (size_t i = 0; i < other.downRanks.size(); i++)
+            downRanks[i].Add(other.downRanks[i]);
+    }
+};
+
 //Circular dependency
 class PropagationImportPolicy;
+class RibOverlay;
+class FileBuffer;
+struct CAIDATopology;
 
 //NOTE. "TODO" marks code changes. "PERF_TODO" marks a *performance* suggestion that needs to be tested
 
@@ -84,7 +339,8 @@ class PropagationImportPolicy;
 class Graph {
     protected:
         //Each ASN is mapped to a corresponding index called an ID. The purpose to allow direct index lookups rather than mappings.
-        std::unordered_map<ASN, ASN_ID> asnToID;
+        //The table also maps every stub to the ID of its provider, populated regardless of the stubRemoval flag
+        ASNTable asnTable;
         std::vector<ASN> idToASN;
 
         /**
@@ -107,6 +363,17 @@ class Graph {
          */
         std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences;
 
+        /**
+         * Lanes are configurations evaluated side by side, in one pass over the topology (see SeedBlock with lanes).
+         * Every prefix block has one column per lane: lane k of block b is column b * numLanes + k. Seeding is done per lane, and during
+         *  propagation only provider preferences can differ. laneDependentCustomers are the customers whose preferences are not the same
+         *  in every lane, those are imported lane by lane. The rest are decided once, by the preferences of lane 0.
+         * laneProviderPreferences is empty when the lanes use the preferences of the graph (always the case with a single lane).
+         */
+        size_t numLanes;
+        std::vector<std::unordered_map<ASN, std::vector<ASN>>> laneProviderPreferences;
+        std::unordered_set<ASN> laneDependentCustomers;
+
         // ASes are not stored individually. An "AS" is just an index in these structures
         // If stubs are excluded, then they will not have an ID or any memory allocated to them
         std::vector<std::unique_ptr<PropagationImportPolicy>> idToImportPolicy;
@@ -118,13 +385,67 @@ class Graph {
         std::vector<std::vector<ASN_ASNID_PAIR>> asIDToCustomerIDs;
 
         bool stubRemoval;
-        // This structure will be populated regardless of the stubRemoval flag
-        std::unordered_map<ASN, ASN_ID> stubASNToProviderID;
 
         std::vector<AnnouncementStaticData> announcementStaticData;
 
+        /**
+         * When enabled, the AS_PATH of every seeded announcement is kept in seededPaths (referenced by the static data).
+         * This is what allows a prefix block to be re-seeded later from a persisted state (delta mode). Off by default since it costs memory.
+         */
+        bool retainSeededPaths;
+        std::vector<ASN> seededPaths;
+
+        // Static data slots released by removed announcements in delta mode, reused by added announcements
+        std::vector<uint32_t> freeStaticDataIndices;
+
         LocalRibs localRibs;
 
+        // Workers for the parallel phases of propagation. Defaults to a single thread (everything runs inline)
+        std::unique_ptr<ThreadPool> threadPool;
+
+        /**
+         * Staging buffer for the peer phase. Holds a chunk of prefixes for every AS (AS major, chunk length per AS)
+         * Peer imports are evaluated into here against the untouched post-propagate-up local ribs, then committed in a second pass.
+         * Kept around between calls so propagation does not allocate after the first run.
+         */
+        std::vector<AnnouncementCachedData> peerStaging;
+
+        // Whether the local ribs are split into one NUMA placed prefix shard per thread, see SetNumaPlacement
+        bool numaPlacement;
+
+        // Peer staging buffer of every thread, for sharded propagation (each allocated, and thus first touched, by its own thread)
+        std::vector<std::vector<AnnouncementCachedData>> shardPeerStaging;
+
+        // Timings of the propagation since the last full Propagate() (see GetPropagationTimings), and of every shard while sharded
+        PropagationTimings propagationTimings;
+        std::vector<PropagationTimings> shardTimings;
+
+        // Hardware counter profiling, see SetProfiling. One set of counters per thread of the pool
+        bool profiling;
+        std::vector<std::unique_ptr<PerfCounters>> threadCounters;
+        PropagationProfile propagationProfile;
+        std::vector<PropagationProfile> shardProfiles;
+
+        // Kernel decision statistics of the last seeding and propagation, and of every shard while sharded (BGPX_STATISTICS builds)
+        PropagationStatisticsProfile statisticsProfile;
+        std::vector<PropagationStatisticsProfile> shardStatistics;
+
+        // Reverse index over the propagated ribs for the query methods, dropped whenever the ribs change (see BuildRouteIndex)
+        std::unique_ptr<RouteIndex> routeIndex;
+
+        // Empty graph, filled in by LoadCheckpoint
+        Graph();
+
+        /**
+         * Assigns the IDs and ranks and links up the relationships of the ASes, shared by the constructors
+         */
+        void BuildRelationships(std::vector<RelationshipInfo> &relationshipInfo);
+
+        /**
+         * Same as above, from the links of a raw CAIDA file without a row per AS
+         */
+        void BuildRelationships(const CAIDATopology &topology);
+
     public:
         /**
          * Constructs a graph from the given CAIDA relationship dataset.
@@ -139,10 +460,87 @@ class Graph {
          * NOTE: As of writing, stub removal will not work with origin-only seeding when a stub is also an origin
          * TODO: ^ fix that
          * 
-         * @param relationshipsCSV -> File path to the CAIDA Relationships tsv
+         * @param relationshipsCSV -> File path to the CAIDA Relationships tsv, or to a raw CAIDA as-rel/as-rel2 file (ranks and stubs computed here, see CAIDARelationships)
          * @param stubRemoval -> Whether to enable stub removal optimization
+         * @param numThreads -> Threads that rank the ASes of a raw CAIDA file, and the number of threads of the graph until SetNumThreads
+         */
+        Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval, const size_t numThreads = 1);
+
+        /**
+         * Same as above, for a relationships dataset that is already in memory (see BGPExtrapolatorC.h)
+         *
+         * @param relationshipInfo -> One entry per AS, in the order of the rows of a file. With stub removal, the stubs must already be left out
+         */
+        Graph(std::vector<RelationshipInfo> relationshipInfo, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval);
+
+        /**
+         * Sets the number of threads used by the parallel phases of propagation (currently the peer phase).
+         * The results do not depend on the number of threads.
+         *
+         * @param numThreads -> Number of threads, including the calling thread. 0 is treated as 1
+         */
+        void SetNumThreads(const size_t numThreads);
+
+        inline size_t GetNumThreads() const { return threadPool->GetNumThreads(); }
+
+        /**
+         * NUMA aware placement of the local ribs. The prefixes are split into one shard per thread, the threads are spread evenly
+         *  over the NUMA nodes and pinned to them, and the memory of each shard is bound to the node of its thread.
+         * Propagate() then runs the shards side by side, each thread propagating only the prefixes of its own shard (prefixes are
+         *  independent), so every thread only touches local rib memory. Results are the same as without it.
+         *
+         * Without libnuma (or on a single node machine) nothing is bound or pinned, but propagation is still sharded by prefix.
+         * Stays in effect when the number of threads changes.
+         *
+         * @param enabled -> Whether to use NUMA placement
+         */
+        void SetNumaPlacement(const bool enabled);
+
+        /**
+         * Profiling mode: hardware counters (cycles, instructions, LLC misses, branch misses, dTLB misses) are sampled around every
+         *  phase and every rank of propagation, along with the number of local rib cells compared and replaced. See GetPropagationProfile.
+         * The counters of every thread of the pool are added up. Sampling is per rank, so the cost is small but not zero.
+         * Stays in effect when the number of threads changes.
+         *
+         * @param enabled -> Whether to profile
+         * @return false if the hardware counters could not be opened on every thread (cells are still counted, missing counters read 0)
+         */
+        bool SetProfiling(const bool enabled);
+
+        inline bool IsProfiling() const { return profiling; }
+
+        /**
+         * Profile of the propagation since the last full Propagate(), empty unless profiling. Reset and added to like GetPropagationTimings
+         */
+        inline const PropagationProfile& GetPropagationProfile() const { return propagationProfile; }
+
+        /**
+         * Decisions of the seeding and propagation kernels since the last SeedBlock / full Propagate(), see PropagationStatistics.hpp.
+         * Only counted when built with BGPX_STATISTICS (DefaultStatistics::enabled), all zeros otherwise.
          */
-        Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval);
+        inline const PropagationStatisticsProfile& GetPropagationStatistics() const { return statisticsProfile; }
+
+        /**
+         * @return bytes of the local ribs resident on each NUMA node, indexed by node
+         */
+        inline std::vector<size_t> GetRibBytesPerNode() const { return localRibs.GetResidentBytesPerNode(); }
+
+        /**
+         * Moves the local ribs out of core: they are kept in a memory mapped scratch file rather than on the heap, split into
+         *  tiles of prefixes (prefix major). Propagation and result writing then work through one tile at a time, so only about
+         *  one tile has to be resident and the OS may write the rest back to the file.
+         * Results are the same as with in-memory local ribs. Best called before seeding, the existing local ribs are copied otherwise.
+         *
+         * @param backingFilePath -> Scratch file to map. It is unlinked right away, so nothing is left behind
+         * @param tileMemoryBytes -> Memory to use for one tile (all ASes). Determines the number of prefixes per tile (a power of 2, at least 1)
+         */
+        void SetRibBacking(const std::string &backingFilePath, const size_t tileMemoryBytes);
+
+        /**
+         * Whether the AS_PATH of seeded announcements should be kept for the lifetime of the graph.
+         * Must be enabled before seeding if the state is going to be saved and used for delta runs.
+         */
+        inline void SetRetainSeededPaths(const bool retain) { retainSeededPaths = retain; }
 
         /**
          * Resets all announcements to their default state. No memory is deallocated.
@@ -154,6 +552,13 @@ class Graph {
          */
         void ResetAllNonSeededAnnouncements();
 
+        /**
+         * Resets every announcement (seeded or not) of a single prefix block to the default state, across all ASes. No memory is deallocated
+         *
+         * @param prefixBlockID -> Column of the local ribs to reset
+         */
+        void ResetPrefixBlock(const uint32_t prefixBlockID);
+
         /**
          * Given a dataset of MRT announcements, and the method of seeding, this seeds the real-world data into the graph.
          * All announcements inserted during this stage will be marked as seeded. And will not be replaced during propagation.
@@ -162,6 +567,9 @@ class Graph {
          * NOTE: This will allocate the local ribs. Be aware of how large the dataset is and how much RAM it will use
          * *********
          * 
+         * Anything seeded or propagated before is discarded, so a graph can be seeded again for the next experiment (an in memory local rib
+         *  allocation that is big enough is reused).
+         * 
          * Special Cases:
          *  - If an AS on the path does not exist in the graph (the CAIDA relationships), then that AS is skipped (while preserving path length).
          *    This missing AS will thus not show up during traceback or the final results. Such improvement may be left in a future paper.
@@ -175,15 +583,115 @@ class Graph {
          */
         void SeedBlock(const std::string& filePathAnnouncements, const SeedingConfiguration& config);
 
+        /**
+         * Same as above, seeding the announcements once for every lane (configuration), so that a single Propagate evaluates all of them.
+         * Lanes are interleaved: lane k of prefix block b is prefix block b * (number of lanes) + k, as seen by Traceback and GetCachedData.
+         * Lanes may differ in every seeding option and in their provider preferences. The local ribs are as big as for one run per lane,
+         *  but the topology, import policies and static data are walked and read once for all of them.
+         * Not for checkpoints, delta mode or scenarios, which work with a single lane.
+         *
+         * @param filePathAnnouncements -> File path to the mrt announcements tsv
+         * @param lanes -> Configuration of every lane
+         */
+        void SeedBlock(const std::string& filePathAnnouncements, const std::vector<LaneConfiguration>& lanes);
+
+        /**
+         * Same as the above, for announcements that have already been parsed (see BlockPipeline.hpp). The local ribs are sized for the given
+         *  number of prefix blocks (times the number of lanes) rather than one per row, so the block IDs of the announcements must be below it.
+         *
+         * @param announcements -> Announcements to seed, in the order of the rows of a file
+         * @param numPrefixBlocks -> One past the highest prefix block ID of the announcements
+         * @param config -> Configuration for how announcements ought to be seeded and tiebroken in the graph
+         */
+        void SeedBlock(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const SeedingConfiguration& config);
+        void SeedBlock(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const std::vector<LaneConfiguration>& lanes);
+
+        /**
+         * Exchanges the local ribs and static data of the graph with the given ones, nothing is copied. After propagation, this hands the
+         *  propagated blocks over to be written while the graph goes on seeding into the buffer it got back (reset by the next SeedBlock).
+         * Only for local ribs in memory: a file backed or NUMA placed arena would move along with the blocks.
+         *
+         * @param blocks -> Blocks to exchange with, an empty one is given the number of ASes of the graph
+         */
+        void SwapPropagatedBlocks(PropagatedBlocks &blocks);
+
+        inline size_t GetNumLanes() const { return numLanes; }
+
+        /**
+         * @return the first prefix block at or after the given one that belongs to the given lane
+         */
+        inline uint32_t GetLaneBegin(const uint32_t prefixBegin, const size_t lane) const {
+            return prefixBegin + (lane + numLanes - prefixBegin % numLanes) % numLanes;
+        }
+
+        /**
+         * Whether the provider preferences of the customer differ between lanes, so that its imports have to be decided lane by lane
+         */
+        inline bool IsLaneDependentCustomer(const ASN customer_asn) const {
+            return !laneDependentCustomers.empty() && laneDependentCustomers.count(customer_asn) > 0;
+        }
+
+        /**
+         * Applies a diff of the MRT announcements to a graph that already holds a seeded and propagated state (usually from LoadCheckpoint).
+         * Only the prefix blocks mentioned in the diff are reset, re-seeded and re-propagated. Every other prefix block is left untouched,
+         *  so the cost scales with the churn rather than the size of the table.
+         *
+         * The diff file has the same columns as the announcements file, plus a "change" column of "added", "removed" or "changed".
+         * An announcement is identified by its prefix_block_id and the first ASN of its AS_PATH (the vantage point).
+         *  - removed: the announcement with that identity is dropped
+         *  - changed: the announcement with that identity is replaced by the row
+         *  - added: the row is added as a new announcement, none may have that identity yet
+         * The diff is refused (nothing is changed) if an affected block has two announcements with the same identity, or a row does not match as above.
+         * The unchanged announcements of an affected block are re-seeded from the retained seeded paths, so seeded paths must have been retained.
+         *
+         * @param filePathDiff -> File path to the announcements diff tsv
+         * @param config -> Configuration for how announcements ought to be seeded and tiebroken in the graph
+         * @return true if the diff was applied, false if it could not be (reason printed)
+         */
+        bool ApplyAnnouncementsDelta(const std::string& filePathDiff, const SeedingConfiguration& config);
+
+        /**
+         * Writes the complete state of the graph to a single checkpoint file: the ID maps, the relationships and ranks,
+         *  the static announcement data (with any retained seeded paths) and the local ribs.
+         * May be called after seeding or after propagation. The rib arena is page aligned in the file, so it can be used in place once mapped.
+         *
+         * @param filePath -> File to create (overwritten if it exists)
+         * @return true on success
+         */
+        bool WriteCheckpoint(const std::string& filePath) const;
+
+        /**
+         * Restores a graph from a checkpoint written by WriteCheckpoint. No relationships or announcements file is needed.
+         * The file is memory mapped and the local ribs are used directly from the mapping (privately, the file is never modified),
+         *  so only the pages that are actually read get loaded. Traceback and result generation can run right away.
+         *
+         * @param filePath -> File written by WriteCheckpoint
+         * @return the graph, or nullptr if the file could not be loaded (reason printed)
+         */
+        static std::unique_ptr<Graph> LoadCheckpoint(const std::string& filePath);
+
         /**
          * Using Gao Rexford rules, this will propagate the announcements throughout the graph. 
          * The propagation policies will be used to determine how an AS will compare incoming announcements with the accepted announcement already in the local rib.
          * The propagated copy of a seeded announcement will not be marked as seeded. An incoming announcement cannot replace a seeded announcement (since that is the known truth).
          * 
+         * Peer announcements are all evaluated against the state of the graph after propagating up (a snapshot), so an AS never
+         * sees a route its peer learned from another peer in the same phase. This makes the result independent of the order
+         * ASes are visited in, and lets the peer phase run in parallel across ASes.
+         *
          * This will not seed the announcements. Be sure to seed announcements before calling this.
          */
         void Propagate();
 
+        /**
+         * Same as Propagate(), but only the prefix block IDs in [prefixBegin, prefixEnd) are touched.
+         * Prefixes are independent of each other during propagation, so propagating a range gives the same result for that range as a full propagation.
+         *
+         * @param prefixBegin -> First prefix block ID to propagate
+         * @param prefixEnd -> One past the last prefix block ID to propagate
+         */
+        void Propagate(const uint32_t prefixBegin, const uint32_t prefixEnd);
+
         /**
          * Given a starting ASN and a prefixID, this will traceback the AS_PATH of that announcement.
          * The returned AS_PATH will have the origin at the end of the list, and the starting ASN will be at the beginning
@@ -197,6 +705,72 @@ class Graph {
          */
         void Traceback(std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const;
 
+        /**
+         * Same as above, but follows the local ribs as seen through the given view (the graph itself or a RibOverlay on top of it)
+         */
+        template <typename RibView>
+        void Traceback(const RibView &view, std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const;
+
+        //***** Queries over the propagated ribs
+
+        /**
+         * Indexes the local ribs as they are now by origin and next hop (see RouteIndex), using the threads of the graph.
+         * Call after Propagate: seeding, propagating, resetting or swapping the ribs drops the index.
+         */
+        void BuildRouteIndex();
+
+        inline bool HasRouteIndex() const { return routeIndex != nullptr; }
+
+        /**
+         * @return the index, nullptr if there is none
+         */
+        inline const RouteIndex* GetRouteIndex() const { return routeIndex.get(); }
+
+        /**
+         * @param prefixString -> Prefix as written in the announcements file
+         * @param lane -> Lane (configuration) to find the blocks of, 0 without lanes
+         * @return the prefix blocks of the prefix in that lane, as taken by the queries (needs the index)
+         */
+        std::vector<uint32_t> FindPrefixBlocks(const std::string &prefixString, const size_t lane) const;
+
+        /**
+         * The route an AS uses for a prefix block, read from the local ribs (no index needed). Removed stubs get the route of their provider.
+         *
+         * @param route -> Filled with the route, the same as the results row of the AS
+         * @return false if the AS is not in the graph or has no route for the prefix block
+         */
+        bool QueryRoute(const ASN asn, const uint32_t prefixBlockID, QueriedRoute &route) const;
+
+        /**
+         * @param asns -> Filled with the ASes (removed stubs included) whose route for the prefix block comes from the origin, sorted
+         * @return false if there is no index
+         */
+        bool QueryASesByOrigin(const uint32_t prefixBlockID, const ASN originASN, std::vector<ASN> &asns) const;
+
+        /**
+         * @param asns -> Filled with the ASes (removed stubs included) that use the next hop for the prefix block, sorted
+         * @return false if there is no index
+         */
+        bool QueryASesByNextHop(const uint32_t prefixBlockID, const ASN nextHopASN, std::vector<ASN> &asns) const;
+
+        /**
+         * What-if scenario: seeds extra announcements on top of this (already seeded and propagated) graph and propagates them,
+         *  without modifying this graph. Only the prefix columns the extra announcements are for get copied into the overlay,
+         *  every other prefix is shared with this graph.
+         *
+         * For every affected prefix, the copied column is brought back to its seeded state (propagated announcements are dropped,
+         *  seeded ones are kept), the scenario announcements are seeded on top of it as if they came last in the announcements file,
+         *  and the column is propagated again. The result matches a full seed and propagation with the extra announcements appended.
+         *
+         * This is const and only writes to the overlay, so many scenarios can run at once against the same graph (one overlay per thread).
+         * The overlay keeps any columns from previous scenarios, Clear() it to start a new independent scenario.
+         *
+         * @param overlay -> Overlay on top of this graph that receives the result
+         * @param announcements -> Extra announcements to seed (attacker announcements, leaks, ...)
+         * @param config -> Configuration for how the announcements ought to be seeded and tiebroken
+         */
+        void RunScenario(RibOverlay &overlay, const std::vector<ScenarioAnnouncement> &announcements, const SeedingConfiguration &config) const;
+
         /**
          * Write the trace of every prefix in the provided ASes to a CSV file
          * **WARNING** If no ASNs are specified, all local ribs are dumped to the file. 
@@ -206,17 +780,69 @@ class Graph {
          * 
          * @param resultsFilePath -> Path to the results file
          * @param localRibsToDump -> ASNs of ASes to trace the route for all prefixes in the local rib
+         * @param bytesWritten -> Set to the number of bytes written
+         * @param filter -> Rows to write among those of the dumped ASes, every one by default
+         * @return false if the file could not be opened or written (reason printed)
          */
-        void GenerateTracebackResultsCSV(const std::string& resultsFilePath, std::vector<ASN> localRibsToDump);
+        bool GenerateTracebackResultsCSV(const std::string& resultsFilePath, std::vector<ASN> localRibsToDump, size_t &bytesWritten, const ResultsFilter &filter = ResultsFilter());
+
+        /**
+         * Same as above, writing the prefix blocks to several files in one pass over the local ribs: prefix block b goes to the file b % (number of files).
+         * With one file per lane, every lane gets the results file it would have had on its own.
+         *
+         * @param resultsFilePaths -> Path to every results file
+         * @param localRibsToDump -> ASNs of ASes to trace the route for all prefixes in the local rib
+         * @param bytesWritten -> Set to the number of bytes written to every file
+         * @param filter -> Rows to write among those of the dumped ASes, every one by default
+         * @return false if a file could not be opened or written (reason printed)
+         */
+        bool GenerateTracebackResultsCSV(const std::vector<std::string>& resultsFilePaths, std::vector<ASN> localRibsToDump, std::vector<size_t> &bytesWritten,
+            const ResultsFilter &filter = ResultsFilter());
+
+        /**
+         * Statistics over the propagated routes instead of the routes themselves (see RibAggregates), for runs that do not need every AS path.
+         * One pass over the local ribs, tile by tile, with the prefix blocks split over the threads of the graph. No AS path is expanded:
+         *  path lengths and transit come from the received from forest of every prefix block, resolved once per AS.
+         *
+         * @param localRibsToDump -> ASNs of the ASes to count the routes of, as for the results (empty: every AS)
+         * @param outputs -> AGGREGATE_OUTPUT flags of the aggregates to compute, the others are left empty
+         * @return the aggregates of every lane
+         */
+        std::vector<RibAggregates> ComputeRibAggregates(const std::vector<ASN> &localRibsToDump, const unsigned outputs);
+
+        /**
+         * Same as above, appending the results of blocks taken out of the graph (see SwapPropagatedBlocks) to files that are already open.
+         * Only reads the topology of the graph, so it can run while the graph propagates other blocks.
+         *
+         * @param blocks -> Propagated blocks, seeded with the number of lanes the graph has now
+         * @param files -> Results files to append to, prefix block b goes to the file b % (number of files)
+         * @param localRibsToDump -> ASNs of ASes to trace the route for all prefixes in the local rib
+         * @param writeHeader -> Whether to start every file with the header row
+         * @param filter -> Rows to write among those of the dumped ASes, every one by default
+         * @return the number of bytes written to every file
+         */
+        std::vector<size_t> AppendTracebackResults(const PropagatedBlocks &blocks, const std::vector<FILE*> &files, const std::vector<ASN> &localRibsToDump, const bool writeHeader,
+            const ResultsFilter &filter = ResultsFilter()) const;
 
         // **** Getters **** //
 
-        inline bool IsStub(const ASN asn) const { return stubASNToProviderID.find(asn) != stubASNToProviderID.end(); }
-        inline ASN_ID GetProviderIDOfStubASN(const ASN stubASN) const { return stubASNToProviderID.at(stubASN); }
+        inline bool IsStub(const ASN asn) const { return asnTable.FindStubProviderID(asn) != ASNTable::NONE; }
+        inline size_t GetNumStubs() const { return asnTable.GetStubs().size(); }
+        inline ASN_ID GetProviderIDOfStubASN(const ASN stubASN) const {
+            const ASN_ID providerID = asnTable.FindStubProviderID(stubASN);
+            if (providerID == ASNTable::NONE)
+                throw std::out_of_range("Not a stub: " + std::to_string(stubASN));
+            return providerID;
+        }
 
-        inline bool ContainsASN(const ASN asn) const { return asnToID.find(asn) != asnToID.end(); }
+        inline bool ContainsASN(const ASN asn) const { ASN_ID id; return asnTable.FindID(asn, id); }
         inline ASN GetASN(const ASN_ID id) const { return idToASN[id]; }
-        inline ASN_ID GetASNID(const ASN asn) const { return asnToID.at(asn); }
+        inline ASN_ID GetASNID(const ASN asn) const {
+            ASN_ID id;
+            if (!asnTable.FindID(asn, id))
+                throw std::out_of_range("Not in the graph: " + std::to_string(asn));
+            return id;
+        }
 
         inline AnnouncementCachedData& GetCachedData(const ASN_ID& asnID, const uint32_t& prefixBlockID) {
             return localRibs.GetAnnouncement(asnID, prefixBlockID);
@@ -232,12 +858,15 @@ class Graph {
          *
          * @param provider_asn -> ASN of the provider to propogate up to
          * @param customer_asn -> ASN of the customer
+         * @param lane -> Lane whose preferences to follow, see SeedBlock with lanes
          * @return true if the customer should propogate up, false if it should not
          */
-        inline bool IsPrefferedProvider(const ASN provider_asn, const ASN customer_asn) const {
+        inline bool IsPrefferedProvider(const ASN provider_asn, const ASN customer_asn, const size_t lane = 0) const {
+            const std::unordered_map<ASN, std::vector<ASN>> &preferences = laneProviderPreferences.empty() ? customerToProviderPreferences : laneProviderPreferences[lane];
+
             // Check if the customer is unrestricted
-            auto search = customerToProviderPreferences.find(customer_asn);
-            if (search == customerToProviderPreferences.end())
+            auto search = preferences.find(customer_asn);
+            if (search == preferences.end())
                 return true;
 
             // There is some kind of preference, see if this provider is on the list
@@ -270,10 +899,127 @@ class Graph {
             return *idToImportPolicy[asnID];
         }
 
+        inline size_t GetNumStaticData() const { return announcementStaticData.size(); }
+
+        /**
+         * Time spent in each phase and rank of propagation. Reset by every full Propagate(), added to by Propagate(prefixBegin, prefixEnd)
+         */
+        inline const PropagationTimings& GetPropagationTimings() const { return propagationTimings; }
+
+        /**
+         * Approximate bytes allocated by each of the main structures of the graph, by name
+         */
+        std::vector<std::pair<std::string, size_t>> GetMemoryUsage() const;
+
+        /**
+         * The local rib cells of an AS are contiguous within a tile of prefix blocks (see LocalRibs), so a run of them can be read in place
+         *
+         * @param count -> Set to the number of cells from the returned one on that belong to the same AS (up to the end of the tile)
+         * @return the cell of the AS for the prefix block
+         */
+        inline const AnnouncementCachedData* GetRibRow(const ASN_ID asnID, const uint32_t prefixBlockID, size_t &count) const {
+            const size_t tileLength = localRibs.GetTileLength();
+            count = std::min(tileLength - prefixBlockID % tileLength, GetNumPrefixes() - prefixBlockID);
+            return &localRibs.GetAnnouncement_ReadOnly(asnID, prefixBlockID);
+        }
+
         inline size_t GetNumASes() const { return localRibs.GetNumASes(); }
         inline size_t GetNumPrefixes() const { return localRibs.GetNumPrefixes(); }
 
     protected:
+        /**
+         * Spreads the threads over the NUMA nodes, pins them and binds one shard of the local ribs per thread to its node
+         */
+        void ApplyNumaPlacement();
+
+        /**
+         * Propagates every shard of the local ribs on its own thread, see SetNumaPlacement
+         */
+        void PropagateShards();
+
+        // Clears the propagation statistics, keeping those of the seeding
+        void ResetPropagationStatistics();
+
+        /**
+         * Same as Propagate(prefixBegin, prefixEnd), with the peer phase run on the given pool (inline if null) and staging buffer.
+         * Timings are added to the given timings, kernel statistics to the given statistics,
+         *  and when profiling, the profile to the given profile using the given counters
+         */
+        void PropagateRange(const uint32_t prefixBegin, const uint32_t prefixEnd, ThreadPool *pool, std::vector<AnnouncementCachedData> &staging, const size_t stagingBudgetBytes, PropagationTimings &timings,
+            PropagationStatisticsProfile &statistics, PropagationProfile *profile, const PerfCounters *counters);
+
+        /**
+         * @param counters -> Counters of one thread, or null for the sum over every thread of the pool
+         */
+        PerfCounterValues ReadCounters(const PerfCounters *counters) const;
+
+        /**
+         * Every AS imports the announcements of its peers. All imports of the phase are first staged against the post-propagate-up
+         *  local ribs, then committed. Both passes are spread across the thread pool by AS.
+         *
+         * The staging buffer is bounded, so the prefixes are processed in chunks that fit in it.
+         *
+         * @param prefixBegin -> First prefix block ID to propagate
+         * @param prefixEnd -> One past the last prefix block ID to propagate
+         * @param pool -> Threads to spread the passes over, null to run them on the calling thread
+         * @param stagingBuffer -> Staging buffer, grown as needed
+         * @param stagingBudgetBytes -> Upper bound on the size of the staging buffer (at least one prefix per AS is always staged)
+         * @return the number of announcements replaced
+         */
+        uint64_t PropagatePeers(const uint32_t prefixBegin, const uint32_t prefixEnd, ThreadPool *pool, std::vector<AnnouncementCachedData> &stagingBuffer, const size_t stagingBudgetBytes);
+
+        /**
+         * Sizes the local ribs for the announcements file, with one prefix block per row and lane, and seeds every row once per lane
+         *
+         * @param filePathAnnouncements -> File path to the mrt announcements tsv
+         * @param configs -> Seeding configuration of every lane
+         */
+        void SeedLanes(const std::string& filePathAnnouncements, const std::vector<SeedingConfiguration>& configs);
+
+        /**
+         * Same as SeedLanes, for announcements that have already been parsed
+         */
+        void SeedLanes(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const std::vector<SeedingConfiguration>& configs);
+
+        /**
+         * Discards everything seeded before and sizes the static data and the local ribs for the next seeding
+         *
+         * @param numRows -> Number of announcements (static data entries)
+         * @param numPrefixBlocks -> Prefix blocks of a single lane
+         * @param lanes -> Number of lanes
+         */
+        void PrepareSeeding(const size_t numRows, const size_t numPrefixBlocks, const size_t lanes);
+
+        /**
+         * Seeds one announcement (row) once for every lane, see SeedBlock
+         */
+        void SeedRow(const std::vector<ASN>& asPath, size_t staticDataIndex, const Prefix& prefix, const std::string& prefixString, int64_t timestamp, const std::vector<SeedingConfiguration>& configs);
+
+        /**
+         * Resolves the ASes to dump results of to the ID to trace back from, and the stub ASN when it is a removed stub (-1 otherwise)
+         *
+         * @param localRibsToDump -> ASNs to dump, every AS (and stub) if empty
+         */
+        void ResolveDumpIDs(const std::vector<ASN> &localRibsToDump, std::vector<ASN_ID> &dumpIDs, std::vector<int64_t> &dumpStubASNs) const;
+
+        /**
+         * Writes the results rows of a range of prefix blocks, reading the local ribs and static data through the given view
+         *  (the graph itself or propagated blocks taken out of it)
+         *
+         * A few prefix blocks at a time: the paths of a block are formatted once along its received from forest and shared
+         *  with every AS below (see TracebackForest in Graph.cpp), so the cost follows the size of the output rather than output size times path length.
+         * Rows come out grouped by those blocks rather than AS by AS.
+         * Rows the filter leaves out are skipped before their path is resolved.
+         */
+        template <typename RibView>
+        void WriteTracebackResults(const RibView &view, const uint32_t prefixBegin, const uint32_t prefixEnd, const std::vector<ASN_ID> &dumpIDs,
+            const std::vector<int64_t> &dumpStubASNs, const ResultsFilter &filter, std::vector<std::unique_ptr<FileBuffer>> &fileBuffers) const;
+
+        /**
+         * Uses the provider preferences of the given lanes (laneProviderPreferences and laneDependentCustomers), none for a single lane
+         */
+        void SetLaneProviderPreferences(const std::vector<LaneConfiguration>& lanes);
+
         /**
          * For a given AS_PATH and index to fill static data (corresponding to the static announcement data list of the graph), 
          *  seed the announcement information along the path with the given behavior configuration
@@ -286,4 +1032,12 @@ class Graph {
          * @param config 
          */
         void SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, const Prefix& prefix, const std::string& prefixString, int64_t timestamp, const SeedingConfiguration& config);
+
+        /**
+         * The seeding logic of SeedPath, writing through the given view (the graph itself or a RibOverlay on top of it)
+         * The topology is read from this graph, the static data and local ribs are read and written through the view.
+         * Decisions are counted by the statistics policy (see PropagationStatistics.hpp).
+         */
+        template <typename RibView, typename Statistics = DefaultStatistics>
+        void SeedPath(RibView &view, const std::vector<ASN>& asPath, size_t staticDataIndex, const Prefix& prefix, const std::string& prefixString, int64_t timestamp, const SeedingConfiguration& config) const;
 };
@@ -1,52 +1,365 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <algorithm>
+#include <iostream>
 
 #include "Announcement.hpp"
+#include "MappedFile.hpp"
+#include "NumaTopology.hpp"
 
+// With NUMA placement, each shard of prefixes is split into about this many tiles, which keeps the shards balanced
+#define NUMA_TILES_PER_SHARD 8
+
+/**
+ * The local ribs of every AS, in one contiguous arena.
+ *
+ * The prefixes are split into tiles. Within a tile the layout is AS major: the announcements of an AS for every prefix of
+ *  the tile are next to each other. Tiles follow each other (prefix major), so everything about one tile is one contiguous range.
+ *  index = tile * (numASes * tileLength) + asnID * tileLength + prefix within the tile
+ *
+ * By default there is a single tile holding every prefix, which is plain AS major (index = asnID * numPrefixes + prefixBlockID).
+ * Smaller tiles (a power of 2 prefixes) are used with file backing, where propagation works through one tile at a time so
+ *  only one tile needs to be in memory, and with NUMA placement.
+ *
+ * NUMA placement: the tiles are split into one shard (contiguous range of tiles) per worker thread, and the memory of each shard is
+ *  bound to the node of its thread before anything touches it. The thread that propagates a shard then only touches local memory.
+ *
+ * The arena is either:
+ *  - owned (heap)
+ *  - a shared mapping of a scratch file (file backing), so the OS can page it out when it does not fit in memory
+ *  - inside a mapped checkpoint being restored (private, writing to it never modifies the file)
+ */
 class LocalRibs {
 private:
-    std::vector<std::vector<AnnouncementCachedData>> localRibs;
+    std::vector<AnnouncementCachedData> arena;
+
+    // Start of the arena, either arena.data() or somewhere in the mapping
+    AnnouncementCachedData *data;
+    std::shared_ptr<MappedFile> mapping;
+
+    // Scratch file for file backing, empty when the arena is in memory
+    std::string backingFilePath;
+
     size_t numAses;
     size_t numPrefixes;
 
+    // Requested prefixes per tile (power of 2), 0 for a single tile
+    size_t requestedTileLength;
+
+    // NUMA node of every shard, empty without NUMA placement
+    std::vector<int> shardNodes;
+
+    // ***** Layout, see the class description
+    size_t tileLength;
+    uint32_t tileShift;
+    uint64_t tileMask;
+    uint64_t tileStride;
+
+    inline size_t Index(const ASN_ID &asnID, const uint32_t &prefixBlockID) const {
+        return (((uint64_t) prefixBlockID) >> tileShift) * tileStride + ((uint64_t) asnID) * tileLength + (prefixBlockID & tileMask);
+    }
+
+    /**
+     * Tile length for NUMA placement when the tiles are not already sized by file backing
+     */
+    inline size_t GetShardedTileLength(const size_t prefixes) const {
+        size_t target = prefixes / (shardNodes.size() * NUMA_TILES_PER_SHARD);
+        size_t powerOfTwo = 1;
+        while (powerOfTwo * 2 <= target)
+            powerOfTwo *= 2;
+
+        return powerOfTwo;
+    }
+
+    /**
+     * Binds the memory of every shard to its node. Must be done before the arena is touched
+     */
+    void BindShards() {
+        if (shardNodes.empty() || !mapping || tileStride == 0)
+            return;
+
+        for (size_t shard = 0; shard < shardNodes.size(); shard++) {
+            size_t beginTile, endTile;
+            GetShardTiles(shard, beginTile, endTile);
+
+            NumaTopology::BindRange(mapping->GetData(), beginTile * tileStride * sizeof(AnnouncementCachedData),
+                endTile * tileStride * sizeof(AnnouncementCachedData), shardNodes[shard]);
+        }
+    }
+
+    inline void GetShardTiles(const size_t shard, size_t &beginTile, size_t &endTile) const {
+        beginTile = (GetNumTiles() * shard) / shardNodes.size();
+        endTile = (GetNumTiles() * (shard + 1)) / shardNodes.size();
+    }
+
+    /**
+     * Changes the dimensions and/or tiling of the arena, keeping the announcements that are in both the old and new dimensions.
+     * New announcements are in the default state. A mapped checkpoint arena becomes an owned one.
+     */
+    void Relayout(const size_t newNumASes, const size_t newNumPrefixes, const bool force = false) {
+        if (!force && newNumASes == numAses && newNumPrefixes == numPrefixes)
+            return;
+
+        LocalRibs next;
+        next.backingFilePath = backingFilePath;
+        next.requestedTileLength = requestedTileLength;
+        next.shardNodes = shardNodes;
+        next.Allocate(newNumASes, newNumPrefixes);
+
+        size_t keptASes = std::min(numAses, newNumASes);
+        size_t keptPrefixes = std::min(numPrefixes, newNumPrefixes);
+        for (ASN_ID i = 0; i < keptASes; i++)
+            for (uint32_t j = 0; j < keptPrefixes; j++)
+                next.GetAnnouncement(i, j) = GetAnnouncement_ReadOnly(i, j);
+
+        Swap(next);
+    }
+
+    /**
+     * Sets up the layout and fresh (default state) storage for the given dimensions
+     */
+    void Allocate(const size_t newNumASes, const size_t newNumPrefixes) {
+        numAses = newNumASes;
+        numPrefixes = newNumPrefixes;
+
+        size_t length = requestedTileLength;
+        if (length == 0 && !shardNodes.empty())
+            length = GetShardedTileLength(numPrefixes);
+
+        if (length == 0) {
+            tileLength = numPrefixes;
+            tileShift = 32;
+            tileMask = 0xFFFFFFFF;
+            tileStride = 0;
+        } else {
+            tileLength = length;
+            tileShift = 0;
+            while (((size_t) 1 << tileShift) < tileLength)
+                tileShift++;
+            tileMask = tileLength - 1;
+            tileStride = numAses * tileLength;
+        }
+
+        size_t arenaSize = numAses * tileLength * GetNumTiles();
+
+        mapping.reset();
+
+        if (!backingFilePath.empty() && arenaSize > 0) {
+            std::vector<AnnouncementCachedData>().swap(arena);
+
+            // A fresh file is all zeros, which is the default state of an announcement
+            mapping.reset(new MappedFile());
+            if (mapping->Create(backingFilePath, arenaSize * sizeof(AnnouncementCachedData))) {
+                data = (AnnouncementCachedData*) mapping->GetData();
+                BindShards();
+                return;
+            }
+
+            std::cout << "Could not create the local rib backing file " << backingFilePath << ", keeping the local ribs in memory" << std::endl;
+            mapping.reset();
+            backingFilePath.clear();
+        }
+
+        if (!shardNodes.empty() && arenaSize > 0) {
+            std::vector<AnnouncementCachedData>().swap(arena);
+
+            // Untouched zero filled memory, so the binding decides where every page goes
+            mapping.reset(new MappedFile());
+            if (mapping->CreateAnonymous(arenaSize * sizeof(AnnouncementCachedData))) {
+                data = (AnnouncementCachedData*) mapping->GetData();
+                BindShards();
+                return;
+            }
+
+            mapping.reset();
+        }
+
+        // Reuses the capacity of an arena this one had before (see Reshape)
+        arena.assign(arenaSize, AnnouncementCachedData());
+        data = arena.data();
+    }
+
 public:
-    LocalRibs() : numAses(0), numPrefixes(0) {
+    LocalRibs() : data(nullptr), numAses(0), numPrefixes(0), requestedTileLength(0), tileLength(0), tileShift(32), tileMask(0xFFFFFFFF), tileStride(0) {
     }
 
     inline AnnouncementCachedData& GetAnnouncement(const ASN_ID &asnID, const uint32_t &prefixBlockID) {
-        return localRibs[asnID][prefixBlockID];
+        return data[Index(asnID, prefixBlockID)];
     }
 
     /**
      * Returns a const reference to an announcement that cannot be modified
      */
     inline const AnnouncementCachedData& GetAnnouncement_ReadOnly(const ASN_ID &asnID, const uint32_t &prefixBlockID) const {
-        return localRibs[asnID][prefixBlockID];
+        return data[Index(asnID, prefixBlockID)];
+    }
+
+    /**
+     * Exchanges the arenas (and their layout and backing) of two local ribs, nothing is copied
+     */
+    void Swap(LocalRibs &other) {
+        arena.swap(other.arena);
+        std::swap(data, other.data);
+        mapping.swap(other.mapping);
+        backingFilePath.swap(other.backingFilePath);
+        std::swap(numAses, other.numAses);
+        std::swap(numPrefixes, other.numPrefixes);
+        std::swap(requestedTileLength, other.requestedTileLength);
+        shardNodes.swap(other.shardNodes);
+        std::swap(tileLength, other.tileLength);
+        std::swap(tileShift, other.tileShift);
+        std::swap(tileMask, other.tileMask);
+        std::swap(tileStride, other.tileStride);
     }
 
     inline size_t GetNumASes() const { return numAses; }
-    
-    inline void SetNumASes(size_t numASes) {
-        this->numAses = numASes;
-        
-        size_t oldLength = localRibs.size();
-        localRibs.resize(numASes);
 
-        if (numAses > oldLength) {
-            for (size_t i = oldLength; i < numASes; i++) {
-                localRibs[i].resize(numPrefixes);
-            }
-        }
+    inline void SetNumASes(size_t numASes) {
+        Relayout(numASes, numPrefixes);
     }
-    
+
     inline size_t GetNumPrefixes() const { return numPrefixes; }
 
     inline void SetNumPrefixes(size_t numPrefixes) {
-        this->numPrefixes = numPrefixes;
+        Relayout(numAses, numPrefixes);
+    }
 
-        for (auto &rib : localRibs) {
-            rib.resize(numPrefixes);
+    /**
+     * Changes the number of prefixes and sets every announcement to the default state. Unlike SetNumPrefixes nothing is copied over,
+     *  and an in memory arena keeps its allocation when it is already big enough.
+     */
+    void Reshape(size_t numPrefixes) {
+        if (numPrefixes == this->numPrefixes) {
+            ResetAll();
+            return;
         }
+
+        Allocate(numAses, numPrefixes);
+    }
+
+    /**
+     * Puts the arena in a scratch file mapping, split into tiles of the given number of prefixes.
+     * The existing announcements are kept.
+     *
+     * @param filePath -> Scratch file for the arena (created, and removed once no longer mapped)
+     * @param prefixesPerTile -> Rounded down to a power of 2 (at least 1)
+     */
+    void UseFileBacking(const std::string &filePath, size_t prefixesPerTile) {
+        size_t powerOfTwo = 1;
+        while (powerOfTwo * 2 <= prefixesPerTile)
+            powerOfTwo *= 2;
+
+        backingFilePath = filePath;
+        requestedTileLength = powerOfTwo;
+        Relayout(numAses, numPrefixes, true);
+    }
+
+    inline bool IsFileBacked() const { return !backingFilePath.empty(); }
+
+    /**
+     * Splits the prefixes into one shard per entry and binds the memory of each shard to the given node.
+     * The existing announcements are kept. An empty list turns NUMA placement off.
+     *
+     * @param nodes -> NUMA node of every shard
+     */
+    void SetShardNodes(const std::vector<int> &nodes) {
+        shardNodes = nodes;
+        Relayout(numAses, numPrefixes, true);
+    }
+
+    inline size_t GetNumShards() const { return shardNodes.size(); }
+
+    /**
+     * Prefix block IDs [prefixBegin, prefixEnd) of a shard. Shards are whole tiles, so a tile is never shared by two shards
+     */
+    inline void GetShardPrefixRange(const size_t shard, uint32_t &prefixBegin, uint32_t &prefixEnd) const {
+        size_t beginTile, endTile;
+        GetShardTiles(shard, beginTile, endTile);
+
+        prefixBegin = std::min(beginTile * tileLength, numPrefixes);
+        prefixEnd = std::min(endTile * tileLength, numPrefixes);
+    }
+
+    /**
+     * @return bytes of the arena resident on every NUMA node, indexed by node
+     */
+    inline std::vector<size_t> GetResidentBytesPerNode() const {
+        if (!mapping)
+            return std::vector<size_t>(1, GetArenaSize() * sizeof(AnnouncementCachedData));
+
+        return NumaTopology::GetResidentBytesPerNode((char*) data, GetArenaSize() * sizeof(AnnouncementCachedData));
+    }
+
+    /**
+     * Sets every announcement to the default state. A mapped arena (file backed or NUMA placed) is zeroed without dirtying its pages
+     */
+    void ResetAll() {
+        if ((IsFileBacked() || !shardNodes.empty()) && mapping && mapping->Zero())
+            return;
+
+        std::fill(data, data + GetArenaSize(), AnnouncementCachedData());
+    }
+
+    // ***** Tiles
+
+    /**
+     * Number of prefixes in every tile (the last tile may be partially used). Equal to the number of prefixes when there is a single tile
+     */
+    inline size_t GetTileLength() const { return tileLength; }
+    inline size_t GetNumTiles() const { return tileStride == 0 ? 1 : (numPrefixes + tileLength - 1) / tileLength; }
+
+    /**
+     * Hints to the OS that the tile starting at the given prefix is about to be used (read ahead from the backing file)
+     */
+    inline void PrefetchTile(const uint32_t tileBeginPrefix) {
+        if (IsFileBacked() && tileBeginPrefix < numPrefixes)
+            mapping->WillNeed(Index(0, tileBeginPrefix) * sizeof(AnnouncementCachedData), tileStride * sizeof(AnnouncementCachedData));
+    }
+
+    /**
+     * Tells the OS the tile starting at the given prefix is done with for now, so it can be written back and dropped from memory
+     */
+    inline void ReleaseTile(const uint32_t tileBeginPrefix) {
+        if (IsFileBacked() && tileBeginPrefix < numPrefixes)
+            mapping->Release(Index(0, tileBeginPrefix) * sizeof(AnnouncementCachedData), tileStride * sizeof(AnnouncementCachedData));
+    }
+
+    // ***** Raw arena
+
+    /**
+     * Whether the arena is plain AS major (a single tile)
+     */
+    inline bool IsASMajor() const { return tileStride == 0; }
+
+    /**
+     * The whole arena, in the tiled layout described above
+     */
+    inline const AnnouncementCachedData* GetArena() const { return data; }
+    inline size_t GetArenaSize() const { return numAses * tileLength * GetNumTiles(); }
+
+    /**
+     * Uses an arena that lives inside a mapped file rather than allocating one.
+     * The mapping is kept alive for as long as the arena is in use.
+     *
+     * @param mapping -> The mapped file
+     * @param mappedArena -> Start of the arena in the mapping, numASes * numPrefixes announcements in AS major order
+     */
+    inline void AttachMapping(const std::shared_ptr<MappedFile> &mapping, AnnouncementCachedData *mappedArena, const size_t numASes, const size_t numPrefixes) {
+        std::vector<AnnouncementCachedData>().swap(arena);
+        backingFilePath.clear();
+        requestedTileLength = 0;
+        shardNodes.clear();
+
+        this->mapping = mapping;
+        this->data = mappedArena;
+        this->numAses = numASes;
+        this->numPrefixes = numPrefixes;
+
+        tileLength = numPrefixes;
+        tileShift = 32;
+        tileMask = 0xFFFFFFFF;
+        tileStride = 0;
     }
 };
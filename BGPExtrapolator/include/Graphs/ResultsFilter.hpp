@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Defines.h"
+
+/**
+ * An IPv4 or IPv6 prefix, as the range of addresses it covers
+ */
+struct PrefixRange {
+    bool ipv6;
+    // Network byte order, IPv4 addresses in the first 4 bytes
+    uint8_t address[16];
+    uint8_t length;
+
+    PrefixRange() : ipv6(false), address(), length(0) {
+
+    }
+
+    /**
+     * @param text -> "10.0.0.0/8", "2001:db8::/32", or an address alone (a range of one)
+     * @return false if it is not a prefix
+     */
+    static bool Parse(const std::string &text, PrefixRange &range);
+
+    /**
+     * @return whether the prefix lies within this range (the same prefix or a more specific one of the same family)
+     */
+    bool Contains(const PrefixRange &prefix) const;
+};
+
+/**
+ * Which rows of the results to write, checked before the AS paths are traced back and formatted. Every part left empty lets every row through.
+ *
+ * Prefixes and origins only depend on the announcement a cell refers to, so they are decided once per announcement rather than once per row.
+ * Rows are written when they pass every part.
+ */
+struct ResultsFilter {
+    // Prefixes the announcement must fall within (one of them)
+    std::vector<PrefixRange> prefixRanges;
+
+    // Origins the announcement must come from (one of them), sorted
+    std::vector<ASN> originASNs;
+
+    // Bit per RELATIONSHIP_PRIORITY_* the route must have been received over, 0 for any.
+    // Removed stubs receive their routes from their provider, unless they originate them
+    uint8_t relationships;
+
+    // Only the routes propagation added, i.e. the rows that are not already in the results after seeding (seeded announcements are never replaced,
+    //  and propagation never leaves a cell received from the AS itself)
+    bool propagatedOnly;
+
+    ResultsFilter() : relationships(0), propagatedOnly(false) {
+
+    }
+
+    inline bool FiltersAnnouncements() const { return !prefixRanges.empty() || !originASNs.empty(); }
+    inline bool IsEmpty() const { return !FiltersAnnouncements() && relationships == 0 && !propagatedOnly; }
+
+    inline bool MatchesRelationship(const uint8_t relationship) const {
+        return relationships == 0 || (relationships & (1 << relationship)) != 0;
+    }
+
+    /**
+     * @return whether an announcement passes the prefix and origin parts
+     */
+    bool MatchesAnnouncement(const std::string &prefixString, const ASN originASN) const;
+
+    /**
+     * Reads the results options of a launch configuration (results_filter_prefixes, results_filter_origins, results_filter_relationships,
+     *  results_propagated_only), the ones that are not given keep their defaults
+     *
+     * @param json -> Launch configuration, or an experiment request of the server
+     * @param filter -> Filled in
+     * @param error -> Why the options are invalid
+     * @return false if an option is invalid
+     */
+    static bool FromJSON(const nlohmann::json &json, ResultsFilter &filter, std::string &error);
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "Defines.h"
+#include "PropagationStatistics.hpp"
+
+/**
+ * Aggregates that can be written instead of the traceback results (aggregate_outputs in the launch file), combined as flags
+ */
+enum AGGREGATE_OUTPUT {
+    AGGREGATE_PATH_LENGTHS = 1 << 0,
+    AGGREGATE_ORIGIN_REACH = 1 << 1,
+    AGGREGATE_RELATIONSHIPS = 1 << 2,
+    AGGREGATE_TRANSIT = 1 << 3
+};
+
+// Most ASes on a written AS path: Traceback cuts paths at 99, and a removed stub goes in front of its provider's path
+static const size_t AGGREGATE_MAX_PATH_LENGTH = 100;
+
+struct OriginReach {
+    // Prefix blocks in which at least one AS routes via the origin
+    uint64_t prefixBlocks;
+    // Routes (AS and prefix block) coming from the origin
+    uint64_t routes;
+
+    OriginReach() : prefixBlocks(0), routes(0) {
+
+    }
+};
+
+struct RouteTransit {
+    // Routes received straight from the AS
+    uint64_t nextHopRoutes;
+    // Routes whose AS path goes through the AS, not counting the routes of the AS itself or those it originates
+    uint64_t transitRoutes;
+
+    RouteTransit() : nextHopRoutes(0), transitRoutes(0) {
+
+    }
+};
+
+/**
+ * Statistics over the routes of one lane, instead of the routes themselves (see Graph::ComputeRibAggregates).
+ * Routes are counted once per AS and prefix block, over the ASes the results would be written for (removed stubs included),
+ *  so every figure is what adding up Results.tsv would give.
+ */
+struct RibAggregates {
+    // Routes by the number of ASes on their AS path (as written to the results), index 0 unused
+    std::vector<uint64_t> pathLengths;
+
+    std::map<ASN, OriginReach> originReach;
+
+    // Routes of every AS by the relationship they were received over, indexed by RELATIONSHIP_PRIORITY_*
+    std::map<ASN, std::vector<uint64_t>> relationships;
+
+    std::map<ASN, RouteTransit> transit;
+
+    RibAggregates() : pathLengths(AGGREGATE_MAX_PATH_LENGTH + 1, 0) {
+
+    }
+
+    /**
+     * Writes one file per aggregate: PathLengths, OriginReach, RouteRelationships and Transit (.tsv, after the suffix)
+     *
+     * @param outputs -> AGGREGATE_OUTPUT flags of the files to write
+     * @param outputFolder -> Prefix of the file paths
+     * @param suffix -> After the name of every file, to tell lanes apart ("" or "_<configuration name>")
+     * @param bytesWritten -> Set to the bytes written
+     * @return false if a file could not be opened or written (reason printed)
+     */
+    bool Write(const unsigned outputs, const std::string &outputFolder, const std::string &suffix, size_t &bytesWritten) const;
+
+    /**
+     * @param name -> path_lengths, origin_reach, relationships or transit
+     * @return its AGGREGATE_OUTPUT flag, 0 if there is no such aggregate
+     */
+    static unsigned ParseOutput(const std::string &name);
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "Graphs/Graph.hpp"
+
+/**
+ * A what-if layer on top of a seeded and propagated Graph (the baseline).
+ *
+ * The overlay never modifies the baseline. The first time a prefix column is written, the column is copied out of the baseline
+ *  (copy-on-write) and every later read or write of that prefix goes to the copy. Every other prefix is read straight from the baseline.
+ * Announcements added by a scenario get static data indices after the last index of the baseline, so cached data in the overlay
+ *  can point at either.
+ *
+ * Since the baseline is only read, any number of overlays (each owned by one thread) may be used against the same baseline at the same time.
+ * See Graph::RunScenario.
+ */
+class RibOverlay {
+private:
+    const Graph &baseline;
+
+    // Prefix block ID -> the announcement of every AS for that prefix (indexed by AS ID)
+    std::map<uint32_t, std::vector<AnnouncementCachedData>> columns;
+
+    // Static data of the scenario announcements. Index 0 here is index baseline.GetNumStaticData() in the overlay
+    std::vector<AnnouncementStaticData> staticData;
+
+    // Propagation works through one column at a time, so remember the last column to skip the map lookup on every cell
+    mutable uint32_t cachedBlockID;
+    mutable std::vector<AnnouncementCachedData> *cachedColumn;
+
+    // Returned for prefixes past the end of the baseline that the overlay never wrote to
+    const AnnouncementCachedData defaultAnnouncement;
+
+    inline std::vector<AnnouncementCachedData>* FindColumn(const uint32_t prefixBlockID) const {
+        if (cachedColumn != nullptr && cachedBlockID == prefixBlockID)
+            return cachedColumn;
+
+        auto search = columns.find(prefixBlockID);
+        if (search == columns.end())
+            return nullptr;
+
+        cachedBlockID = prefixBlockID;
+        cachedColumn = const_cast<std::vector<AnnouncementCachedData>*>(&search->second);
+        return cachedColumn;
+    }
+
+public:
+    RibOverlay(const Graph &baseline) : baseline(baseline), cachedBlockID(0), cachedColumn(nullptr) {
+
+    }
+
+    inline const Graph& GetBaseline() const { return baseline; }
+
+    /**
+     * Drops every copied column and scenario announcement, so the overlay can be reused for another scenario
+     */
+    inline void Clear() {
+        columns.clear();
+        staticData.clear();
+        cachedColumn = nullptr;
+    }
+
+    inline bool HasColumn(const uint32_t prefixBlockID) const { return FindColumn(prefixBlockID) != nullptr; }
+
+    /**
+     * The prefix columns this overlay has copied (and thus may differ from the baseline)
+     */
+    inline const std::map<uint32_t, std::vector<AnnouncementCachedData>>& GetColumns() const { return columns; }
+
+    /**
+     * Returns the column of the given prefix, copying it from the baseline if this is the first write to it.
+     * Prefixes past the end of the baseline start out with every announcement in the default state.
+     */
+    inline std::vector<AnnouncementCachedData>& GetColumn(const uint32_t prefixBlockID) {
+        std::vector<AnnouncementCachedData> *column = FindColumn(prefixBlockID);
+        if (column != nullptr)
+            return *column;
+
+        std::vector<AnnouncementCachedData> &newColumn = columns[prefixBlockID];
+        newColumn.resize(baseline.GetNumASes());
+
+        if (prefixBlockID < baseline.GetNumPrefixes()) {
+            for (ASN_ID id = 0; id < newColumn.size(); id++)
+                newColumn[id] = baseline.GetCachedData_ReadOnly(id, prefixBlockID);
+        }
+
+        cachedBlockID = prefixBlockID;
+        cachedColumn = &newColumn;
+        return newColumn;
+    }
+
+    inline AnnouncementCachedData& GetCachedData(const ASN_ID& asnID, const uint32_t& prefixBlockID) {
+        return GetColumn(prefixBlockID)[asnID];
+    }
+
+    inline const AnnouncementCachedData& GetCachedData_ReadOnly(const ASN_ID& asnID, const uint32_t& prefixBlockID) const {
+        const std::vector<AnnouncementCachedData> *column = FindColumn(prefixBlockID);
+        if (column != nullptr)
+            return (*column)[asnID];
+
+        if (prefixBlockID < baseline.GetNumPrefixes())
+            return baseline.GetCachedData_ReadOnly(asnID, prefixBlockID);
+
+        return defaultAnnouncement;
+    }
+
+    /**
+     * Adds the static data of a scenario announcement
+     *
+     * @return the index to store in the cached data
+     */
+    inline uint32_t AddStaticData() {
+        staticData.push_back(AnnouncementStaticData());
+        return baseline.GetNumStaticData() + staticData.size() - 1;
+    }
+
+    inline AnnouncementStaticData& GetStaticData(const size_t& index) {
+        return staticData[index - baseline.GetNumStaticData()];
+    }
+
+    inline const AnnouncementStaticData& GetStaticData_ReadOnly(const size_t& index) const {
+        if (index < baseline.GetNumStaticData())
+            return baseline.GetStaticData_ReadOnly(index);
+
+        return staticData[index - baseline.GetNumStaticData()];
+    }
+
+    inline ASN GetASN(const ASN_ID id) const { return baseline.GetASN(id); }
+
+    inline size_t GetNumASes() const { return baseline.GetNumASes(); }
+
+    /**
+     * Same as Graph::Traceback, but follows the overlay's version of the local ribs
+     */
+    inline void Traceback(std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const {
+        baseline.Traceback(*this, as_path, startingASN, prefixBlockID);
+    }
+};
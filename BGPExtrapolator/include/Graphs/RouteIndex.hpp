@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "Defines.h"
+#include "ThreadPool.hpp"
+
+class Graph;
+
+/**
+ * Reverse index over the local ribs of a propagated graph, answering "which ASes route this prefix block via origin O / next hop N"
+ *  without a pass over the whole column (see Graph::BuildRouteIndex and the Graph query methods, which take ASNs and add the removed stubs).
+ *
+ * For every prefix block (column, as seen by Traceback):
+ *  - one bitset of AS IDs per origin ASN. There are only a few origins per prefix, so the sets are dense and cheap to count and intersect
+ *  - the ASes grouped by the ID of the AS they received the announcement from (sorted, one range per next hop). A bitset per next hop
+ *     would take a bit per AS for every AS that exports the prefix, so the groups are kept as lists instead
+ *  - the ASes that received the announcement from a removed stub originating it (their received from ID is their own)
+ * Removed stubs are listed by provider once, they route whatever their provider routes.
+ *
+ * The index is a snapshot of the ribs it was built from, the graph drops it whenever its ribs change.
+ */
+class RouteIndex {
+private:
+    struct BlockIndex {
+        // Origin ASN and the first word of its bitset in originWords, sorted by ASN
+        std::vector<std::pair<ASN, uint32_t>> origins;
+        std::vector<uint64_t> originWords;
+
+        // Next hop ID and the first of its ASes in nextHopMembers (up to the first of the next one), sorted by ID
+        std::vector<std::pair<ASN_ID, uint32_t>> nextHops;
+        std::vector<ASN_ID> nextHopMembers;
+
+        // Removed stub ASN originating the prefix, and the AS (its provider) that received it from the stub
+        std::vector<std::pair<ASN, ASN_ID>> stubNextHops;
+
+        // Prefix of the announcements in the block (in the static data of the graph, only used while building), nullptr if no AS has one
+        const std::string *prefixString;
+
+        BlockIndex() : prefixString(nullptr) {
+
+        }
+    };
+
+    size_t numASes;
+    size_t numWords;
+    std::vector<BlockIndex> blocks;
+
+    // Removed stubs of every AS: stubASNs[stubBegin[id]] up to stubASNs[stubBegin[id + 1]]
+    std::vector<uint32_t> stubBegin;
+    std::vector<ASN> stubASNs;
+
+    // Prefix blocks of every prefix, in order (one per lane with lanes)
+    std::unordered_map<std::string, std::vector<uint32_t>> prefixToBlocks;
+
+    /**
+     * Indexes one prefix block
+     *
+     * @param nextHopCounts -> Scratch of the calling thread, one count per AS, all zero (and left so)
+     */
+    void BuildBlock(const Graph &graph, const uint32_t prefixBlockID, std::vector<uint32_t> &nextHopCounts);
+
+public:
+    /**
+     * Indexes every prefix block of the graph, the blocks split over the threads of the pool
+     *
+     * @param graph -> Propagated graph
+     * @param threadPool -> Threads to build with
+     * @param removedStubs -> ASN and provider ID of every stub that has no ID of its own (stub removal)
+     */
+    RouteIndex(const Graph &graph, ThreadPool &threadPool, const std::vector<std::pair<ASN, ASN_ID>> &removedStubs);
+
+    /**
+     * @return the bitset (GetNumWords() words, bit i is AS ID i) of the ASes routing the prefix block via the origin, nullptr if none does
+     */
+    const uint64_t* GetOriginSet(const uint32_t prefixBlockID, const ASN originASN) const;
+
+    /**
+     * @param ids -> Filled with the IDs of the ASes routing the prefix block via the origin, sorted
+     */
+    void GetOriginMembers(const uint32_t prefixBlockID, const ASN originASN, std::vector<ASN_ID> &ids) const;
+
+    /**
+     * @param origins -> Filled with the origins of the prefix block and how many ASes (with an ID) route via each
+     */
+    void GetOrigins(const uint32_t prefixBlockID, std::vector<std::pair<ASN, size_t>> &origins) const;
+
+    /**
+     * @param begin, end -> Set to the IDs of the ASes that received the prefix block from the AS, sorted (empty if none did)
+     */
+    void GetNextHopMembers(const uint32_t prefixBlockID, const ASN_ID nextHopID, const ASN_ID *&begin, const ASN_ID *&end) const;
+
+    /**
+     * @param ids -> Filled with the IDs of the ASes that received the prefix block from the removed stub originating it
+     */
+    void GetStubNextHopMembers(const uint32_t prefixBlockID, const ASN stubASN, std::vector<ASN_ID> &ids) const;
+
+    /**
+     * @return the prefix blocks holding the prefix (as written in the announcements), empty if none does
+     */
+    const std::vector<uint32_t>& GetPrefixBlocks(const std::string &prefixString) const;
+
+    /**
+     * @param begin, end -> Set to the removed stubs of the AS
+     */
+    inline void GetRemovedStubs(const ASN_ID providerID, const ASN *&begin, const ASN *&end) const {
+        begin = stubASNs.data() + stubBegin[providerID];
+        end = stubASNs.data() + stubBegin[providerID + 1];
+    }
+
+    inline size_t GetNumWords() const { return numWords; }
+    inline size_t GetNumPrefixes() const { return blocks.size(); }
+
+    /**
+     * @return bytes held by the index
+     */
+    size_t GetMemoryUsage() const;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include "BoundedQueue.hpp"
+
+enum class INPUT_COMPRESSION {
+    NONE,
+    GZIP,
+    ZSTD
+};
+
+/**
+ * Reads an input file (relationships, announcements) a line at a time, whether it is plain or gzip/zstd compressed.
+ * The compression is recognized by the magic bytes at the start of the file, not by its name.
+ *
+ * A compressed file is decompressed by a background thread, in chunks handed to the reader through a small bounded queue,
+ *  so parsing overlaps decompression and the uncompressed data is never all in memory (or on disk) at once.
+ * Compressed input needs the library compiled in (zlib for gzip, libzstd for zstd, found by CMake), see IsSupported.
+ */
+class InputFile {
+private:
+    static const size_t CHUNK_BYTES = 1 << 20;
+    static const size_t QUEUED_CHUNKS = 4;
+
+    FILE *file;
+    INPUT_COMPRESSION compression;
+
+    // Data read (plain) or decompressed so far, and where the next line starts in it
+    std::vector<char> chunk;
+    size_t chunkPosition;
+    bool endOfInput;
+
+    BoundedQueue<std::vector<char>> chunks;
+    std::thread decompressor;
+    std::atomic<bool> corrupt;
+
+    /**
+     * Body of the decompressing thread: decompresses the whole file into the queue, then closes it
+     */
+    void Decompress();
+    void DecompressGzip();
+    void DecompressZstd();
+
+    /**
+     * Replaces the current chunk with the next one
+     *
+     * @return false at the end of the input
+     */
+    bool NextChunk();
+
+public:
+    InputFile();
+    ~InputFile();
+
+    /**
+     * @param filePath -> Plain, gzip or zstd compressed file
+     * @return false if the file cannot be read, or is compressed with a library that is not compiled in
+     */
+    bool Open(const std::string &filePath);
+
+    /**
+     * Stops reading (and decompressing) the file, Open may be called again
+     */
+    void Close();
+
+    /**
+     * @param line -> Filled with the next line, without the line ending (\n or \r\n)
+     * @return false at the end of the input
+     */
+    bool ReadLine(std::string &line);
+
+    /**
+     * @return true if the compressed data turned out to be corrupt or truncated, the lines read before it are fine
+     */
+    inline bool IsCorrupt() const { return corrupt; }
+
+    inline INPUT_COMPRESSION GetCompression() const { return compression; }
+
+    /**
+     * @return the compression of a file from its first bytes, NONE if it cannot be read
+     */
+    static INPUT_COMPRESSION DetectCompression(const std::string &filePath);
+
+    static inline bool IsCompressed(const std::string &filePath) { return DetectCompression(filePath) != INPUT_COMPRESSION::NONE; }
+
+    /**
+     * @return whether files with the given compression can be read by this build
+     */
+    static bool IsSupported(const INPUT_COMPRESSION compression);
+};
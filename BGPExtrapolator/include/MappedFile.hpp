@@ -0,0 +1,232 @@
+#pragma once
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * An entire file in memory.
+ *
+ * Open: on POSIX systems the file is memory mapped privately: pages are only read from disk when touched, and writes to the
+ *  mapping are copy-on-write (they are never written back to the file). Elsewhere the file is simply read into memory.
+ *
+ * Create: a new zero filled scratch file is mapped shared, so the OS may write pages back to it and evict them when memory runs low.
+ *  The file is unlinked right away, its space is given back when the mapping is closed. POSIX only.
+ *
+ * CreateAnonymous: zero filled memory that is not backed by a file. Unlike a vector, no page is touched until it is used,
+ *  so where a page ends up (NUMA) is decided by whoever touches it first or by a binding set beforehand. POSIX only.
+ */
+class MappedFile {
+private:
+    char *data;
+    size_t size;
+    bool mapped;
+    bool anonymous;
+
+    // Only kept open for created (shared) mappings
+    int fd;
+
+    // Only used when memory mapping is not available
+    std::vector<char> fallback;
+
+public:
+    MappedFile() : data(nullptr), size(0), mapped(false), anonymous(false), fd(-1) {
+
+    }
+
+    ~MappedFile() {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @param filePath -> File to map
+     * @return false if the file could not be opened or mapped
+     */
+    bool Open(const std::string &filePath) {
+        Close();
+
+#ifndef _WIN32
+        int fd = open(filePath.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void *address = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+
+        if (address == MAP_FAILED)
+            return false;
+
+        data = (char*) address;
+        size = fileStat.st_size;
+        mapped = true;
+        return true;
+#else
+        FILE *f = fopen(filePath.c_str(), "rb");
+        if (f == nullptr)
+            return false;
+
+        fseek(f, 0, SEEK_END);
+        long length = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        fallback.resize(length);
+        bool ok = length > 0 && fread(fallback.data(), 1, length, f) == (size_t) length;
+        fclose(f);
+
+        if (!ok) {
+            fallback.clear();
+            return false;
+        }
+
+        data = fallback.data();
+        size = length;
+        return true;
+#endif
+    }
+
+    /**
+     * @param filePath -> Scratch file to create (replaced if it exists)
+     * @param length -> Size of the file and mapping in bytes
+     * @return false if the file could not be created or mapped
+     */
+    bool Create(const std::string &filePath, const size_t length) {
+        Close();
+
+#ifndef _WIN32
+        if (length == 0)
+            return false;
+
+        fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if (fd < 0)
+            return false;
+
+        unlink(filePath.c_str());
+
+        if (ftruncate(fd, length) != 0) {
+            Close();
+            return false;
+        }
+
+        void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            Close();
+            return false;
+        }
+
+        data = (char*) address;
+        size = length;
+        mapped = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @param length -> Size of the mapping in bytes
+     * @return false if the memory could not be mapped
+     */
+    bool CreateAnonymous(const size_t length) {
+        Close();
+
+#ifndef _WIN32
+        if (length == 0)
+            return false;
+
+        void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (address == MAP_FAILED)
+            return false;
+
+        data = (char*) address;
+        size = length;
+        mapped = true;
+        anonymous = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Sets every byte of a created mapping back to zero without touching the pages
+     *  (the file is truncated and re-extended, anonymous pages are dropped and come back zero filled)
+     *
+     * @return false if this is not a created mapping
+     */
+    bool Zero() {
+#ifndef _WIN32
+        if (anonymous)
+            return madvise(data, size, MADV_DONTNEED) == 0;
+        if (fd < 0)
+            return false;
+
+        return ftruncate(fd, 0) == 0 && ftruncate(fd, size) == 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Hints that the given byte range is about to be used
+     */
+    void WillNeed(const size_t offset, const size_t length) {
+#ifndef _WIN32
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t begin = offset - offset % pageSize;
+        if (mapped && begin < size)
+            madvise(data + begin, std::min(length + offset - begin, size - begin), MADV_WILLNEED);
+#endif
+    }
+
+    /**
+     * Starts writing the given byte range back to the file and lets the OS drop it from memory.
+     * Only whole pages inside the range are released. The contents are kept (in the file).
+     */
+    void Release(const size_t offset, const size_t length) {
+#ifndef _WIN32
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t begin = ((offset + pageSize - 1) / pageSize) * pageSize;
+        size_t end = std::min(offset + length, size);
+        end -= end % pageSize;
+        if (fd >= 0 && begin < end) {
+            msync(data + begin, end - begin, MS_ASYNC);
+            madvise(data + begin, end - begin, MADV_DONTNEED);
+        }
+#endif
+    }
+
+    void Close() {
+#ifndef _WIN32
+        if (mapped)
+            munmap(data, size);
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+#endif
+        fallback.clear();
+        data = nullptr;
+        size = 0;
+        mapped = false;
+        anonymous = false;
+    }
+
+    inline char* GetData() const { return data; }
+    inline size_t GetSize() const { return size; }
+};
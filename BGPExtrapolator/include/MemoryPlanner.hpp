@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Graphs/Graph.hpp"
+
+/**
+ * What a cheap pass over an announcements file finds, enough to know what SeedBlock will allocate for it without parsing it
+ */
+struct AnnouncementsScan {
+    size_t fileBytes;   // Uncompressed
+    size_t numRows;
+    size_t numColumns;
+
+    // Heap bytes of every cell string too long for the small string buffer, as the CSV document holds them
+    size_t cellHeapBytes;
+
+    // Heap bytes of the prefix strings, as the static data holds them
+    size_t prefixStringHeapBytes;
+
+    // ASNs over all AS_PATHs, and the capacity the seeded path arena grows to holding them
+    size_t totalPathASNs;
+    size_t seededPathCapacity;
+
+    AnnouncementsScan() : fileBytes(0), numRows(0), numColumns(0), cellHeapBytes(0), prefixStringHeapBytes(0), totalPathASNs(0), seededPathCapacity(0) {
+
+    }
+};
+
+/**
+ * What the run is going to need, and the layout chosen to fit it in the memory limit
+ */
+struct MemoryPlan {
+    //***** Footprint, in bytes
+    size_t graphBytes;              // Topology, as loaded
+    size_t documentBytes;           // The parsed announcements file, only alive during SeedBlock
+    size_t batchBytes;              // Pipelined: the announcements of the batches in flight, in place of the document (0 otherwise)
+    size_t staticDataBytes;
+    size_t seededPathBytes;         // Only when seeded paths are retained (checkpoints)
+    size_t ribBytes;                // All of the local ribs
+    size_t residentRibBytes;        // The part of the local ribs in memory at once (all of them, unless out of core or pipelined)
+    size_t peerStagingBytes;
+    size_t outputBytes;             // Writer buffer, the list of ASes to dump and the formatted paths of a prefix block
+
+    size_t seedingPeakBytes;
+    size_t propagationPeakBytes;
+    size_t peakBytes;
+
+    //***** Decision
+    bool fits;
+    bool useFileBacking;            // Local ribs out of core, tileMemoryBytes at a time
+    size_t tileMemoryBytes;
+    size_t pipelineBatchRows;       // Rows per pipelined batch (see BlockPipeline), 0 for every block at once
+    size_t numThreads;
+
+    MemoryPlan() : graphBytes(0), documentBytes(0), batchBytes(0), staticDataBytes(0), seededPathBytes(0), ribBytes(0), residentRibBytes(0), peerStagingBytes(0),
+        outputBytes(0), seedingPeakBytes(0), propagationPeakBytes(0), peakBytes(0), fits(true), useFileBacking(false), tileMemoryBytes(0), pipelineBatchRows(0),
+        numThreads(1) {
+
+    }
+};
+
+/**
+ * Predicts the memory of a run from the loaded graph and a scan of the announcements, before anything big is allocated,
+ *  and picks a local rib layout (in memory, in pipelined batches of a number of rows, or out of core with a prefix tile size) and a thread count
+ *  that fit a memory limit. Batches are only sized for runs that ask to be pipelined, since they write the rows of the results in another order.
+ *
+ * The footprint follows the allocations the extrapolator actually makes (the local ribs are one cell per AS per prefix block row,
+ *  the CSV document keeps every cell as a string, ...), with glibc's allocation sizes for heap strings.
+ *  Pages of an out of core backing file that are cached by the kernel are not counted, it reclaims them as needed.
+ */
+class MemoryPlanner {
+public:
+    /**
+     * @param filePath -> Announcements TSV
+     * @param scan -> Filled in
+     * @return false if the file could not be read
+     */
+    static bool ScanAnnouncements(const std::string &filePath, AnnouncementsScan &scan);
+
+    /**
+     * @param graph -> Loaded graph (stub removal already applied), nothing seeded yet
+     * @param scan -> Scan of the announcements to seed
+     * @param memoryLimit -> Bytes the run may use, 0 for no limit
+     * @param numThreads -> Threads asked for
+     * @param retainSeededPaths -> Whether seeded paths are kept (state output)
+     * @param fileBacking -> Whether the local ribs are already configured out of core
+     * @param tileMemoryBytes -> The configured tile memory of out of core ribs
+     * @param numDumpedASes -> ASes whose local ribs are written, 0 for all of them
+     * @param numLanes -> Configurations seeded side by side (see Graph::SeedBlock with lanes), 1 for a plain run
+     * @param pipelineBatchRows -> Rows per pipelined batch asked for, smaller batches are planned if they do not fit. 0 if the run is not pipelined
+     */
+    static MemoryPlan Plan(const Graph &graph, const AnnouncementsScan &scan, const size_t memoryLimit, const size_t numThreads,
+        const bool retainSeededPaths, const bool fileBacking, const size_t tileMemoryBytes, const size_t numDumpedASes, const size_t numLanes,
+        const size_t pipelineBatchRows);
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+
+#ifdef BGPX_HAS_NUMA
+#include <numa.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Thin wrapper over libnuma for placing memory and threads on NUMA nodes.
+ *
+ * Only does anything when built with libnuma (BGPX_HAS_NUMA) on a system where NUMA is available.
+ * Otherwise the machine is treated as a single node and every call is a no-op, so callers never need to check.
+ */
+class NumaTopology {
+public:
+    /**
+     * @return the number of NUMA nodes memory can be placed on, 1 if NUMA is not available
+     */
+    static inline size_t GetNumNodes() {
+#ifdef BGPX_HAS_NUMA
+        if (numa_available() >= 0 && numa_num_configured_nodes() > 0)
+            return numa_num_configured_nodes();
+#endif
+        return 1;
+    }
+
+    /**
+     * Restricts the calling thread to the CPUs of the given node
+     */
+    static inline void PinCurrentThreadToNode(const int node) {
+#ifdef BGPX_HAS_NUMA
+        if (numa_available() >= 0)
+            numa_run_on_node(node);
+#else
+        (void) node;
+#endif
+    }
+
+    /**
+     * Binds a range of a mapping to a node, before it is first touched. Pages are only placed when they are faulted in,
+     *  so this costs nothing up front. The range is rounded to whole pages (a page on a boundary goes to the range that starts in it).
+     *
+     * @param base -> Start of the mapping (page aligned)
+     * @param beginOffset -> First byte of the range
+     * @param endOffset -> One past the last byte of the range
+     * @param node -> Node to place the pages on
+     */
+    static inline void BindRange(char *base, const size_t beginOffset, const size_t endOffset, const int node) {
+#ifdef BGPX_HAS_NUMA
+        if (numa_available() < 0)
+            return;
+
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t begin = beginOffset - beginOffset % pageSize;
+        size_t end = endOffset - endOffset % pageSize;
+        if (end < endOffset)
+            end += pageSize;
+
+        if (begin < end)
+            numa_tonode_memory(base + begin, end - begin, node);
+#else
+        (void) base;
+        (void) beginOffset;
+        (void) endOffset;
+        (void) node;
+#endif
+    }
+
+    /**
+     * Counts the pages of a range that are resident on each node. Pages that were never touched are not counted.
+     *
+     * @param base -> Start of the range (page aligned)
+     * @param length -> Length of the range in bytes
+     * @return bytes resident per node, indexed by node (a single entry with every byte if NUMA is not available)
+     */
+    static inline std::vector<size_t> GetResidentBytesPerNode(char *base, const size_t length) {
+#ifdef BGPX_HAS_NUMA
+        if (numa_available() >= 0) {
+            const size_t pageSize = sysconf(_SC_PAGESIZE);
+            const size_t numPages = (length + pageSize - 1) / pageSize;
+            const size_t batchSize = 4096;
+
+            std::vector<size_t> bytesPerNode(GetNumNodes(), 0);
+            std::vector<void*> pages(batchSize);
+            std::vector<int> status(batchSize);
+
+            for (size_t batchBegin = 0; batchBegin < numPages; batchBegin += batchSize) {
+                size_t count = std::min(batchSize, numPages - batchBegin);
+                for (size_t i = 0; i < count; i++)
+                    pages[i] = base + (batchBegin + i) * pageSize;
+
+                // With no target nodes, move_pages only reports the node of every page (negative if not resident)
+                if (numa_move_pages(0, count, pages.data(), nullptr, status.data(), 0) != 0)
+                    break;
+
+                for (size_t i = 0; i < count; i++) {
+                    if (status[i] >= 0 && (size_t) status[i] < bytesPerNode.size())
+                        bytesPerNode[status[i]] += pageSize;
+                }
+            }
+
+            return bytesPerNode;
+        }
+#else
+        (void) base;
+#endif
+        return std::vector<size_t>(1, length);
+    }
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+enum PERF_COUNTER {
+    PERF_COUNTER_CYCLES,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_LLC_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_DTLB_MISSES,
+    PERF_COUNTER_COUNT
+};
+
+/**
+ * A reading (or a difference of two readings) of every hardware counter
+ */
+struct PerfCounterValues {
+    uint64_t values[PERF_COUNTER_COUNT];
+
+    PerfCounterValues() {
+        memset(values, 0, sizeof(values));
+    }
+
+    inline uint64_t& operator[](const size_t counter) { return values[counter]; }
+    inline const uint64_t& operator[](const size_t counter) const { return values[counter]; }
+
+    inline void Add(const PerfCounterValues &other) {
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++)
+            values[i] += other.values[i];
+    }
+
+    /**
+     * @return the counts from the given earlier reading up to this one
+     */
+    inline PerfCounterValues Since(const PerfCounterValues &earlier) const {
+        PerfCounterValues difference;
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++)
+            difference.values[i] = values[i] >= earlier.values[i] ? values[i] - earlier.values[i] : 0;
+
+        return difference;
+    }
+};
+
+/**
+ * The hardware counters of one thread, read through Linux perf_event_open (user space only, so a perf_event_paranoid of 2 is enough).
+ *
+ * Counters are opened by the thread to be counted, but may be read from any thread.
+ * A counter the CPU or kernel does not support (or every counter, off Linux) simply reads 0, see IsAvailable.
+ * When the kernel multiplexes the counters, readings are scaled up to the full time the counter was enabled.
+ */
+class PerfCounters {
+private:
+    int fds[PERF_COUNTER_COUNT];
+
+#ifdef __linux__
+    static int OpenCounter(const uint32_t type, const uint64_t config) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // This thread, any CPU
+        return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+
+public:
+    PerfCounters() {
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++)
+            fds[i] = -1;
+    }
+
+    ~PerfCounters() {
+        Close();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * Starts counting the calling thread
+     *
+     * @return false if no counter could be opened (not Linux, no PMU access, or perf_event_paranoid too high)
+     */
+    bool Open() {
+        Close();
+
+#ifdef __linux__
+        fds[PERF_COUNTER_CYCLES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[PERF_COUNTER_INSTRUCTIONS] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds[PERF_COUNTER_LLC_MISSES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[PERF_COUNTER_BRANCH_MISSES] = OpenCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds[PERF_COUNTER_DTLB_MISSES] = OpenCounter(PERF_TYPE_HW_CACHE,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+            if (fds[i] >= 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void Close() {
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+#ifdef __linux__
+            if (fds[i] >= 0)
+                close(fds[i]);
+#endif
+            fds[i] = -1;
+        }
+    }
+
+    inline bool IsAvailable(const PERF_COUNTER counter) const { return fds[counter] >= 0; }
+
+    /**
+     * @return the counts since Open
+     */
+    PerfCounterValues Read() const {
+        PerfCounterValues reading;
+
+#ifdef __linux__
+        for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+            if (fds[i] < 0)
+                continue;
+
+            // value, time enabled, time running
+            uint64_t values[3];
+            if (read(fds[i], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+                continue;
+
+            reading[i] = values[2] < values[1] ? (uint64_t) ((double) values[0] * values[1] / values[2]) : values[0];
+        }
+#endif
+
+        return reading;
+    }
+
+    static inline const char* GetName(const PERF_COUNTER counter) {
+        static const char *names[PERF_COUNTER_COUNT] = { "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses" };
+        return names[counter];
+    }
+};
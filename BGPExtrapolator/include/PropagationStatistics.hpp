@@ -0,0 +1,204 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Defines.h"
+
+/**
+ * The rule of BGPPolicy::CompareAnnouncements that decided a comparison (whether or not the announcement was replaced)
+ */
+enum COMPARISON_RULE {
+    COMPARISON_RULE_NOTHING_SENT,       // The neighbor has no announcement, nothing to compare
+    COMPARISON_RULE_SEEDED,             // The receiving announcement is seeded, it is never replaced
+    COMPARISON_RULE_NOTHING_HELD,       // The receiver has no announcement yet, the neighbor's is taken
+    COMPARISON_RULE_RELATIONSHIP,
+    COMPARISON_RULE_PATH_LENGTH,
+    COMPARISON_RULE_TIMESTAMP,
+    COMPARISON_RULE_ASN,
+    COMPARISON_RULE_COUNT
+};
+
+/**
+ * The rule of Graph::SeedPath that decided between two seeded announcements of the same prefix at an AS
+ */
+enum SEEDING_RULE {
+    SEEDING_RULE_NOTHING_HELD,          // No announcement yet, the seeded one is taken
+    SEEDING_RULE_TIMESTAMP,
+    SEEDING_RULE_RELATIONSHIP,
+    SEEDING_RULE_PATH_LENGTH,
+    SEEDING_RULE_TIEBREAK,              // Random or lowest received from ASN, see TIEBRAKING_METHOD
+    SEEDING_RULE_COUNT
+};
+
+// Relationship priorities go from RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER (0) to RELATIONSHIP_PRIORITY_ORIGIN
+static const size_t NUM_RELATIONSHIP_PRIORITIES = RELATIONSHIP_PRIORITY_ORIGIN + 1;
+
+/**
+ * Counts of the decisions made by the propagation and seeding kernels, see CountingStatistics
+ */
+struct PropagationStatistics {
+    // Comparisons decided by each rule, and how many of those replaced the receiving announcement
+    uint64_t comparisons[COMPARISON_RULE_COUNT];
+    uint64_t comparisonReplacements[COMPARISON_RULE_COUNT];
+
+    // Announcements replaced by imports over each relationship, indexed by relationship priority
+    uint64_t relationshipReplacements[NUM_RELATIONSHIP_PRIORITIES];
+
+    // Seeded announcements decided by each rule, and how many of those were written to the local rib
+    uint64_t seedingDecisions[SEEDING_RULE_COUNT];
+    uint64_t seedingReplacements[SEEDING_RULE_COUNT];
+
+    PropagationStatistics() {
+        memset(this, 0, sizeof(PropagationStatistics));
+    }
+
+    void Add(const PropagationStatistics &other) {
+        for (size_t i = 0; i < COMPARISON_RULE_COUNT; i++) {
+            comparisons[i] += other.comparisons[i];
+            comparisonReplacements[i] += other.comparisonReplacements[i];
+        }
+
+        for (size_t i = 0; i < NUM_RELATIONSHIP_PRIORITIES; i++)
+            relationshipReplacements[i] += other.relationshipReplacements[i];
+
+        for (size_t i = 0; i < SEEDING_RULE_COUNT; i++) {
+            seedingDecisions[i] += other.seedingDecisions[i];
+            seedingReplacements[i] += other.seedingReplacements[i];
+        }
+    }
+
+    /**
+     * @return the counts from the given earlier reading up to this one
+     */
+    PropagationStatistics Since(const PropagationStatistics &earlier) const {
+        PropagationStatistics difference;
+        for (size_t i = 0; i < COMPARISON_RULE_COUNT; i++) {
+            difference.comparisons[i] = comparisons[i] - earlier.comparisons[i];
+            difference.comparisonReplacements[i] = comparisonReplacements[i] - earlier.comparisonReplacements[i];
+        }
+
+        for (size_t i = 0; i < NUM_RELATIONSHIP_PRIORITIES; i++)
+            difference.relationshipReplacements[i] = relationshipReplacements[i] - earlier.relationshipReplacements[i];
+
+        for (size_t i = 0; i < SEEDING_RULE_COUNT; i++) {
+            difference.seedingDecisions[i] = seedingDecisions[i] - earlier.seedingDecisions[i];
+            difference.seedingReplacements[i] = seedingReplacements[i] - earlier.seedingReplacements[i];
+        }
+
+        return difference;
+    }
+
+    static inline const char* GetComparisonRuleName(const COMPARISON_RULE rule) {
+        static const char *names[COMPARISON_RULE_COUNT] = { "nothing_sent", "seeded", "nothing_held", "relationship", "path_length", "timestamp", "asn" };
+        return names[rule];
+    }
+
+    static inline const char* GetSeedingRuleName(const SEEDING_RULE rule) {
+        static const char *names[SEEDING_RULE_COUNT] = { "nothing_held", "timestamp", "relationship", "path_length", "tiebreak" };
+        return names[rule];
+    }
+
+    static inline const char* GetRelationshipName(const size_t relationshipPriority) {
+        static const char *names[NUM_RELATIONSHIP_PRIORITIES] = { "provider_to_customer", "peer_to_peer", "customer_to_provider", "origin" };
+        return names[relationshipPriority];
+    }
+};
+
+/**
+ * Statistics policies. The propagation and seeding kernels take one as a template parameter and create an instance per call:
+ *  - NoStatistics: every method is empty, so the kernels compile to exactly what they were without statistics
+ *  - CountingStatistics: counts into the statistics of the calling thread (no sharing, no atomics)
+ *
+ * DefaultStatistics is what the graph uses, CountingStatistics when built with BGPX_STATISTICS (the CMake option of the same name).
+ */
+class NoStatistics {
+public:
+    static const bool enabled = false;
+
+    inline void Compared(const COMPARISON_RULE, const bool) { }
+    inline void Imported(const uint8_t, const uint32_t) { }
+    inline void Seeded(const SEEDING_RULE, const bool) { }
+
+    static inline PropagationStatistics ReadThread() { return PropagationStatistics(); }
+    static inline PropagationStatistics ReadAllThreads() { return PropagationStatistics(); }
+};
+
+class CountingStatistics {
+private:
+    PropagationStatistics &statistics;
+
+    // Statistics of every thread that ever counted. Kept after the thread exits, so nothing is lost
+    static std::mutex& GetRegistryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::vector<std::unique_ptr<PropagationStatistics>>& GetRegistry() {
+        static std::vector<std::unique_ptr<PropagationStatistics>> registry;
+        return registry;
+    }
+
+    static PropagationStatistics& GetThreadStatistics() {
+        static thread_local PropagationStatistics *threadStatistics = nullptr;
+        if (threadStatistics == nullptr) {
+            std::lock_guard<std::mutex> lock(GetRegistryMutex());
+            GetRegistry().push_back(std::unique_ptr<PropagationStatistics>(new PropagationStatistics()));
+            threadStatistics = GetRegistry().back().get();
+        }
+
+        return *threadStatistics;
+    }
+
+public:
+    static const bool enabled = true;
+
+    CountingStatistics() : statistics(GetThreadStatistics()) {
+
+    }
+
+    inline void Compared(const COMPARISON_RULE rule, const bool replaced) {
+        statistics.comparisons[rule]++;
+        statistics.comparisonReplacements[rule] += replaced;
+    }
+
+    inline void Imported(const uint8_t relationshipPriority, const uint32_t replaced) {
+        statistics.relationshipReplacements[relationshipPriority] += replaced;
+    }
+
+    inline void Seeded(const SEEDING_RULE rule, const bool replaced) {
+        statistics.seedingDecisions[rule]++;
+        statistics.seedingReplacements[rule] += replaced;
+    }
+
+    /**
+     * @return everything the calling thread counted so far
+     */
+    static PropagationStatistics ReadThread() {
+        return GetThreadStatistics();
+    }
+
+    /**
+     * Only exact while no other thread is counting (e.g. between two ThreadPool::ParallelFor)
+     *
+     * @return everything every thread counted so far
+     */
+    static PropagationStatistics ReadAllThreads() {
+        std::lock_guard<std::mutex> lock(GetRegistryMutex());
+
+        PropagationStatistics total;
+        for (auto &threadStatistics : GetRegistry())
+            total.Add(*threadStatistics);
+
+        return total;
+    }
+};
+
+#ifdef BGPX_STATISTICS
+typedef CountingStatistics DefaultStatistics;
+#else
+typedef NoStatistics DefaultStatistics;
+#endif
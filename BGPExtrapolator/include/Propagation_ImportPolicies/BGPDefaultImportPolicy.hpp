@@ -3,6 +3,8 @@
 #include <array>
 
 #include "PropagationImportPolicy.hpp"
+#include "Graphs/RibOverlay.hpp"
+#include "PropagationStatistics.hpp"
 
 /**
  * The BGP policy is the vanilla behvior of an AS during propagation.
@@ -10,22 +12,56 @@
 class BGPPolicy final : public PropagationImportPolicy {
 public:
 protected:
-    void ProcessRelationship(Graph& graph, const ASN_ASNID_PAIR &neighbor, const uint8_t& relationshipPriority) {
+    /**
+     * Imports the announcements of one neighbor over a range of prefixes.
+     * The rib view is either the Graph itself or a RibOverlay on top of it; both expose the same accessors.
+     * Decisions are counted by the statistics policy (see PropagationStatistics.hpp), by default nothing is counted.
+     * With a stride, only every stride-th prefix from prefixBegin is imported (a single lane, see Graph::SeedBlock with lanes).
+     */
+    template <typename RibView, typename Statistics = DefaultStatistics>
+    inline uint32_t ProcessRelationship(RibView& view, const ASN_ASNID_PAIR &neighbor, const uint8_t& relationshipPriority, const uint32_t prefixBegin, const uint32_t prefixEnd, const uint32_t stride = 1) {
         ASN_ID neighborID = neighbor.id;
         ASN neighborASN = neighbor.asn;
+        uint32_t replaced = 0;
+        Statistics statistics;
 
-        const auto numPrefixes = graph.GetNumPrefixes();
-        for (uint32_t i = 0; i < numPrefixes; i++) {
-            AnnouncementCachedData& currentAnnouncement = graph.GetCachedData(asnID, i);
-            AnnouncementCachedData& sendingAnnouncement = graph.GetCachedData(neighborID, i);
+        for (uint32_t i = prefixBegin; i < prefixEnd; i += stride) {
+            AnnouncementCachedData& currentAnnouncement = view.GetCachedData(asnID, i);
+            const AnnouncementCachedData& sendingAnnouncement = view.GetCachedData_ReadOnly(neighborID, i);
 
-            if (CompareAnnouncements(graph, currentAnnouncement, neighborASN, sendingAnnouncement, relationshipPriority)) {
+            if (CompareAnnouncements(view, currentAnnouncement, neighborASN, sendingAnnouncement, relationshipPriority, statistics)) {
                 currentAnnouncement.SetPathLength(sendingAnnouncement.GetPathLength() + 1);
                 currentAnnouncement.SetRecievedFromID(neighborID);
                 currentAnnouncement.SetRelationship(relationshipPriority);
                 currentAnnouncement.SetStaticDataIndex(sendingAnnouncement.GetStaticDataIndex());
+                replaced++;
             }
         }
+
+        statistics.Imported(relationshipPriority, replaced);
+        return replaced;
+    }
+
+    template <typename RibView, typename Statistics = DefaultStatistics>
+    inline uint32_t StageRelationship(const RibView& view, const ASN_ASNID_PAIR &neighbor, const uint8_t& relationshipPriority, AnnouncementCachedData *staging, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        uint32_t replaced = 0;
+        Statistics statistics;
+
+        for (uint32_t i = prefixBegin; i < prefixEnd; i++) {
+            AnnouncementCachedData& currentAnnouncement = staging[i - prefixBegin];
+            const AnnouncementCachedData& sendingAnnouncement = view.GetCachedData_ReadOnly(neighbor.id, i);
+
+            if (CompareAnnouncements(view, currentAnnouncement, neighbor.asn, sendingAnnouncement, relationshipPriority, statistics)) {
+                currentAnnouncement.SetPathLength(sendingAnnouncement.GetPathLength() + 1);
+                currentAnnouncement.SetRecievedFromID(neighbor.id);
+                currentAnnouncement.SetRelationship(relationshipPriority);
+                currentAnnouncement.SetStaticDataIndex(sendingAnnouncement.GetStaticDataIndex());
+                replaced++;
+            }
+        }
+
+        statistics.Imported(relationshipPriority, replaced);
+        return replaced;
     }
 
 public:
@@ -35,58 +71,117 @@ public:
 
     /**
      * Compares two announcements and returns whether the sender announcement should replace the reciever announcement in the reciever's local rib.
+     * The rule that decided is reported to the statistics policy.
      * 
-     * @param graph 
+     * @param view -> Graph or RibOverlay, used to look up static data and ASNs
      * @param recieverAnnouncement 
      * @param sender 
      * @param senderAnnouncement 
      * @param relationshipPriority 
+     * @param statistics -> Statistics policy instance counting the decisions
      * @return (true) if the sending announcement should replace the current announcement. False if it should not.
     */
-    inline bool CompareAnnouncements(const Graph& graph, const AnnouncementCachedData& currentAnnouncement, const ASN neighborASN, const AnnouncementCachedData& sendingAnnouncement, const uint8_t& relationshipPriority) {
-        if (sendingAnnouncement.isDefaultState() || currentAnnouncement.isSeeded())
+    template <typename RibView, typename Statistics>
+    inline bool CompareAnnouncements(const RibView& graph, const AnnouncementCachedData& currentAnnouncement, const ASN neighborASN, const AnnouncementCachedData& sendingAnnouncement, const uint8_t& relationshipPriority, Statistics &statistics) {
+        if (sendingAnnouncement.isDefaultState()) {
+            statistics.Compared(COMPARISON_RULE_NOTHING_SENT, false);
             return false;
+        }
 
-        if (currentAnnouncement.isDefaultState())
-            return true;
+        if (currentAnnouncement.isSeeded()) {
+            statistics.Compared(COMPARISON_RULE_SEEDED, false);
+            return false;
+        }
 
-        if (relationshipPriority > currentAnnouncement.GetRelationship()) {
+        if (currentAnnouncement.isDefaultState()) {
+            statistics.Compared(COMPARISON_RULE_NOTHING_HELD, true);
             return true;
-        } else if (relationshipPriority == currentAnnouncement.GetRelationship()) {
-            if (sendingAnnouncement.GetPathLength() + 1 < currentAnnouncement.GetPathLength()) {
-                return true;
-            } else if (sendingAnnouncement.GetPathLength() + 1 == currentAnnouncement.GetPathLength()) {
-                int64_t sendingTimestamp = graph.GetStaticData_ReadOnly(sendingAnnouncement.GetStaticDataIndex()).timestamp;
-                int64_t currentTimestamp = graph.GetStaticData_ReadOnly(currentAnnouncement.GetStaticDataIndex()).timestamp;
-
-                if (sendingTimestamp > currentTimestamp) {
-                    return true;
-                } else if (sendingTimestamp == currentTimestamp) {
-                    ASN asnToCompare;
-                    if (currentAnnouncement.GetRecievedFromID() == asnID && currentAnnouncement.GetPathLength() == 2)
-                        asnToCompare = graph.GetStaticData_ReadOnly(currentAnnouncement.GetStaticDataIndex()).originASN;
-                    else
-                        asnToCompare = graph.GetASN(currentAnnouncement.GetRecievedFromID());
-
-                    return neighborASN < asnToCompare;
-                }
-            }
         }
 
-        return false;
+        if (relationshipPriority != currentAnnouncement.GetRelationship()) {
+            bool replace = relationshipPriority > currentAnnouncement.GetRelationship();
+            statistics.Compared(COMPARISON_RULE_RELATIONSHIP, replace);
+            return replace;
+        }
+
+        if (sendingAnnouncement.GetPathLength() + 1 != currentAnnouncement.GetPathLength()) {
+            bool replace = sendingAnnouncement.GetPathLength() + 1 < currentAnnouncement.GetPathLength();
+            statistics.Compared(COMPARISON_RULE_PATH_LENGTH, replace);
+            return replace;
+        }
+
+        int64_t sendingTimestamp = graph.GetStaticData_ReadOnly(sendingAnnouncement.GetStaticDataIndex()).timestamp;
+        int64_t currentTimestamp = graph.GetStaticData_ReadOnly(currentAnnouncement.GetStaticDataIndex()).timestamp;
+
+        if (sendingTimestamp != currentTimestamp) {
+            bool replace = sendingTimestamp > currentTimestamp;
+            statistics.Compared(COMPARISON_RULE_TIMESTAMP, replace);
+            return replace;
+        }
+
+        ASN asnToCompare;
+        if (currentAnnouncement.GetRecievedFromID() == asnID && currentAnnouncement.GetPathLength() == 2)
+            asnToCompare = graph.GetStaticData_ReadOnly(currentAnnouncement.GetStaticDataIndex()).originASN;
+        else
+            asnToCompare = graph.GetASN(currentAnnouncement.GetRecievedFromID());
+
+        bool replace = neighborASN < asnToCompare;
+        statistics.Compared(COMPARISON_RULE_ASN, replace);
+        return replace;
     }
 
-    virtual void ProcessProviderAnnouncements(Graph& graph, const ASN_ASNID_PAIR &provider) {
-        ProcessRelationship(graph, provider, RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER);
+    /**
+     * Same as above, counting nothing
+     */
+    template <typename RibView>
+    inline bool CompareAnnouncements(const RibView& graph, const AnnouncementCachedData& currentAnnouncement, const ASN neighborASN, const AnnouncementCachedData& sendingAnnouncement, const uint8_t& relationshipPriority) {
+        NoStatistics statistics;
+        return CompareAnnouncements(graph, currentAnnouncement, neighborASN, sendingAnnouncement, relationshipPriority, statistics);
     }
 
-    virtual void ProcessPeerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &peer) {
-        ProcessRelationship(graph, peer, RELATIONSHIP_PRIORITY_PEER_TO_PEER);
+    virtual uint32_t ProcessProviderAnnouncements(Graph& graph, const ASN_ASNID_PAIR &provider, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        return ProcessRelationship(graph, provider, RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER, prefixBegin, prefixEnd);
     }
 
-    virtual void ProcessCustomerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &customer) {
+    virtual uint32_t ProcessPeerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &peer, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        return ProcessRelationship(graph, peer, RELATIONSHIP_PRIORITY_PEER_TO_PEER, prefixBegin, prefixEnd);
+    }
+
+    virtual uint32_t StagePeerAnnouncements(const Graph& graph, const ASN_ASNID_PAIR &peer, AnnouncementCachedData *staging, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        return StageRelationship(graph, peer, RELATIONSHIP_PRIORITY_PEER_TO_PEER, staging, prefixBegin, prefixEnd);
+    }
+
+    virtual uint32_t ProcessCustomerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &customer, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        // Lanes that disagree on the customer's preferences are imported one at a time
+        if (graph.IsLaneDependentCustomer(customer.asn)) {
+            uint32_t replaced = 0;
+            for (size_t lane = 0; lane < graph.GetNumLanes(); lane++) {
+                if (graph.IsPrefferedProvider(asn, customer.asn, lane))
+                    replaced += ProcessRelationship(graph, customer, RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER, graph.GetLaneBegin(prefixBegin, lane), prefixEnd, graph.GetNumLanes());
+            }
+
+            return replaced;
+        }
+
         // See if there is a restriction on the customer's prop up
         if (graph.IsPrefferedProvider(asn, customer.asn))
-            ProcessRelationship(graph, customer, RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER);
+            return ProcessRelationship(graph, customer, RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER, prefixBegin, prefixEnd);
+
+        return 0;
+    }
+
+    virtual uint32_t ProcessProviderAnnouncements(RibOverlay& overlay, const ASN_ASNID_PAIR &provider, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        return ProcessRelationship(overlay, provider, RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER, prefixBegin, prefixEnd);
+    }
+
+    virtual uint32_t StagePeerAnnouncements(const RibOverlay& overlay, const ASN_ASNID_PAIR &peer, AnnouncementCachedData *staging, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        return StageRelationship(overlay, peer, RELATIONSHIP_PRIORITY_PEER_TO_PEER, staging, prefixBegin, prefixEnd);
+    }
+
+    virtual uint32_t ProcessCustomerAnnouncements(RibOverlay& overlay, const ASN_ASNID_PAIR &customer, const uint32_t prefixBegin, const uint32_t prefixEnd) {
+        if (overlay.GetBaseline().IsPrefferedProvider(asn, customer.asn))
+            return ProcessRelationship(overlay, customer, RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER, prefixBegin, prefixEnd);
+
+        return 0;
     }
 };
@@ -2,6 +2,8 @@
 
 #include "Graphs/Graph.hpp"
 
+class RibOverlay;
+
 class PropagationImportPolicy {
 public:
     const ASN asn;
@@ -14,27 +16,63 @@ public:
     /**
      * Compares the local rib of this AS with its providers and copies any announcements that are "better"
      * Path length priority should be adjusted to represent the hop from one AS to another.
+     * Only the prefix block IDs in [prefixBegin, prefixEnd) are considered.
      * 
      * @param graph 
      * @param providers 
+     * @param prefixBegin
+     * @param prefixEnd
+     * @return the number of announcements replaced
     */
-    virtual void ProcessProviderAnnouncements(Graph &graph, const ASN_ASNID_PAIR &provider) = 0;
+    virtual uint32_t ProcessProviderAnnouncements(Graph &graph, const ASN_ASNID_PAIR &provider, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
     
     /**
      * Compares the local rib of this AS with its peers and copies any announcements that are "better"
      * Path length priority should be adjusted to represent the hop from one AS to another.
      *
+     * Only the prefix block IDs in [prefixBegin, prefixEnd) are considered.
+     *
      * @param graph
      * @param peers
+     * @param prefixBegin
+     * @param prefixEnd
+     * @return the number of announcements replaced
     */
-    virtual void ProcessPeerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &peer) = 0;
+    virtual uint32_t ProcessPeerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &peer, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
+
+    /**
+     * Same comparison as ProcessPeerAnnouncements, but the winners are written into a staging buffer rather than the local rib of this AS.
+     * The graph is only read, so every AS may stage its peer imports at the same time against the same snapshot.
+     * The staging buffer is expected to start as a copy of this AS's local rib over [prefixBegin, prefixEnd).
+     *
+     * @param graph
+     * @param peer
+     * @param staging -> Buffer holding (prefixEnd - prefixBegin) announcements, index 0 corresponds to prefixBegin
+     * @param prefixBegin -> First prefix block ID to consider
+     * @param prefixEnd -> One past the last prefix block ID to consider
+     * @return the number of announcements replaced in the staging buffer
+    */
+    virtual uint32_t StagePeerAnnouncements(const Graph& graph, const ASN_ASNID_PAIR &peer, AnnouncementCachedData *staging, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
     
     /**
      * Compares the local rib of this AS with its customers and copies any announcements that are "better"
      * Path length priority should be adjusted to represent the hop from one AS to another.
      *
+     * Only the prefix block IDs in [prefixBegin, prefixEnd) are considered.
+     *
      * @param graph
      * @param customers
+     * @param prefixBegin
+     * @param prefixEnd
+     * @return the number of announcements replaced
+    */
+    virtual uint32_t ProcessCustomerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &customer, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
+
+    /**
+     * Overlay versions of the above, used by what-if scenarios (Graph::RunScenario).
+     * The local ribs of the baseline graph are never modified, every write goes to the copy-on-write columns of the overlay.
     */
-    virtual void ProcessCustomerAnnouncements(Graph& graph, const ASN_ASNID_PAIR &customer) = 0;
+    virtual uint32_t ProcessProviderAnnouncements(RibOverlay& overlay, const ASN_ASNID_PAIR &provider, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
+    virtual uint32_t StagePeerAnnouncements(const RibOverlay& overlay, const ASN_ASNID_PAIR &peer, AnnouncementCachedData *staging, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
+    virtual uint32_t ProcessCustomerAnnouncements(RibOverlay& overlay, const ASN_ASNID_PAIR &customer, const uint32_t prefixBegin, const uint32_t prefixEnd) = 0;
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+/**
+ * Measures wall clock time from its construction (or the last Restart)
+ */
+class Stopwatch {
+private:
+    std::chrono::steady_clock::time_point start;
+
+public:
+    Stopwatch() : start(std::chrono::steady_clock::now()) {
+
+    }
+
+    inline void Restart() { start = std::chrono::steady_clock::now(); }
+
+    inline double ElapsedMilliseconds() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/**
+ * A machine readable report of a run: timings, throughput and memory, written as JSON next to the results so runs can be compared.
+ * The report is a plain JSON object, sections are filled in by whoever has the numbers.
+ */
+class RunReport {
+private:
+    nlohmann::json report;
+
+public:
+    /**
+     * Records the time a phase took
+     *
+     * @param phase -> Name of the phase
+     * @param milliseconds -> Time taken
+     */
+    inline void AddTiming(const std::string &phase, const double milliseconds) {
+        report["timings_ms"][phase] = milliseconds;
+    }
+
+    inline nlohmann::json& operator[](const std::string &section) { return report[section]; }
+
+    /**
+     * @return the peak resident set size of the process so far, 0 if unknown
+     */
+    static inline size_t GetPeakRSSBytes() {
+#ifndef _WIN32
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+            return usage.ru_maxrss;
+#else
+            return usage.ru_maxrss * 1024;
+#endif
+        }
+#endif
+        return 0;
+    }
+
+    /**
+     * @param filePath -> File to write the report to, replaced if it exists
+     * @return false if the file could not be written
+     */
+    bool Write(const std::string &filePath) const {
+        std::ofstream file(filePath);
+        if (!file.is_open()) {
+            std::cout << "Could not open the run report for writing: " << filePath << std::endl;
+            return false;
+        }
+
+        file << report.dump(4) << std::endl;
+        return file.good();
+    }
+};
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "Graphs/Graph.hpp"
+#include "RunReport.hpp"
+
+/**
+ * Starts and waits for the worker processes of a sharded run. The coordinator only hands over a launch file and a log file,
+ *  so a transport that runs the workers elsewhere (e.g. on other nodes of a cluster, with a shared output folder) can be plugged in.
+ */
+class WorkerTransport {
+public:
+    virtual ~WorkerTransport() { }
+
+    /**
+     * Starts a worker running the extrapolator on the given launch file
+     *
+     * @param worker -> Index of the worker
+     * @param launchFilePath -> Launch configuration of the worker
+     * @param logFilePath -> Where the output of the worker goes
+     * @return false if the worker could not be started
+     */
+    virtual bool Launch(const size_t worker, const std::string &launchFilePath, const std::string &logFilePath) = 0;
+
+    /**
+     * Waits for a started worker to finish
+     *
+     * @return false if the worker failed
+     */
+    virtual bool Wait(const size_t worker) = 0;
+};
+
+/**
+ * Runs every worker as a child process of this one, on this machine. POSIX only.
+ */
+class LocalProcessTransport : public WorkerTransport {
+private:
+    std::string executablePath;
+    std::vector<long> workerPIDs;
+
+public:
+    /**
+     * @param executablePath -> The extrapolator executable, see GetCurrentExecutablePath
+     */
+    LocalProcessTransport(const std::string &executablePath);
+
+    virtual bool Launch(const size_t worker, const std::string &launchFilePath, const std::string &logFilePath);
+    virtual bool Wait(const size_t worker);
+
+    /**
+     * @param argv0 -> argv[0] of the running process, used where the executable cannot be looked up
+     * @return the path of the running executable
+     */
+    static std::string GetCurrentExecutablePath(const std::string &argv0);
+};
+
+/**
+ * Splits a run into prefix block shards, each seeded, propagated and written by its own worker process, and merges the results.
+ *
+ * The topology is loaded once (by the coordinator) and written as a checkpoint with no announcements. Every worker starts from that checkpoint
+ *  (mapped, and thus shared through the page cache, rather than parsing the relationships again) and seeds its own part of the announcements.
+ * The announcements are split into contiguous prefix_block_id ranges holding about as many rows each, and renumbered densely from 0
+ *  in every shard. Prefix blocks are independent during propagation, so the union of the shard results is the result of the whole run:
+ *  every Results*.tsv the workers write is concatenated into the file of the same name in the output folder.
+ *
+ * Working files go to <output folder>/shards/, only the logs and run reports of the workers are kept.
+ */
+class ShardCoordinator {
+private:
+    WorkerTransport &transport;
+
+public:
+    ShardCoordinator(WorkerTransport &transport);
+
+    /**
+     * Splits the rows of an announcements file by prefix_block_id range
+     *
+     * @param announcementsFilePath -> Announcements TSV
+     * @param shardFilePaths -> One announcements TSV to write per shard
+     * @param rowsPerShard -> Filled with the number of rows written to every shard
+     * @return false if a file could not be read or written, or if there is no prefix_block_id column
+     */
+    static bool SplitAnnouncements(const std::string &announcementsFilePath, const std::vector<std::string> &shardFilePaths, std::vector<size_t> &rowsPerShard);
+
+    /**
+     * Concatenates results files, keeping the header of the first one only
+     *
+     * @return the number of bytes written, 0 if a file could not be read or written
+     */
+    static size_t ConcatenateResults(const std::vector<std::string> &shardFilePaths, const std::string &resultsFilePath);
+
+    /**
+     * Runs the experiment of a launch configuration over the given number of workers
+     *
+     * @param launchJSON -> Launch configuration of the whole run (announcements, output folder, options passed on to the workers).
+     *  The memory_limit is shared by the workers, and each gets its own rib_backing_file in its shard folder
+     * @param graph -> The loaded topology, nothing seeded
+     * @param announcementsFilePath -> Announcements of the whole run
+     * @param outputFolder -> Output folder of the run, ending with a path separator
+     * @param numWorkers -> Number of shards / worker processes
+     * @param report -> Filled in with the timings and shards of the run
+     * @return false if the run failed
+     */
+    bool Run(const nlohmann::json &launchJSON, const Graph &graph, const std::string &announcementsFilePath, const std::string &outputFolder,
+        const size_t numWorkers, RunReport &report);
+};
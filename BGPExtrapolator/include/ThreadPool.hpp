@@ -0,0 +1,130 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/**
+ * A small pool of persistent worker threads for the data-parallel phases of the extrapolator.
+ *
+ * Work is handed out as a single range that is split into one contiguous chunk per thread (static partitioning).
+ * The calling thread participates as thread 0, so a pool of 1 thread runs everything inline with no synchronization.
+ * Threads are created once and reused, so there is no thread creation cost per phase.
+ */
+class ThreadPool {
+public:
+    /**
+     * Called for every chunk of the range
+     *
+     * @param threadIndex -> Index of the thread running the chunk [0, numThreads)
+     * @param begin -> First index of the chunk
+     * @param end -> One past the last index of the chunk
+     */
+    typedef std::function<void(size_t threadIndex, size_t begin, size_t end)> RangeFunction;
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+
+    // Incremented every time new work is posted, workers compare against the last generation they ran
+    size_t generation;
+    size_t workersRemaining;
+    bool stopping;
+
+    const RangeFunction *currentFunction;
+    size_t currentBegin, currentEnd;
+
+    inline void RunChunk(const size_t threadIndex) {
+        size_t numThreads = GetNumThreads();
+        size_t length = currentEnd - currentBegin;
+        size_t chunkBegin = currentBegin + (length * threadIndex) / numThreads;
+        size_t chunkEnd = currentBegin + (length * (threadIndex + 1)) / numThreads;
+
+        if (chunkBegin < chunkEnd)
+            (*currentFunction)(threadIndex, chunkBegin, chunkEnd);
+    }
+
+    void WorkerLoop(const size_t threadIndex) {
+        size_t lastGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&] { return stopping || generation != lastGeneration; });
+                if (stopping)
+                    return;
+
+                lastGeneration = generation;
+            }
+
+            RunChunk(threadIndex);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--workersRemaining == 0)
+                workFinished.notify_one();
+        }
+    }
+
+public:
+    ThreadPool(size_t numThreads) : generation(0), workersRemaining(0), stopping(false), currentFunction(nullptr), currentBegin(0), currentEnd(0) {
+        if (numThreads == 0)
+            numThreads = 1;
+
+        for (size_t i = 1; i < numThreads; i++)
+            workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        workAvailable.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    inline size_t GetNumThreads() const { return workers.size() + 1; }
+
+    /**
+     * Splits [begin, end) into one contiguous chunk per thread and blocks until every chunk has been processed.
+     * Chunk boundaries only depend on the range and the number of threads, so a given thread always sees the same chunk for the same range.
+     *
+     * @param begin -> First index of the range
+     * @param end -> One past the last index of the range
+     * @param function -> Called once per non-empty chunk
+     */
+    void ParallelFor(const size_t begin, const size_t end, const RangeFunction &function) {
+        if (begin >= end)
+            return;
+
+        currentFunction = &function;
+        currentBegin = begin;
+        currentEnd = end;
+
+        if (workers.empty()) {
+            RunChunk(0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            workersRemaining = workers.size();
+            generation++;
+        }
+        workAvailable.notify_all();
+
+        RunChunk(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        workFinished.wait(lock, [&] { return workersRemaining == 0; });
+    }
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+/**
+ * Timeline tracing of the pipeline: the begin and end of every phase, rank, tile and shard, exported as Chrome trace event JSON
+ *  (open it in chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Only compiled in with BGPX_TRACE defined (the BGPX_TRACE CMake option). Otherwise every BGPX_TRACE_* macro expands to nothing,
+ *  so the instrumented code is exactly the uninstrumented code.
+ *
+ * BGPX_TRACE_SCOPE(name, category)                  -> Records the enclosing scope
+ * BGPX_TRACE_SCOPE_ARG(name, category, arg, value)  -> Same, with one integer argument shown with the event (rank, tile, ...)
+ * BGPX_TRACE_BEGIN(span, name, category)            -> Starts a span that is not a scope ...
+ * BGPX_TRACE_END(span)                              -> ... and ends it
+ *
+ * Names, categories and argument names must be string literals (only the pointers are kept).
+ */
+
+#ifdef BGPX_TRACE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    const char *argName;
+    int64_t argValue;
+    uint64_t beginNanoseconds;
+    uint64_t endNanoseconds;
+};
+
+/**
+ * Keeps the most recent events of every thread in a ring buffer of its own, so recording is a few stores with no locking or allocation
+ *  (a thread's buffer is allocated, under a lock, the first time it records). Once a buffer is full the oldest events are overwritten.
+ *
+ * Events are recorded only while enabled. Write must not be called while other threads are still recording.
+ */
+class TraceRecorder {
+private:
+    struct ThreadBuffer {
+        std::vector<TraceEvent> events;
+        uint64_t numRecorded;
+        uint32_t threadID;
+    };
+
+    std::atomic<bool> enabled;
+    std::chrono::steady_clock::time_point origin;
+    size_t eventsPerThread;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    TraceRecorder() : enabled(false), origin(std::chrono::steady_clock::now()), eventsPerThread(1 << 16) {
+
+    }
+
+    ThreadBuffer* GetThreadBuffer() {
+        static thread_local ThreadBuffer *buffer = nullptr;
+        if (buffer == nullptr) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+            buffer = buffers.back().get();
+            buffer->events.resize(eventsPerThread);
+            buffer->numRecorded = 0;
+            buffer->threadID = buffers.size() - 1;
+        }
+
+        return buffer;
+    }
+
+public:
+    static TraceRecorder& Get() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    /**
+     * Starts recording. Any events recorded before are dropped.
+     *
+     * @param eventsPerThread -> Size of the ring buffer of each thread (only for threads that have not recorded yet)
+     */
+    void Enable(const size_t eventsPerThread = 1 << 16) {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->eventsPerThread = eventsPerThread > 0 ? eventsPerThread : 1;
+        for (auto &buffer : buffers)
+            buffer->numRecorded = 0;
+
+        origin = std::chrono::steady_clock::now();
+        enabled.store(true, std::memory_order_release);
+    }
+
+    inline void Disable() { enabled.store(false, std::memory_order_release); }
+
+    inline bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    inline uint64_t Now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+    }
+
+    inline void Record(const char *name, const char *category, const char *argName, const int64_t argValue, const uint64_t beginNanoseconds) {
+        ThreadBuffer *buffer = GetThreadBuffer();
+
+        TraceEvent &event = buffer->events[buffer->numRecorded % buffer->events.size()];
+        event.name = name;
+        event.category = category;
+        event.argName = argName;
+        event.argValue = argValue;
+        event.beginNanoseconds = beginNanoseconds;
+        event.endNanoseconds = Now();
+
+        buffer->numRecorded++;
+    }
+
+    /**
+     * Writes every recorded event as Chrome trace event JSON (complete "X" events, timestamps in microseconds), one track per thread
+     *
+     * @param filePath -> File to write, replaced if it exists
+     * @return false if the file could not be written
+     */
+    bool Write(const std::string &filePath) {
+        FILE *f = fopen(filePath.c_str(), "w");
+        if (f == nullptr)
+            return false;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+        bool first = true;
+        uint64_t numDropped = 0;
+        for (auto &buffer : buffers) {
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+                first ? "" : ",\n", buffer->threadID, buffer->threadID == 0 ? "main" : "worker", buffer->threadID);
+            first = false;
+
+            // Oldest first. Once wrapped, the oldest event is the one about to be overwritten
+            const uint64_t capacity = buffer->events.size();
+            const uint64_t numKept = std::min(buffer->numRecorded, capacity);
+            numDropped += buffer->numRecorded - numKept;
+
+            for (uint64_t i = buffer->numRecorded - numKept; i < buffer->numRecorded; i++) {
+                const TraceEvent &event = buffer->events[i % capacity];
+                fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                    event.name, event.category, buffer->threadID, event.beginNanoseconds / 1000.0,
+                    (event.endNanoseconds - event.beginNanoseconds) / 1000.0);
+
+                if (event.argName != nullptr)
+                    fprintf(f, ",\"args\":{\"%s\":%lld}", event.argName, (long long) event.argValue);
+
+                fputc('}', f);
+            }
+        }
+
+        fprintf(f, "\n],\"otherData\":{\"dropped_events\":%llu}}\n", (unsigned long long) numDropped);
+        return fclose(f) == 0;
+    }
+};
+
+/**
+ * Records the time from its construction to End (or its destruction), if the recorder was enabled when it was constructed
+ */
+class TraceSpan {
+private:
+    const char *name;
+    const char *category;
+    const char *argName;
+    int64_t argValue;
+    uint64_t beginNanoseconds;
+    bool active;
+
+public:
+    TraceSpan(const char *name, const char *category, const char *argName = nullptr, const int64_t argValue = 0)
+            : name(name), category(category), argName(argName), argValue(argValue), beginNanoseconds(0), active(TraceRecorder::Get().IsEnabled()) {
+        if (active)
+            beginNanoseconds = TraceRecorder::Get().Now();
+    }
+
+    ~TraceSpan() {
+        End();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    inline void End() {
+        if (active)
+            TraceRecorder::Get().Record(name, category, argName, argValue, beginNanoseconds);
+        active = false;
+    }
+};
+
+#define BGPX_TRACE_CONCAT_INNER(a, b) a##b
+#define BGPX_TRACE_CONCAT(a, b) BGPX_TRACE_CONCAT_INNER(a, b)
+
+#define BGPX_TRACE_SCOPE(name, category) TraceSpan BGPX_TRACE_CONCAT(traceSpan, __LINE__)(name, category)
+#define BGPX_TRACE_SCOPE_ARG(name, category, arg, value) TraceSpan BGPX_TRACE_CONCAT(traceSpan, __LINE__)(name, category, arg, value)
+#define BGPX_TRACE_BEGIN(span, name, category) TraceSpan span(name, category)
+#define BGPX_TRACE_END(span) span.End()
+
+#else
+
+#define BGPX_TRACE_SCOPE(name, category)
+#define BGPX_TRACE_SCOPE_ARG(name, category, arg, value)
+#define BGPX_TRACE_BEGIN(span, name, category)
+#define BGPX_TRACE_END(span)
+
+#endif
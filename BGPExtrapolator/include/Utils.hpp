@@ -22,5 +22,32 @@ public:
     */
     static std::vector<ASN> parseASNList(const std::string& asPathString);
 
+    /**
+     * Same as above, straight from the bytes of the cell and into a buffer of the caller, which keeps its allocation from one row to the next.
+     * Every run of digits is an ASN, so "{}" and "{ }" are empty and a prepended ASN is kept once per listing.
+     *
+     * @param begin -> First byte of the list
+     * @param end -> One past the last byte of the list
+     * @param asns -> Replaced by the ASNs of the list
+     */
+    static void parseASNList(const char* begin, const char* end, std::vector<ASN>& asns);
+
+    static inline void parseASNList(const std::string& asPathString, std::vector<ASN>& asns) {
+        parseASNList(asPathString.data(), asPathString.data() + asPathString.size(), asns);
+    }
+
     static bool ASPathContainCycle(const std::vector<ASN> &asPath);
+
+    /**
+     * Cuts a line of separated values (SEPARATED_VALUES_DELIMETER) into its cells. Quotes around a cell are dropped, as rapidcsv does.
+     *
+     * @param line -> One line, without the line ending
+     * @param cells -> Filled with the cells of the line, reusing the strings already in it
+     */
+    static void splitSeparatedValues(const std::string& line, std::vector<std::string>& cells);
+
+    /**
+     * @return the index of the cell with the given name in a header row, -1 if there is none
+     */
+    static int findColumn(const std::vector<std::string>& header, const std::string& name);
 };
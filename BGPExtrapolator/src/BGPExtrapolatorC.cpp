@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <exception>
+#include <type_traits>
+
+#include "BGPExtrapolatorC.h"
+#include "Graphs/Graph.hpp"
+#include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
+
+struct bgpx_graph {
+    std::unique_ptr<Graph> graph;
+};
+
+// The rib rows are handed out as they are, so the C struct has to be the same as the cells
+static_assert(sizeof(bgpx_rib_cell) == sizeof(AnnouncementCachedData) && std::is_standard_layout<AnnouncementCachedData>::value,
+    "bgpx_rib_cell must be laid out like AnnouncementCachedData");
+
+static thread_local std::string lastError;
+
+static bgpx_status Fail(const bgpx_status status, const std::string &error) {
+    lastError = error;
+    return status;
+}
+
+/**
+ * Runs the body of an API call, turning any exception (rapidcsv, allocation) into a status
+ */
+template <typename Body>
+static bgpx_status Guard(Body body) {
+    lastError.clear();
+    try {
+        return body();
+    } catch (const std::exception &e) {
+        return Fail(BGPX_ERROR_INTERNAL, e.what());
+    } catch (...) {
+        return Fail(BGPX_ERROR_INTERNAL, "Unknown error");
+    }
+}
+
+static bool IsReadable(const char *filePath) {
+    FILE *f = filePath == nullptr ? nullptr : fopen(filePath, "rb");
+    if (f == nullptr)
+        return false;
+
+    fclose(f);
+    return true;
+}
+
+static bgpx_status ToSeedingConfiguration(const bgpx_seeding_config *config, SeedingConfiguration &seedingConfig) {
+    if (config == nullptr)
+        return BGPX_OK;
+
+    if (config->timestamp_comparison < BGPX_TIMESTAMP_DISABLED || config->timestamp_comparison > BGPX_TIMESTAMP_PREFER_OLDER)
+        return Fail(BGPX_ERROR_INVALID_ARGUMENT, "Unknown timestamp comparison method");
+    if (config->tiebraking_method != BGPX_TIEBRAKING_RANDOM && config->tiebraking_method != BGPX_TIEBRAKING_PREFER_LOWEST_ASN)
+        return Fail(BGPX_ERROR_INVALID_ARGUMENT, "Unknown tiebraking method");
+
+    seedingConfig.originOnly = config->origin_only != 0;
+    seedingConfig.timestampComparison = (TIMESTAMP_COMPARISON) config->timestamp_comparison;
+    seedingConfig.tiebrakingMethod = (TIEBRAKING_METHOD) config->tiebraking_method;
+    return BGPX_OK;
+}
+
+static bgpx_status Created(std::unique_ptr<Graph> graph, bgpx_graph **handle) {
+    if (graph->GetNumASes() == 0)
+        return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No ASes in the relationships");
+
+    *handle = new bgpx_graph();
+    (*handle)->graph = std::move(graph);
+    return BGPX_OK;
+}
+
+int bgpx_api_version(void) {
+    return BGPX_API_VERSION;
+}
+
+const char* bgpx_last_error(void) {
+    return lastError.c_str();
+}
+
+//***** Building and loading
+
+bgpx_status bgpx_graph_create(const char *relationships_file, int stub_removal, size_t num_threads, bgpx_graph **graph) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph to set");
+        *graph = nullptr;
+
+        if (!IsReadable(relationships_file))
+            return Fail(BGPX_ERROR_IO, std::string("Could not open the relationships file: ") + (relationships_file == nullptr ? "" : relationships_file));
+
+        return Created(std::unique_ptr<Graph>(new Graph(relationships_file, std::unordered_map<ASN, std::vector<ASN>>(), stub_removal != 0, num_threads)), graph);
+    });
+}
+
+bgpx_status bgpx_graph_create_from_relationships(const bgpx_relationship *relationships, size_t num_relationships, int stub_removal, bgpx_graph **graph) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr || (relationships == nullptr && num_relationships > 0))
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No relationships or graph given");
+        *graph = nullptr;
+
+        std::vector<RelationshipInfo> relationshipInfo;
+        relationshipInfo.reserve(num_relationships);
+        for (size_t i = 0; i < num_relationships; i++) {
+            const bgpx_relationship &relationship = relationships[i];
+            if (stub_removal && relationship.stub)
+                continue;
+
+            if (relationship.propagation_rank < 0)
+                return Fail(BGPX_ERROR_INVALID_ARGUMENT, "Negative propagation rank of AS " + std::to_string(relationship.asn));
+
+            RelationshipInfo info;
+            info.asn = relationship.asn;
+            info.rank = relationship.propagation_rank;
+            if (relationship.providers != nullptr)
+                info.providers.assign(relationship.providers, relationship.providers + relationship.num_providers);
+            if (relationship.peers != nullptr)
+                info.peers.assign(relationship.peers, relationship.peers + relationship.num_peers);
+            if (relationship.customers != nullptr)
+                info.customers.assign(relationship.customers, relationship.customers + relationship.num_customers);
+            if (relationship.stubs != nullptr)
+                info.stubs.assign(relationship.stubs, relationship.stubs + relationship.num_stubs);
+            relationshipInfo.push_back(std::move(info));
+        }
+
+        return Created(std::unique_ptr<Graph>(new Graph(std::move(relationshipInfo), std::unordered_map<ASN, std::vector<ASN>>(), stub_removal != 0)), graph);
+    });
+}
+
+bgpx_status bgpx_graph_load_checkpoint(const char *checkpoint_file, bgpx_graph **graph) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr || checkpoint_file == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No checkpoint file or graph given");
+        *graph = nullptr;
+
+        std::unique_ptr<Graph> loaded = Graph::LoadCheckpoint(checkpoint_file);
+        if (!loaded)
+            return Fail(BGPX_ERROR_IO, std::string("Could not load the checkpoint: ") + checkpoint_file);
+
+        *graph = new bgpx_graph();
+        (*graph)->graph = std::move(loaded);
+        return BGPX_OK;
+    });
+}
+
+bgpx_status bgpx_graph_write_checkpoint(const bgpx_graph *graph, const char *checkpoint_file) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr || checkpoint_file == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No checkpoint file or graph given");
+
+        if (!graph->graph->WriteCheckpoint(checkpoint_file))
+            return Fail(BGPX_ERROR_IO, std::string("Could not write the checkpoint: ") + checkpoint_file);
+        return BGPX_OK;
+    });
+}
+
+void bgpx_graph_destroy(bgpx_graph *graph) {
+    delete graph;
+}
+
+bgpx_status bgpx_graph_set_num_threads(bgpx_graph *graph, size_t num_threads) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph given");
+
+        graph->graph->SetNumThreads(num_threads);
+        return BGPX_OK;
+    });
+}
+
+//***** Seeding and propagation
+
+void bgpx_seeding_config_init(bgpx_seeding_config *config) {
+    if (config == nullptr)
+        return;
+
+    SeedingConfiguration defaults;
+    config->origin_only = defaults.originOnly;
+    config->timestamp_comparison = (bgpx_timestamp_comparison) defaults.timestampComparison;
+    config->tiebraking_method = (bgpx_tiebraking_method) defaults.tiebrakingMethod;
+}
+
+bgpx_status bgpx_graph_seed(bgpx_graph *graph, const bgpx_announcement *announcements, size_t num_announcements, uint32_t num_prefix_blocks,
+        const bgpx_seeding_config *config) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr || (announcements == nullptr && num_announcements > 0))
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No announcements or graph given");
+
+        SeedingConfiguration seedingConfig;
+        bgpx_status status = ToSeedingConfiguration(config, seedingConfig);
+        if (status != BGPX_OK)
+            return status;
+
+        std::vector<ScenarioAnnouncement> parsed(num_announcements);
+        for (size_t i = 0; i < num_announcements; i++) {
+            const bgpx_announcement &announcement = announcements[i];
+            if (announcement.prefix_block_id >= num_prefix_blocks)
+                return Fail(BGPX_ERROR_INVALID_ARGUMENT, "Prefix block ID " + std::to_string(announcement.prefix_block_id) + " is not below the number of prefix blocks");
+            if (announcement.as_path == nullptr || announcement.as_path_length == 0)
+                return Fail(BGPX_ERROR_INVALID_ARGUMENT, "Empty AS path in announcement " + std::to_string(i));
+
+            parsed[i].asPath.assign(announcement.as_path, announcement.as_path + announcement.as_path_length);
+            parsed[i].prefixString = announcement.prefix == nullptr ? "" : announcement.prefix;
+            parsed[i].timestamp = announcement.timestamp;
+            parsed[i].prefix.global_id = announcement.prefix_id;
+            parsed[i].prefix.block_id = announcement.prefix_block_id;
+        }
+
+        graph->graph->SeedBlock(parsed, num_prefix_blocks, seedingConfig);
+        return BGPX_OK;
+    });
+}
+
+bgpx_status bgpx_graph_seed_file(bgpx_graph *graph, const char *announcements_file, const bgpx_seeding_config *config) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph given");
+        if (!IsReadable(announcements_file))
+            return Fail(BGPX_ERROR_IO, std::string("Could not open the announcements file: ") + (announcements_file == nullptr ? "" : announcements_file));
+
+        SeedingConfiguration seedingConfig;
+        bgpx_status status = ToSeedingConfiguration(config, seedingConfig);
+        if (status != BGPX_OK)
+            return status;
+
+        graph->graph->SeedBlock(announcements_file, seedingConfig);
+        return BGPX_OK;
+    });
+}
+
+bgpx_status bgpx_graph_propagate(bgpx_graph *graph) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr)
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph given");
+
+        graph->graph->Propagate();
+        return BGPX_OK;
+    });
+}
+
+//***** Reading the local ribs
+
+size_t bgpx_graph_num_ases(const bgpx_graph *graph) {
+    return graph == nullptr ? 0 : graph->graph->GetNumASes();
+}
+
+size_t bgpx_graph_num_prefix_blocks(const bgpx_graph *graph) {
+    return graph == nullptr ? 0 : graph->graph->GetNumPrefixes();
+}
+
+bgpx_status bgpx_graph_asn_to_id(const bgpx_graph *graph, uint32_t asn, uint32_t *id) {
+    lastError.clear();
+    if (graph == nullptr || id == nullptr)
+        return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph or ID given");
+    if (!graph->graph->ContainsASN(asn))
+        return Fail(BGPX_ERROR_NOT_FOUND, "AS " + std::to_string(asn) + " has no local rib");
+
+    *id = graph->graph->GetASNID(asn);
+    return BGPX_OK;
+}
+
+uint32_t bgpx_graph_id_to_asn(const bgpx_graph *graph, uint32_t id) {
+    lastError.clear();
+    if (graph == nullptr || id >= graph->graph->GetNumASes())
+        return 0;
+
+    return graph->graph->GetASN(id);
+}
+
+const bgpx_rib_cell* bgpx_graph_rib_row(const bgpx_graph *graph, uint32_t id, uint32_t prefix_block_id, size_t *count) {
+    lastError.clear();
+    if (count != nullptr)
+        *count = 0;
+    if (graph == nullptr || count == nullptr || id >= graph->graph->GetNumASes() || prefix_block_id >= graph->graph->GetNumPrefixes())
+        return nullptr;
+
+    return reinterpret_cast<const bgpx_rib_cell*>(graph->graph->GetRibRow(id, prefix_block_id, *count));
+}
+
+bgpx_status bgpx_graph_announcement(const bgpx_graph *graph, uint32_t static_data_index, bgpx_announcement_data *announcement) {
+    lastError.clear();
+    if (graph == nullptr || announcement == nullptr)
+        return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph or announcement given");
+    if (static_data_index >= graph->graph->GetNumStaticData())
+        return Fail(BGPX_ERROR_NOT_FOUND, "No announcement " + std::to_string(static_data_index));
+
+    const AnnouncementStaticData &staticData = graph->graph->GetStaticData_ReadOnly(static_data_index);
+    announcement->prefix = staticData.prefixString.c_str();
+    announcement->origin_asn = staticData.originASN;
+    announcement->timestamp = staticData.timestamp;
+    announcement->prefix_id = staticData.prefix.global_id;
+    announcement->prefix_block_id = staticData.prefix.block_id;
+    return BGPX_OK;
+}
+
+bgpx_status bgpx_graph_traceback(const bgpx_graph *graph, uint32_t asn, uint32_t prefix_block_id, uint32_t *path, size_t capacity, size_t *path_length) {
+    return Guard([&]() -> bgpx_status {
+        if (path_length != nullptr)
+            *path_length = 0;
+        if (graph == nullptr || path_length == nullptr || (path == nullptr && capacity > 0))
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph, path or path length given");
+
+        QueriedRoute route;
+        if (!graph->graph->QueryRoute(asn, prefix_block_id, route))
+            return Fail(BGPX_ERROR_NOT_FOUND, "AS " + std::to_string(asn) + " has no route for prefix block " + std::to_string(prefix_block_id));
+
+        *path_length = route.asPath.size();
+        std::copy(route.asPath.begin(), route.asPath.begin() + std::min(capacity, route.asPath.size()), path);
+        if (capacity < route.asPath.size())
+            return Fail(BGPX_ERROR_BUFFER_TOO_SMALL, "The AS path has " + std::to_string(route.asPath.size()) + " ASes");
+        return BGPX_OK;
+    });
+}
+
+bgpx_status bgpx_graph_write_results(bgpx_graph *graph, const char *results_file, const uint32_t *asns, size_t num_asns) {
+    return Guard([&]() -> bgpx_status {
+        if (graph == nullptr || results_file == nullptr || (asns == nullptr && num_asns > 0))
+            return Fail(BGPX_ERROR_INVALID_ARGUMENT, "No graph, results file or ASes given");
+
+        size_t bytesWritten;
+        if (!graph->graph->GenerateTracebackResultsCSV(results_file, std::vector<ASN>(asns, asns + num_asns), bytesWritten))
+            return Fail(BGPX_ERROR_IO, std::string("Could not write the results file: ") + results_file);
+        return BGPX_OK;
+    });
+}
@@ -0,0 +1,408 @@
+#include <benchmark/benchmark.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <iostream>
+
+#include "Benchmarks/SyntheticDataGenerator.hpp"
+#include "Graphs/Graph.hpp"
+#include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
+#include "Utils.hpp"
+
+/**
+ * Benchmarks of the extrapolator on synthetic data (see SyntheticDataGenerator).
+ *
+ * Micro benchmarks time the hot pieces on their own (announcement comparison, importing from one neighbor, AS_PATH parsing,
+ *  ASN lookups, seeding one path, traceback and the result writer), macro benchmarks time the whole pipeline at several scales.
+ * Every benchmark takes the dataset shape as arguments, so scaling curves come from e.g.
+ *  bgp_bench --benchmark_filter=BM_Pipeline --benchmark_format=json
+ *
+ * "bgp_bench --generate <prefix> <ases> <prefixes> [seed]" writes a dataset (<prefix>Relationships.tsv, <prefix>Announcements.tsv)
+ *  for use with the extrapolator itself.
+ */
+
+/**
+ * Exposes the internals the micro benchmarks drive directly
+ */
+class BenchmarkGraph : public Graph {
+public:
+    BenchmarkGraph(const std::string &relationshipsFilePath) : Graph(relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>>(), false) {
+
+    }
+
+    using Graph::SeedPath;
+
+    inline PropagationImportPolicy& GetImportPolicy(const ASN_ID asnID) { return *idToImportPolicy[asnID]; }
+    inline const std::vector<ASN_ASNID_PAIR>& GetProviders(const ASN_ID asnID) const { return asIDToProviderIDs[asnID]; }
+    inline std::vector<AnnouncementStaticData>& GetAllStaticData() { return announcementStaticData; }
+    inline const ASNTable& GetASNTable() const { return asnTable; }
+};
+
+static SeedingConfiguration GetSeedingConfiguration() {
+    SeedingConfiguration config;
+    config.originOnly = false;
+    config.timestampComparison = PREFER_NEWER;
+    config.tiebrakingMethod = PREFER_LOWEST_ASN;
+    return config;
+}
+
+static std::string GetTemporaryDirectory() {
+    const char *tmp = getenv("TMPDIR");
+    std::string directory = tmp != nullptr && tmp[0] != '\0' ? tmp : "/tmp";
+    if (directory.back() != '/')
+        directory += '/';
+    return directory;
+}
+
+struct Dataset {
+    std::string relationshipsFilePath;
+    std::string announcementsFilePath;
+};
+
+/**
+ * Writes the dataset of the given shape once per process (and reuses it for every benchmark of that shape)
+ */
+static const Dataset& GetDataset(const size_t numASes, const size_t numPrefixes) {
+    static std::map<std::pair<size_t, size_t>, Dataset> datasets;
+
+    auto search = datasets.find(std::make_pair(numASes, numPrefixes));
+    if (search != datasets.end())
+        return search->second;
+
+    SyntheticDataConfiguration config;
+    config.numASes = numASes;
+    config.numPrefixes = numPrefixes;
+
+    std::string prefix = GetTemporaryDirectory() + "bgp_bench_" + std::to_string(numASes) + "_" + std::to_string(numPrefixes) + "_";
+    Dataset dataset;
+    dataset.relationshipsFilePath = prefix + "Relationships.tsv";
+    dataset.announcementsFilePath = prefix + "Announcements.tsv";
+
+    SyntheticDataGenerator generator(config);
+    if (!generator.WriteRelationships(dataset.relationshipsFilePath) || !generator.WriteAnnouncements(dataset.announcementsFilePath))
+        std::cout << "Could not write the synthetic dataset to " << prefix << "*" << std::endl;
+
+    return datasets[std::make_pair(numASes, numPrefixes)] = dataset;
+}
+
+/**
+ * A seeded and propagated graph of the given shape, built once per process
+ */
+static BenchmarkGraph& GetPropagatedGraph(const size_t numASes, const size_t numPrefixes) {
+    static std::map<std::pair<size_t, size_t>, std::unique_ptr<BenchmarkGraph>> graphs;
+
+    std::unique_ptr<BenchmarkGraph> &graph = graphs[std::make_pair(numASes, numPrefixes)];
+    if (graph == nullptr) {
+        const Dataset &dataset = GetDataset(numASes, numPrefixes);
+        graph.reset(new BenchmarkGraph(dataset.relationshipsFilePath));
+        graph->SeedBlock(dataset.announcementsFilePath, GetSeedingConfiguration());
+        graph->Propagate();
+    }
+
+    return *graph;
+}
+
+//*****Micro benchmarks
+
+static void BM_CompareAnnouncements(benchmark::State &state) {
+    BenchmarkGraph &graph = GetPropagatedGraph(state.range(0), state.range(1));
+
+    // Every AS against its first provider, over every prefix (the comparisons propagating down makes)
+    std::vector<std::pair<ASN_ID, ASN_ASNID_PAIR>> edges;
+    for (ASN_ID id = 0; id < graph.GetNumASes(); id++) {
+        if (!graph.GetProviders(id).empty())
+            edges.push_back(std::make_pair(id, graph.GetProviders(id)[0]));
+    }
+
+    BGPPolicy &policy = static_cast<BGPPolicy&>(graph.GetImportPolicy(edges.empty() ? 0 : edges[0].first));
+    const uint32_t numPrefixes = graph.GetNumPrefixes();
+
+    size_t index = 0;
+    for (auto _ : state) {
+        const std::pair<ASN_ID, ASN_ASNID_PAIR> &edge = edges[index];
+        for (uint32_t p = 0; p < numPrefixes; p++) {
+            benchmark::DoNotOptimize(policy.CompareAnnouncements(graph, graph.GetCachedData_ReadOnly(edge.first, p), edge.second.asn,
+                graph.GetCachedData_ReadOnly(edge.second.id, p), RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER));
+        }
+
+        if (++index == edges.size())
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations() * numPrefixes);
+}
+BENCHMARK(BM_CompareAnnouncements)->Args({10000, 1000})->Args({10000, 10000});
+
+static void BM_ProcessRelationship(benchmark::State &state) {
+    BenchmarkGraph &graph = GetPropagatedGraph(state.range(0), state.range(1));
+    const uint32_t numPrefixes = graph.GetNumPrefixes();
+
+    // Every AS with providers imports from them, starting from just the seeded announcements of its row every time
+    std::vector<ASN_ID> customers;
+    for (ASN_ID id = 0; id < graph.GetNumASes(); id++) {
+        if (!graph.GetProviders(id).empty())
+            customers.push_back(id);
+    }
+
+    std::vector<AnnouncementCachedData> row(numPrefixes);
+    size_t index = 0;
+    for (auto _ : state) {
+        const ASN_ID id = customers[index];
+
+        state.PauseTiming();
+        for (uint32_t p = 0; p < numPrefixes; p++) {
+            AnnouncementCachedData &announcement = graph.GetCachedData(id, p);
+            row[p] = announcement;
+            if (!announcement.isSeeded())
+                announcement.SetDefaultState();
+        }
+        state.ResumeTiming();
+
+        for (auto &provider : graph.GetProviders(id))
+            benchmark::DoNotOptimize(graph.GetImportPolicy(id).ProcessProviderAnnouncements(graph, provider, 0, numPrefixes));
+
+        // Leave the propagated state as it was for the other benchmarks
+        state.PauseTiming();
+        for (uint32_t p = 0; p < numPrefixes; p++)
+            graph.GetCachedData(id, p) = row[p];
+        state.ResumeTiming();
+
+        if (++index == customers.size())
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations() * numPrefixes);
+}
+BENCHMARK(BM_ProcessRelationship)->Args({10000, 1000})->Args({10000, 10000});
+
+static void BM_ParseASNList(benchmark::State &state) {
+    SyntheticDataConfiguration config;
+    config.numASes = 1000;
+    config.numPrefixes = 0;
+    SyntheticDataGenerator generator(config);
+
+    std::vector<std::string> paths = generator.GenerateASPathStrings(1024, state.range(0));
+    size_t bytes = 0;
+    for (auto &path : paths)
+        bytes += path.size();
+
+    for (auto _ : state) {
+        for (auto &path : paths)
+            benchmark::DoNotOptimize(Util::parseASNList(path));
+    }
+
+    state.SetItemsProcessed(state.iterations() * paths.size());
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_ParseASNList)->Arg(2)->Arg(6)->Arg(16);
+
+// As the readers parse: into one buffer reused for every path
+static void BM_ParseASNListReused(benchmark::State &state) {
+    SyntheticDataConfiguration config;
+    config.numASes = 1000;
+    config.numPrefixes = 0;
+    SyntheticDataGenerator generator(config);
+
+    std::vector<std::string> paths = generator.GenerateASPathStrings(1024, state.range(0));
+    size_t bytes = 0;
+    for (auto &path : paths)
+        bytes += path.size();
+
+    std::vector<ASN> asPath;
+    for (auto _ : state) {
+        for (auto &path : paths) {
+            Util::parseASNList(path, asPath);
+            benchmark::DoNotOptimize(asPath.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * paths.size());
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_ParseASNListReused)->Arg(2)->Arg(6)->Arg(16);
+
+static void BM_ASNLookup(benchmark::State &state) {
+    const Dataset &dataset = GetDataset(state.range(0), 1000);
+    BenchmarkGraph graph(dataset.relationshipsFilePath);
+
+    // ASNs of the graph in a scattered order, as they come on AS paths, with one in eight unknown to the graph
+    std::vector<ASN> asns;
+    for (size_t i = 0; i < 4096; i++) {
+        const size_t scattered = (i * 2654435761u) % graph.GetNumASes();
+        asns.push_back(i % 8 == 7 ? graph.GetASN(scattered) + 1000000000u : graph.GetASN(scattered));
+    }
+
+    const ASNTable &table = graph.GetASNTable();
+    for (auto _ : state) {
+        for (ASN asn : asns) {
+            ASN_ID id;
+            benchmark::DoNotOptimize(table.FindID(asn, id));
+            benchmark::DoNotOptimize(id);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * asns.size());
+}
+BENCHMARK(BM_ASNLookup)->Arg(10000)->Arg(70000);
+
+static void BM_SeedPath(benchmark::State &state) {
+    // A graph of its own, since the seeded paths are left in it
+    const Dataset &dataset = GetDataset(state.range(0), state.range(1));
+    SeedingConfiguration config = GetSeedingConfiguration();
+    BenchmarkGraph graph(dataset.relationshipsFilePath);
+    graph.SeedBlock(dataset.announcementsFilePath, config);
+
+    // Paths the announcements file could have held, seeded into one extra static data slot of a single prefix block
+    std::vector<std::vector<ASN>> paths;
+    for (ASN_ID id = 0; id < graph.GetNumASes() && paths.size() < 1024; id++) {
+        std::vector<ASN> path(1, graph.GetASN(id));
+        ASN_ID current = id;
+        while (!graph.GetProviders(current).empty() && path.size() < 6) {
+            current = graph.GetProviders(current)[0].id;
+            path.insert(path.begin(), graph.GetASN(current));
+        }
+        paths.push_back(path);
+    }
+
+    std::vector<AnnouncementStaticData> &staticData = graph.GetAllStaticData();
+    staticData.push_back(AnnouncementStaticData());
+    const size_t staticDataIndex = staticData.size() - 1;
+    Prefix prefix;
+    prefix.global_id = 0;
+    prefix.block_id = 0;
+
+    size_t index = 0;
+    for (auto _ : state) {
+        graph.SeedPath(paths[index], staticDataIndex, prefix, "10.0.0.0/24", 4, config);
+
+        if (++index == paths.size())
+            index = 0;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SeedPath)->Args({10000, 1000});
+
+static void BM_Traceback(benchmark::State &state) {
+    BenchmarkGraph &graph = GetPropagatedGraph(state.range(0), state.range(1));
+    const uint32_t numPrefixes = graph.GetNumPrefixes();
+
+    std::vector<ASN> path;
+    ASN_ID id = 0;
+    uint32_t prefix = 0;
+    for (auto _ : state) {
+        path.clear();
+        graph.Traceback(path, graph.GetASN(id), prefix);
+        benchmark::DoNotOptimize(path.data());
+
+        if (++prefix == numPrefixes) {
+            prefix = 0;
+            if (++id == graph.GetNumASes())
+                id = 0;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Traceback)->Args({10000, 1000});
+
+static void BM_ResultWriter(benchmark::State &state) {
+    BenchmarkGraph &graph = GetPropagatedGraph(state.range(0), state.range(1));
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        size_t bytesWritten;
+        graph.GenerateTracebackResultsCSV("/dev/null", std::vector<ASN>(), bytesWritten);
+        bytes += bytesWritten;
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * graph.GetNumASes() * graph.GetNumPrefixes());
+}
+BENCHMARK(BM_ResultWriter)->Args({1000, 1000})->Args({10000, 250})->Unit(benchmark::kMillisecond);
+
+//*****Macro benchmarks
+
+/**
+ * Load, seed, propagate and write, as a run of the extrapolator does. Arguments: ASes, prefixes, threads
+ */
+static void BM_Pipeline(benchmark::State &state) {
+    const Dataset &dataset = GetDataset(state.range(0), state.range(1));
+    SeedingConfiguration config = GetSeedingConfiguration();
+
+    for (auto _ : state) {
+        Graph graph(dataset.relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>>(), true);
+        graph.SetNumThreads(state.range(2));
+        graph.SeedBlock(dataset.announcementsFilePath, config);
+        graph.Propagate();
+        size_t bytesWritten;
+        benchmark::DoNotOptimize(graph.GenerateTracebackResultsCSV("/dev/null", std::vector<ASN>(), bytesWritten));
+    }
+
+    state.counters["ases"] = state.range(0);
+    state.counters["prefixes"] = state.range(1);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_Pipeline)
+    ->ArgsProduct({{5000, 20000}, {250, 1000}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Propagation alone, from the seeded state. Arguments: ASes, prefixes, threads
+ */
+static void BM_Propagate(benchmark::State &state) {
+    const Dataset &dataset = GetDataset(state.range(0), state.range(1));
+    SeedingConfiguration config = GetSeedingConfiguration();
+
+    Graph graph(dataset.relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>>(), true);
+    graph.SetNumThreads(state.range(2));
+    graph.SeedBlock(dataset.announcementsFilePath, config);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        graph.ResetAllNonSeededAnnouncements();
+        state.ResumeTiming();
+
+        graph.Propagate();
+    }
+
+    state.counters["ases"] = state.range(0);
+    state.counters["prefixes"] = state.range(1);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+BENCHMARK(BM_Propagate)
+    ->ArgsProduct({{10000, 40000}, {1000, 4000}, {1, 2, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+int main(int argc, char **argv) {
+    if (argc >= 5 && std::string(argv[1]) == "--generate") {
+        SyntheticDataConfiguration config;
+        config.numASes = strtoull(argv[3], nullptr, 10);
+        config.numPrefixes = strtoull(argv[4], nullptr, 10);
+        if (argc >= 6)
+            config.seed = strtoul(argv[5], nullptr, 10);
+
+        SyntheticDataGenerator generator(config);
+        std::string prefix = argv[2];
+        if (!generator.WriteRelationships(prefix + "Relationships.tsv") || !generator.WriteAnnouncements(prefix + "Announcements.tsv")) {
+            std::cout << "Could not write the synthetic dataset to " << prefix << "*" << std::endl;
+            return 1;
+        }
+
+        std::cout << "Wrote " << generator.GetNumASes() << " ASes (maximum rank " << generator.GetMaximumRank() << ") and "
+            << config.numPrefixes << " prefixes to " << prefix << "*" << std::endl;
+        return 0;
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <cmath>
+#include <limits>
+
+#include "Benchmarks/SyntheticDataGenerator.hpp"
+
+// Seed offset for the announcements, so changing the number of prefixes does not change the topology (and vice versa)
+static const uint64_t ANNOUNCEMENT_SEED_OFFSET = 0x9E3779B97F4A7C15ULL;
+
+uint64_t SyntheticDataGenerator::Uniform(std::mt19937_64 &engine, const uint64_t bound) {
+    if (bound <= 1)
+        return 0;
+
+    // Rejection sampling, so every value is equally likely
+    const uint64_t limit = std::numeric_limits<uint64_t>::max() - std::numeric_limits<uint64_t>::max() % bound;
+    uint64_t value;
+    do {
+        value = engine();
+    } while (value >= limit);
+
+    return value % bound;
+}
+
+double SyntheticDataGenerator::UniformReal(std::mt19937_64 &engine) {
+    return (engine() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+SyntheticDataGenerator::SyntheticDataGenerator(const SyntheticDataConfiguration &config) : config(config) {
+    if (this->config.rankDepth == 0)
+        this->config.rankDepth = 1;
+    if (this->config.maxProviders == 0)
+        this->config.maxProviders = 1;
+
+    GenerateTopology();
+    ComputeRanks();
+}
+
+void SyntheticDataGenerator::GenerateTopology() {
+    std::mt19937_64 engine(config.seed);
+    const size_t numASes = config.numASes;
+
+    //***** ASNs: a random pick out of [1, 4 * numASes], so ASNs (and thus ASN tiebreaks) are not in tier order
+    std::vector<ASN> pool(numASes * 4);
+    for (size_t i = 0; i < pool.size(); i++)
+        pool[i] = i + 1;
+    for (size_t i = 0; i < numASes; i++)
+        std::swap(pool[i], pool[i + Uniform(engine, pool.size() - i)]);
+    asns.assign(pool.begin(), pool.begin() + numASes);
+
+    //***** Tiers: geometric growth from the top, every tier has at least one AS if there are enough
+    const size_t depth = std::min(config.rankDepth, std::max(numASes, (size_t) 1));
+    std::vector<double> weights(depth);
+    double totalWeight = 0;
+    for (size_t t = 0; t < depth; t++) {
+        weights[t] = std::pow(config.tierGrowth, (double) t);
+        totalWeight += weights[t];
+    }
+
+    std::vector<size_t> tierBegin(depth + 1, 0);
+    for (size_t t = 0; t < depth; t++) {
+        size_t size = std::max((size_t) 1, (size_t) (numASes * weights[t] / totalWeight));
+        tierBegin[t + 1] = std::min(numASes, tierBegin[t] + size);
+    }
+    tierBegin[depth] = numASes;
+
+    tiers.resize(numASes);
+    for (size_t t = 0; t < depth; t++) {
+        for (size_t id = tierBegin[t]; id < tierBegin[t + 1]; id++)
+            tiers[id] = t;
+    }
+
+    providers.assign(numASes, std::vector<ASN_ID>());
+    peers.assign(numASes, std::vector<ASN_ID>());
+    customers.assign(numASes, std::vector<ASN_ID>());
+
+    //***** Tier 0 is a clique of peers
+    for (size_t a = tierBegin[0]; a < tierBegin[1]; a++) {
+        for (size_t b = a + 1; b < tierBegin[1]; b++) {
+            peers[a].push_back(b);
+            peers[b].push_back(a);
+        }
+    }
+
+    //***** Transit. Number of providers from a power law (inverse CDF), providers by preferential attachment
+    std::vector<double> providerCDF(config.maxProviders);
+    double cumulative = 0;
+    for (size_t k = 1; k <= config.maxProviders; k++) {
+        cumulative += std::pow((double) k, -config.providerExponent);
+        providerCDF[k - 1] = cumulative;
+    }
+    for (auto &value : providerCDF)
+        value /= cumulative;
+
+    // Per tier, every AS once plus once per customer it has, so a uniform pick is proportional to (customers + 1)
+    std::vector<std::vector<ASN_ID>> attachment(depth);
+    for (size_t id = 0; id < numASes; id++)
+        attachment[tiers[id]].push_back(id);
+
+    for (size_t id = tierBegin[std::min((size_t) 1, depth)]; id < numASes; id++) {
+        const size_t tier = tiers[id];
+        if (tier == 0)
+            continue;
+
+        const double draw = UniformReal(engine);
+        const size_t numProviders = std::lower_bound(providerCDF.begin(), providerCDF.end(), draw) - providerCDF.begin() + 1;
+
+        for (size_t i = 0; i < numProviders; i++) {
+            // Mostly the tier right above, sometimes any tier above
+            size_t providerTier = (tier == 1 || UniformReal(engine) < 0.75) ? tier - 1 : Uniform(engine, tier);
+            const std::vector<ASN_ID> &candidates = attachment[providerTier];
+            ASN_ID provider = candidates[Uniform(engine, candidates.size())];
+
+            if (std::find(providers[id].begin(), providers[id].end(), provider) != providers[id].end())
+                continue;
+
+            providers[id].push_back(provider);
+            customers[provider].push_back(id);
+            attachment[providerTier].push_back(provider);
+        }
+    }
+
+    //***** Peering, within a tier (the clique is done already)
+    for (size_t id = tierBegin[std::min((size_t) 1, depth)]; id < numASes; id++) {
+        if (UniformReal(engine) >= config.peeringProbability)
+            continue;
+
+        const size_t tier = tiers[id];
+        const size_t tierSize = tierBegin[tier + 1] - tierBegin[tier];
+        const size_t numPeers = 1 + Uniform(engine, config.maxPeers);
+
+        for (size_t i = 0; i < numPeers && tierSize > 1; i++) {
+            ASN_ID peer = tierBegin[tier] + Uniform(engine, tierSize);
+            if (peer == id || std::find(peers[id].begin(), peers[id].end(), peer) != peers[id].end())
+                continue;
+
+            peers[id].push_back(peer);
+            peers[peer].push_back(id);
+        }
+    }
+}
+
+void SyntheticDataGenerator::ComputeRanks() {
+    // Customers are always in a lower tier (higher ID), so walking the IDs backwards sees every customer before its providers
+    ranks.assign(asns.size(), 0);
+    for (size_t i = asns.size(); i-- > 0;) {
+        for (auto customer : customers[i])
+            ranks[i] = std::max(ranks[i], ranks[customer] + 1);
+    }
+}
+
+/**
+ * Writes "{a,b,c}" for the ASNs of the given IDs
+ */
+static void WriteASNList(FILE *f, const std::vector<ASN> &asns, const std::vector<ASN_ID> &ids) {
+    fputc('{', f);
+    for (size_t i = 0; i < ids.size(); i++)
+        fprintf(f, i == 0 ? "%u" : ",%u", asns[ids[i]]);
+    fputc('}', f);
+}
+
+bool SyntheticDataGenerator::WriteRelationships(const std::string &filePath) const {
+    FILE *f = fopen(filePath.c_str(), "w");
+    if (f == nullptr)
+        return false;
+
+    auto isStub = [&](const ASN_ID id) {
+        return providers[id].size() == 1 && customers[id].empty() && peers[id].empty();
+    };
+
+    fprintf(f, "asn\tpeers\tcustomers\tproviders\tpropagation_rank\tstub\tstubs\n");
+
+    std::vector<ASN_ID> stubs;
+    for (ASN_ID id = 0; id < asns.size(); id++) {
+        stubs.clear();
+        for (auto customer : customers[id]) {
+            if (isStub(customer))
+                stubs.push_back(customer);
+        }
+
+        fprintf(f, "%u\t", asns[id]);
+        WriteASNList(f, asns, peers[id]);
+        fputc('\t', f);
+        WriteASNList(f, asns, customers[id]);
+        fputc('\t', f);
+        WriteASNList(f, asns, providers[id]);
+        fprintf(f, "\t%u\t%s\t", ranks[id], isStub(id) ? "TRUE" : "FALSE");
+        WriteASNList(f, asns, stubs);
+        fputc('\n', f);
+    }
+
+    return fclose(f) == 0;
+}
+
+bool SyntheticDataGenerator::WriteAnnouncements(const std::string &filePath) const {
+    FILE *f = fopen(filePath.c_str(), "w");
+    if (f == nullptr || asns.empty()) {
+        if (f != nullptr)
+            fclose(f);
+        return false;
+    }
+
+    std::mt19937_64 engine(config.seed + ANNOUNCEMENT_SEED_OFFSET);
+
+    fprintf(f, "prefix\tas_path\torigin\ttimestamp\tprefix_id\tblock_id\tprefix_block_id\n");
+
+    std::vector<ASN_ID> path;
+    for (uint32_t prefixID = 0; prefixID < config.numPrefixes; prefixID++) {
+        const ASN_ID origin = Uniform(engine, asns.size());
+        const size_t numAnnouncements = 1 + Uniform(engine, std::max(config.maxAnnouncementsPerPrefix, (size_t) 1));
+
+        for (size_t a = 0; a < numAnnouncements; a++) {
+            // Walk away from the origin, mostly up to providers, like the path a collector would see
+            path.assign(1, origin);
+            const size_t hops = Uniform(engine, std::max(config.maxPathLength, (size_t) 1));
+            for (size_t h = 0; h < hops; h++) {
+                ASN_ID current = path.back();
+                const std::vector<ASN_ID> &next = (!providers[current].empty() && (peers[current].empty() || UniformReal(engine) < 0.8)) ? providers[current] : peers[current];
+                if (next.empty())
+                    break;
+
+                ASN_ID hop = next[Uniform(engine, next.size())];
+                if (std::find(path.begin(), path.end(), hop) != path.end())
+                    break;
+
+                path.push_back(hop);
+            }
+
+            // Some paths are prepended by the origin
+            bool prepended = UniformReal(engine) < 0.1;
+            int64_t timestamp = 1 + Uniform(engine, 3);
+
+            fprintf(f, "%u.%u.%u.0/24\t{", 10 + (prefixID >> 16), (prefixID >> 8) & 0xFF, prefixID & 0xFF);
+            for (size_t i = path.size(); i-- > 0;)
+                fprintf(f, i + 1 == path.size() ? "%u" : ",%u", asns[path[i]]);
+            if (prepended)
+                fprintf(f, ",%u", asns[origin]);
+            fprintf(f, "}\t%u\t%lld\t%u\t0\t%u\n", asns[origin], (long long) timestamp, prefixID, prefixID);
+        }
+    }
+
+    return fclose(f) == 0;
+}
+
+std::vector<std::string> SyntheticDataGenerator::GenerateASPathStrings(const size_t count, const size_t pathLength) const {
+    std::mt19937_64 engine(config.seed);
+    std::vector<std::string> paths(count);
+
+    char buffer[16];
+    for (auto &path : paths) {
+        path = "{";
+        for (size_t i = 0; i < pathLength; i++) {
+            snprintf(buffer, sizeof(buffer), i == 0 ? "%u" : ",%u", asns.empty() ? (ASN) (i + 1) : asns[Uniform(engine, asns.size())]);
+            path += buffer;
+        }
+        path += "}";
+    }
+
+    return paths;
+}
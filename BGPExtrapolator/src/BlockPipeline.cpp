@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "BlockPipeline.hpp"
+#include "InputFile.hpp"
+#include "RunReport.hpp"
+#include "TraceRecorder.hpp"
+
+BlockPipeline::BlockPipeline(Graph &graph, const size_t batchRows) : graph(graph), batchRows(batchRows == 0 ? 1 : batchRows), numBatches(0), numRows(0) {
+
+}
+
+bool BlockPipeline::PlanBatches(const std::string &announcementsFilePath, const size_t batchRows, std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> &blockToBatch,
+        std::vector<size_t> &rowsPerBatch, std::vector<uint32_t> &blocksPerBatch) {
+    blockToBatch.clear();
+    rowsPerBatch.clear();
+    blocksPerBatch.clear();
+
+    InputFile input;
+    std::string line;
+    std::vector<std::string> cells;
+    if (!input.Open(announcementsFilePath) || !input.ReadLine(line))
+        return false;
+
+    Util::splitSeparatedValues(line, cells);
+    const int blockColumn = Util::findColumn(cells, "prefix_block_id");
+    if (blockColumn < 0)
+        return false;
+
+    // Rows of every prefix block. Only the block column is converted
+    std::map<uint32_t, size_t> rowsPerBlock;
+    while (input.ReadLine(line)) {
+        if (line.empty())
+            continue;
+
+        size_t cellBegin = 0;
+        for (int column = 0; column < blockColumn && cellBegin != std::string::npos; column++) {
+            cellBegin = line.find(SEPARATED_VALUES_DELIMETER, cellBegin);
+            if (cellBegin != std::string::npos)
+                cellBegin++;
+        }
+
+        if (cellBegin == std::string::npos)
+            continue;
+
+        if (line[cellBegin] == '"')
+            cellBegin++;
+        rowsPerBlock[strtoul(line.c_str() + cellBegin, nullptr, 10)]++;
+    }
+
+    if (input.IsCorrupt()) {
+        std::cout << "The announcements file is corrupt or truncated: " << announcementsFilePath << std::endl;
+        return false;
+    }
+
+    // Contiguous block ranges, a batch is closed once it has batchRows rows
+    for (auto &kv : rowsPerBlock) {
+        if (rowsPerBatch.empty() || rowsPerBatch.back() >= batchRows) {
+            rowsPerBatch.push_back(0);
+            blocksPerBatch.push_back(0);
+        }
+
+        blockToBatch[kv.first] = std::make_pair(rowsPerBatch.size() - 1, blocksPerBatch.back()++);
+        rowsPerBatch.back() += kv.second;
+    }
+
+    return true;
+}
+
+bool BlockPipeline::Run(const std::string &announcementsFilePath, const SeedingConfiguration &config, const std::vector<LaneConfiguration> &lanes,
+        const std::vector<std::string> &resultsFilePaths, const std::vector<ASN> &localRibsToDump, const ResultsFilter &filter, std::vector<size_t> &bytesWritten) {
+    timings = PipelineTimings();
+    propagationTimings = PropagationTimings();
+    statisticsProfile = PropagationStatisticsProfile();
+    bytesWritten.assign(resultsFilePaths.size(), 0);
+
+    Stopwatch stopwatch;
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> blockToBatch;
+    std::vector<size_t> rowsPerBatch;
+    std::vector<uint32_t> blocksPerBatch;
+    if (!PlanBatches(announcementsFilePath, batchRows, blockToBatch, rowsPerBatch, blocksPerBatch)) {
+        std::cout << "Could not read the prefix blocks of the announcements file: " << announcementsFilePath << std::endl;
+        return false;
+    }
+
+    timings.planMilliseconds = stopwatch.ElapsedMilliseconds();
+    numBatches = rowsPerBatch.size();
+    numRows = 0;
+    for (size_t rows : rowsPerBatch)
+        numRows += rows;
+
+    std::vector<FILE*> files;
+    bool ok = true;
+    for (auto &resultsFilePath : resultsFilePaths) {
+        files.push_back(fopen(resultsFilePath.c_str(), "w"));
+        if (files.back() == nullptr) {
+            std::cout << "Could not open the results file for writing: " << resultsFilePath << std::endl;
+            ok = false;
+        }
+    }
+
+    // The header is written with the first batch, a file with no batch at all still gets it
+    if (ok && numBatches == 0)
+        bytesWritten = graph.AppendTracebackResults(PropagatedBlocks(), files, localRibsToDump, true, filter);
+
+    BoundedQueue<std::unique_ptr<BlockBatch>> parsed(1);
+    BoundedQueue<std::unique_ptr<PropagatedBlocks>> propagated(1);
+    BoundedQueue<std::unique_ptr<PropagatedBlocks>> free(1);
+    free.Push(std::unique_ptr<PropagatedBlocks>(new PropagatedBlocks()));
+
+    //***** Parse: rows to the batch of their block, a batch goes on once all of its rows are in
+    bool parseOK = true;
+    std::thread parser([&]() {
+        if (!ok || numBatches == 0) {
+            parsed.Close();
+            return;
+        }
+
+        Stopwatch busy;
+        InputFile input;
+        std::string line;
+        std::vector<std::string> cells;
+        input.Open(announcementsFilePath);
+        input.ReadLine(line);
+        Util::splitSeparatedValues(line, cells);
+
+        const int prefixColumn = Util::findColumn(cells, "prefix"), pathColumn = Util::findColumn(cells, "as_path"), timestampColumn = Util::findColumn(cells, "timestamp"),
+            prefixIDColumn = Util::findColumn(cells, "prefix_id"), blockColumn = Util::findColumn(cells, "prefix_block_id");
+        if (prefixColumn < 0 || pathColumn < 0 || timestampColumn < 0 || prefixIDColumn < 0) {
+            std::cout << "The announcements file is missing a column (prefix, as_path, timestamp, prefix_id): " << announcementsFilePath << std::endl;
+            parseOK = false;
+            parsed.Close();
+            return;
+        }
+
+        const size_t numColumns = cells.size();
+        std::vector<std::unique_ptr<BlockBatch>> pending(numBatches);
+        while (input.ReadLine(line)) {
+            if (line.empty())
+                continue;
+
+            Util::splitSeparatedValues(line, cells);
+            if (cells.size() < numColumns)
+                continue;
+
+            const std::pair<uint32_t, uint32_t> &batchBlock = blockToBatch[strtoul(cells[blockColumn].c_str(), nullptr, 10)];
+            std::unique_ptr<BlockBatch> &batch = pending[batchBlock.first];
+            if (!batch) {
+                batch.reset(new BlockBatch());
+                batch->announcements.reserve(rowsPerBatch[batchBlock.first]);
+                batch->numPrefixBlocks = blocksPerBatch[batchBlock.first];
+            }
+
+            batch->announcements.push_back(ScenarioAnnouncement());
+            ScenarioAnnouncement &announcement = batch->announcements.back();
+            announcement.prefixString = cells[prefixColumn];
+            Util::parseASNList(cells[pathColumn], announcement.asPath);
+            announcement.timestamp = strtoll(cells[timestampColumn].c_str(), nullptr, 10);
+            announcement.prefix.global_id = strtoul(cells[prefixIDColumn].c_str(), nullptr, 10);
+            announcement.prefix.block_id = batchBlock.second;
+
+            if (batch->announcements.size() == rowsPerBatch[batchBlock.first]) {
+                timings.parseMilliseconds += busy.ElapsedMilliseconds();
+                if (!parsed.Push(std::move(batch)))
+                    break;
+                busy.Restart();
+            }
+        }
+
+        if (input.IsCorrupt()) {
+            std::cout << "The announcements file is corrupt or truncated: " << announcementsFilePath << std::endl;
+            parseOK = false;
+        }
+
+        // Rows the first pass counted but that are cut short would hold their batch back, it goes on without them
+        for (auto &batch : pending) {
+            if (batch)
+                parsed.Push(std::move(batch));
+        }
+
+        timings.parseMilliseconds += busy.ElapsedMilliseconds();
+        parsed.Close();
+    });
+
+    //***** Write: results of the blocks handed over, then the buffer goes back to the graph
+    bool writeOK = true;
+    std::thread writer([&]() {
+        std::unique_ptr<PropagatedBlocks> blocks;
+        bool first = true;
+        while (propagated.Pop(blocks)) {
+            Stopwatch busy;
+            std::vector<size_t> batchBytes = graph.AppendTracebackResults(*blocks, files, localRibsToDump, first, filter);
+            for (size_t i = 0; i < batchBytes.size(); i++)
+                bytesWritten[i] += batchBytes[i];
+            first = false;
+            timings.writeMilliseconds += busy.ElapsedMilliseconds();
+
+            free.Push(std::move(blocks));
+        }
+    });
+
+    //***** Seed and propagate, on this thread and the pool of the graph
+    std::unique_ptr<BlockBatch> batch;
+    Stopwatch stall;
+    while (parsed.Pop(batch)) {
+        timings.parseStallMilliseconds += stall.ElapsedMilliseconds();
+
+        Stopwatch busy;
+        BGPX_TRACE_BEGIN(seedingSpan, "seeding", "phase");
+        if (lanes.empty())
+            graph.SeedBlock(batch->announcements, batch->numPrefixBlocks, config);
+        else
+            graph.SeedBlock(batch->announcements, batch->numPrefixBlocks, lanes);
+        BGPX_TRACE_END(seedingSpan);
+        batch.reset();
+        timings.seedingMilliseconds += busy.ElapsedMilliseconds();
+
+        busy.Restart();
+        BGPX_TRACE_BEGIN(propagationSpan, "propagation", "phase");
+        graph.Propagate();
+        BGPX_TRACE_END(propagationSpan);
+        timings.propagationMilliseconds += busy.ElapsedMilliseconds();
+        propagationTimings.Add(graph.GetPropagationTimings());
+        statisticsProfile.Add(graph.GetPropagationStatistics());
+
+        // Waits for the writer to be done with the previous batch
+        stall.Restart();
+        std::unique_ptr<PropagatedBlocks> blocks;
+        free.Pop(blocks);
+        timings.writeStallMilliseconds += stall.ElapsedMilliseconds();
+
+        graph.SwapPropagatedBlocks(*blocks);
+        propagated.Push(std::move(blocks));
+        stall.Restart();
+    }
+
+    propagated.Close();
+    parser.join();
+    writer.join();
+
+    for (FILE *file : files) {
+        if (file != nullptr && fclose(file) != 0)
+            writeOK = false;
+    }
+
+    return ok && parseOK && writeOK;
+}
@@ -0,0 +1,338 @@
+#include <string.h>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "ExperimentServer.hpp"
+#include "RunReport.hpp"
+
+#ifndef _WIN32
+// A client that hangs up early must not take the server down with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+#endif
+
+ExperimentServer::ExperimentServer(Graph &graph) : graph(graph), numServed(0), shutdown(false) {
+
+}
+
+nlohmann::json ExperimentServer::RunExperiment(const nlohmann::json &request) {
+    nlohmann::json response;
+
+    auto announcements_search = request.find("announcements_file");
+    if (announcements_search == request.end() || !announcements_search.value().is_string() || announcements_search.value().get<std::string>().empty()) {
+        response["error"] = "Expected path to announcements TSV file!";
+        return response;
+    }
+
+    auto output_search = request.find("output_folder");
+    if (output_search == request.end() || !output_search.value().is_string() || output_search.value().get<std::string>().empty()) {
+        response["error"] = "Expected path to output folder!";
+        return response;
+    }
+
+    std::string announcementsFilePath = announcements_search.value();
+    std::string outputFilePath = output_search.value();
+    if (outputFilePath.back() != '/' && outputFilePath.back() != '\\')
+        outputFilePath += '/';
+
+    SeedingConfiguration config;
+    std::string seedingError;
+    if (!SeedingConfiguration::FromJSON(request, config, seedingError)) {
+        response["error"] = seedingError;
+        return response;
+    }
+
+    std::vector<ASN> controlPlaneASNs;
+    auto control_plane_trace_ASNs_search = request.find("control_plane_traceback_asn");
+    if (control_plane_trace_ASNs_search != request.end()) {
+        if (control_plane_trace_ASNs_search.value().is_array()) {
+            controlPlaneASNs = control_plane_trace_ASNs_search.value().get<std::vector<ASN>>();
+        } else {
+            response["error"] = "Expected list of ASNs for control plane traceback!";
+            return response;
+        }
+    }
+
+    ResultsFilter resultsFilter;
+    std::string resultsFilterError;
+    if (!ResultsFilter::FromJSON(request, resultsFilter, resultsFilterError)) {
+        response["error"] = resultsFilterError;
+        return response;
+    }
+
+    bool dump_after_seeding = false;
+    auto dump_after_seeding_search = request.find("write_results_after_seeding");
+    if (dump_after_seeding_search != request.end()) {
+        if (dump_after_seeding_search.value().is_boolean()) {
+            dump_after_seeding = dump_after_seeding_search.value().get<bool>();
+        } else {
+            response["error"] = "Expected a boolean for dump after seeding!";
+            return response;
+        }
+    }
+
+    // Checked up front, rapidcsv would throw
+    if (!std::ifstream(announcementsFilePath).good()) {
+        response["error"] = "Could not read the announcements file: " + announcementsFilePath;
+        return response;
+    }
+
+    Stopwatch stopwatch;
+    nlohmann::json timings;
+
+    // SeedBlock resets the local ribs (reusing their allocation) and everything seeded by the previous experiment
+    graph.SeedBlock(announcementsFilePath, config);
+    timings["seeding"] = stopwatch.ElapsedMilliseconds();
+
+    if (dump_after_seeding) {
+        stopwatch.Restart();
+        ResultsFilter seedingFilter = resultsFilter;
+        seedingFilter.propagatedOnly = false;
+        size_t seedingBytesWritten;
+        if (!graph.GenerateTracebackResultsCSV(outputFilePath + "Results_Seeding.tsv", controlPlaneASNs, seedingBytesWritten, seedingFilter)) {
+            response["error"] = "Could not write the results file: " + outputFilePath + "Results_Seeding.tsv";
+            return response;
+        }
+        timings["seeding_results_write"] = stopwatch.ElapsedMilliseconds();
+    }
+
+    stopwatch.Restart();
+    graph.Propagate();
+    timings["propagation"] = stopwatch.ElapsedMilliseconds();
+
+    stopwatch.Restart();
+    size_t bytesWritten;
+    if (!graph.GenerateTracebackResultsCSV(outputFilePath + "Results.tsv", controlPlaneASNs, bytesWritten, resultsFilter)) {
+        response["error"] = "Could not write the results file: " + outputFilePath + "Results.tsv";
+        return response;
+    }
+    timings["results_write"] = stopwatch.ElapsedMilliseconds();
+
+    response["results_file"] = outputFilePath + "Results.tsv";
+    response["num_prefixes"] = graph.GetNumPrefixes();
+    response["results_bytes_written"] = bytesWritten;
+    response["timings_ms"] = timings;
+    return response;
+}
+
+nlohmann::json ExperimentServer::RunQuery(const nlohmann::json &request) {
+    nlohmann::json response;
+
+    if (graph.GetNumPrefixes() == 0) {
+        response["error"] = "No experiment to query yet!";
+        return response;
+    }
+
+    // The index of the last experiment is built by its first query
+    Stopwatch stopwatch;
+    if (!graph.HasRouteIndex()) {
+        graph.BuildRouteIndex();
+        response["index_build_ms"] = stopwatch.ElapsedMilliseconds();
+        stopwatch.Restart();
+    }
+
+    uint32_t prefixBlockID;
+    auto prefix_search = request.find("prefix");
+    auto prefix_block_search = request.find("prefix_block_id");
+    if (prefix_search != request.end() && prefix_search.value().is_string()) {
+        std::vector<uint32_t> prefixBlockIDs = graph.FindPrefixBlocks(prefix_search.value().get<std::string>(), 0);
+        if (prefixBlockIDs.empty()) {
+            response["error"] = "No AS has a route for the prefix!";
+            return response;
+        }
+        prefixBlockID = prefixBlockIDs[0];
+    } else if (prefix_block_search != request.end() && prefix_block_search.value().is_number_unsigned()) {
+        prefixBlockID = prefix_block_search.value().get<uint32_t>();
+    } else {
+        response["error"] = "Expected a prefix or a prefix_block_id to query!";
+        return response;
+    }
+
+    auto asn_search = request.find("asn");
+    auto origin_search = request.find("origin");
+    auto next_hop_search = request.find("next_hop");
+    if (asn_search != request.end()) {
+        if (!asn_search.value().is_number_unsigned()) {
+            response["error"] = "Expected an ASN to query the route of!";
+            return response;
+        }
+
+        QueriedRoute route;
+        if (graph.QueryRoute(asn_search.value().get<ASN>(), prefixBlockID, route)) {
+            response["route"]["prefix"] = route.prefixString;
+            response["route"]["origin"] = route.originASN;
+            response["route"]["timestamp"] = route.timestamp;
+            response["route"]["next_hop"] = route.nextHopASN;
+            response["route"]["as_path"] = route.asPath;
+        } else {
+            response["route"] = nullptr;
+        }
+    } else if (origin_search != request.end() || next_hop_search != request.end()) {
+        auto &search = origin_search != request.end() ? origin_search : next_hop_search;
+        if (!search.value().is_number_unsigned()) {
+            response["error"] = "Expected an ASN to query the ASes of!";
+            return response;
+        }
+
+        std::vector<ASN> asns;
+        if (origin_search != request.end())
+            graph.QueryASesByOrigin(prefixBlockID, search.value().get<ASN>(), asns);
+        else
+            graph.QueryASesByNextHop(prefixBlockID, search.value().get<ASN>(), asns);
+        response["asns"] = asns;
+    } else {
+        std::vector<std::pair<ASN, size_t>> origins;
+        graph.GetRouteIndex()->GetOrigins(prefixBlockID, origins);
+
+        response["origins"] = nlohmann::json::array();
+        for (auto &origin : origins)
+            response["origins"].push_back({ { "origin", origin.first }, { "num_ases", origin.second } });
+    }
+
+    response["prefix_block_id"] = prefixBlockID;
+    response["query_ms"] = stopwatch.ElapsedMilliseconds();
+    return response;
+}
+
+std::string ExperimentServer::HandleRequest(const std::string &line) {
+    nlohmann::json request = nlohmann::json::parse(line, nullptr, false);
+
+    nlohmann::json response;
+    if (request.is_discarded() || !request.is_object()) {
+        response["status"] = "error";
+        response["error"] = "Expected a JSON object!";
+        return response.dump();
+    }
+
+    auto id_search = request.find("id");
+    if (id_search != request.end())
+        response["id"] = id_search.value();
+
+    auto command_search = request.find("command");
+    if (command_search != request.end() && command_search.value() == "query") {
+        nlohmann::json result = RunQuery(request);
+        response["status"] = result.find("error") != result.end() ? "error" : "ok";
+        response.update(result);
+        return response.dump();
+    }
+
+    if (command_search != request.end()) {
+        if (command_search.value() == "shutdown") {
+            shutdown = true;
+            response["status"] = "ok";
+            response["num_served"] = numServed;
+        } else {
+            response["status"] = "error";
+            response["error"] = "Unknown command!";
+        }
+
+        return response.dump();
+    }
+
+    nlohmann::json result;
+    try {
+        result = RunExperiment(request);
+    } catch (const std::exception &e) {
+        // Malformed announcements (rapidcsv throws on cells it cannot convert). The next experiment reseeds everything anyway
+        result["error"] = std::string("Could not run the experiment: ") + e.what();
+    }
+
+    if (result.find("error") != result.end()) {
+        response["status"] = "error";
+    } else {
+        response["status"] = "ok";
+        numServed++;
+    }
+
+    response.update(result);
+    return response.dump();
+}
+
+void ExperimentServer::Serve(std::istream &requests, std::ostream &responses) {
+    std::string line;
+    while (!shutdown && std::getline(requests, line)) {
+        if (line.empty() || line == "\r")
+            continue;
+
+        responses << HandleRequest(line) << std::endl;
+    }
+}
+
+bool ExperimentServer::ServeSocket(const std::string &socketPath) {
+#ifndef _WIN32
+    struct sockaddr_un address;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cout << "Socket path is too long: " << socketPath << std::endl;
+        return false;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cout << "Could not create the server socket" << std::endl;
+        return false;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    unlink(socketPath.c_str());
+    if (bind(listener, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        std::cout << "Could not listen on " << socketPath << std::endl;
+        close(listener);
+        return false;
+    }
+
+    std::cout << "Listening on " << socketPath << std::endl;
+
+    std::vector<char> buffer(1 << 16);
+    while (!shutdown) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0)
+            continue;
+
+        // Requests may arrive split over reads or several in one read, lines are cut out of what has arrived so far
+        std::string pending;
+        ssize_t numRead;
+        while (!shutdown && (numRead = read(connection, buffer.data(), buffer.size())) > 0) {
+            pending.append(buffer.data(), numRead);
+
+            size_t lineBegin = 0, lineEnd;
+            while (!shutdown && (lineEnd = pending.find('\n', lineBegin)) != std::string::npos) {
+                std::string line = pending.substr(lineBegin, lineEnd - lineBegin);
+                lineBegin = lineEnd + 1;
+                if (line.empty() || line == "\r")
+                    continue;
+
+                std::string response = HandleRequest(line) + "\n";
+                for (size_t written = 0; written < response.size(); ) {
+                    ssize_t numWritten = send(connection, response.data() + written, response.size() - written, SEND_FLAGS);
+                    if (numWritten <= 0)
+                        break;
+                    written += numWritten;
+                }
+            }
+
+            pending.erase(0, lineBegin);
+        }
+
+        close(connection);
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    return true;
+#else
+    std::cout << "Serving on a socket is not supported on this platform" << std::endl;
+    return false;
+#endif
+}
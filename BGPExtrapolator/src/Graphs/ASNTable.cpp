@@ -0,0 +1,77 @@
+#include <algorithm>
+
+#include "Graphs/ASNTable.hpp"
+
+const uint32_t ASNTable::NONE;
+const uint32_t ASNTable::REMOVED_STUB;
+const uint32_t ASNTable::DIRECT_PAGE_MINIMUM;
+const uint32_t ASNTable::DIRECT_PAGES_ALWAYS;
+const uint32_t ASNTable::PAGE_SIZE;
+
+void ASNTable::Build(const std::vector<ASN> &idToASN, const std::vector<std::pair<ASN, ASN_ID>> &stubToProviderID) {
+    // Every listing of an ASN (ID, or provider with REMOVED_STUB set), sorted by ASN.
+    // Stable, so the listings of an ASN stay in the order given, IDs first
+    std::vector<std::pair<ASN, uint32_t>> listings;
+    listings.reserve(idToASN.size() + stubToProviderID.size());
+    for (ASN_ID id = 0; id < idToASN.size(); id++)
+        listings.push_back(std::make_pair(idToASN[id], id));
+    for (auto &stub : stubToProviderID)
+        listings.push_back(std::make_pair(stub.first, stub.second | REMOVED_STUB));
+
+    auto byASN = [](const std::pair<ASN, uint32_t> &a, const std::pair<ASN, uint32_t> &b) { return a.first < b.first; };
+    std::stable_sort(listings.begin(), listings.end(), byASN);
+
+    // One slot per ASN, the first listing wins: the first ID, or the first provider of a stub without ID.
+    // Every stub also keeps the first provider listing it, ID or not
+    std::vector<std::pair<ASN, uint32_t>> slots;
+    stubs.clear();
+    for (auto &listing : listings) {
+        if (slots.empty() || slots.back().first != listing.first)
+            slots.push_back(listing);
+
+        const bool isStub = (listing.second & REMOVED_STUB) != 0;
+        if (isStub && (stubs.empty() || stubs.back().first != listing.first))
+            stubs.push_back(std::make_pair(listing.first, listing.second & ~REMOVED_STUB));
+    }
+
+    //***** Pages, in ASN order
+    pages.assign(slots.empty() ? 0 : (slots.back().first >> 16) + 1, Page { 0, 0 });
+    for (auto &slot : slots)
+        pages[slot.first >> 16].count++;
+
+    size_t numUsedPages = 0;
+    for (Page &page : pages)
+        numUsedPages += page.count > 0;
+
+    directSlots.clear();
+    sparseKeys.clear();
+    sparseSlots.clear();
+    size_t position = 0;
+    for (Page &page : pages) {
+        const uint32_t count = page.count;
+
+        if (count >= DIRECT_PAGE_MINIMUM || (count > 0 && numUsedPages <= DIRECT_PAGES_ALWAYS)) {
+            page.offset = directSlots.size();
+            page.count = PAGE_SIZE;
+            directSlots.resize(directSlots.size() + PAGE_SIZE, NONE);
+            for (uint32_t i = 0; i < count; i++, position++)
+                directSlots[page.offset + (slots[position].first & 0xFFFF)] = slots[position].second;
+        } else {
+            page.offset = sparseSlots.size();
+            for (uint32_t i = 0; i < count; i++, position++) {
+                sparseKeys.push_back(slots[position].first & 0xFFFF);
+                sparseSlots.push_back(slots[position].second);
+            }
+        }
+    }
+}
+
+ASN_ID ASNTable::FindStubProviderID(const ASN asn) const {
+    auto search = std::lower_bound(stubs.begin(), stubs.end(), std::make_pair(asn, (ASN_ID) 0));
+    return search != stubs.end() && search->first == asn ? search->second : NONE;
+}
+
+size_t ASNTable::GetMemoryUsage() const {
+    return pages.capacity() * sizeof(Page) + directSlots.capacity() * sizeof(uint32_t) + sparseKeys.capacity() * sizeof(uint16_t)
+        + sparseSlots.capacity() * sizeof(uint32_t) + stubs.capacity() * sizeof(std::pair<ASN, ASN_ID>);
+}
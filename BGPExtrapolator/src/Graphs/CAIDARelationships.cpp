@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <stdlib.h>
+#include <unordered_map>
+
+#include "Graphs/CAIDARelationships.hpp"
+#include "Graphs/ASNTable.hpp"
+#include "InputFile.hpp"
+
+// Cycles printed in full, the others are only counted
+static const size_t REPORTED_CYCLES = 10;
+
+void Adjacency::Build(const size_t numASes, const std::vector<std::pair<uint32_t, uint32_t>> &links) {
+    offsets.assign(numASes + 1, 0);
+    indices.resize(links.size());
+    for (size_t i = 0; i < links.size(); i++) {
+        offsets[links[i].first + 1]++;
+        indices[i] = links[i].second;
+    }
+    for (size_t index = 0; index < numASes; index++)
+        offsets[index + 1] += offsets[index];
+}
+
+/**
+ * Reads "<a>|<b>|<relationship>" at the start of a line, anything after another '|' is ignored (serial-2)
+ *
+ * @return false if the line is not a link
+ */
+static bool ParseLink(const std::string &line, ASN &a, ASN &b, long &relationship) {
+    const char *position = line.c_str();
+    char *next;
+
+    a = strtoul(position, &next, 10);
+    if (next == position || *next != '|')
+        return false;
+
+    position = next + 1;
+    b = strtoul(position, &next, 10);
+    if (next == position || *next != '|')
+        return false;
+
+    position = next + 1;
+    relationship = strtol(position, &next, 10);
+    return next != position && (*next == '\0' || *next == '|');
+}
+
+/**
+ * Replaces the ASNs of the links by their IDs, sorts them by the first AS and drops the links listed more than once
+ */
+static void LinksToIDs(const ASNTable &table, std::vector<std::pair<ASN, ASN>> &links) {
+    for (auto &link : links) {
+        table.FindID(link.first, link.first);
+        table.FindID(link.second, link.second);
+    }
+
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+}
+
+bool CAIDARelationships::IsCAIDAFile(const std::string &filePath) {
+    InputFile input;
+    std::string line;
+    if (!input.Open(filePath) || !input.ReadLine(line))
+        return false;
+
+    return !line.empty() && (line[0] == '#' || (line.find('|') != std::string::npos && line.find(SEPARATED_VALUES_DELIMETER) == std::string::npos));
+}
+
+bool CAIDARelationships::Read(const std::string &filePath, ThreadPool &threadPool, CAIDATopology &topology) {
+    topology = CAIDATopology();
+
+    InputFile input;
+    if (!input.Open(filePath)) {
+        std::cout << "Could not open the relationships file: " << filePath << std::endl;
+        return false;
+    }
+
+    //***** Links, by ASN (customer to provider, and peers both ways)
+    std::vector<std::pair<ASN, ASN>> customerProviderLinks, providerCustomerLinks, peerLinks;
+    std::vector<ASN> asns;
+    std::string line;
+    size_t numSkippedLines = 0;
+    while (input.ReadLine(line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        ASN a, b;
+        long relationship;
+        if (!ParseLink(line, a, b, relationship) || a == b || (relationship != -1 && relationship != 0)) {
+            numSkippedLines++;
+            continue;
+        }
+
+        asns.push_back(a);
+        asns.push_back(b);
+        if (relationship == -1) {
+            customerProviderLinks.push_back(std::make_pair(b, a));
+            providerCustomerLinks.push_back(std::make_pair(a, b));
+        } else {
+            peerLinks.push_back(std::make_pair(a, b));
+            peerLinks.push_back(std::make_pair(b, a));
+        }
+    }
+
+    if (input.IsCorrupt()) {
+        std::cout << "The relationships file is corrupt or truncated: " << filePath << std::endl;
+        return false;
+    }
+
+    if (numSkippedLines > 0)
+        std::cout << "Skipped " << numSkippedLines << " lines of the CAIDA relationships file that are not links between two ASes: " << filePath << std::endl;
+
+    // IDs in the order of the ASNs
+    std::sort(asns.begin(), asns.end());
+    asns.erase(std::unique(asns.begin(), asns.end()), asns.end());
+    const size_t numASes = asns.size();
+
+    ASNTable table;
+    table.Build(asns, std::vector<std::pair<ASN, ASN_ID>>());
+    LinksToIDs(table, customerProviderLinks);
+    LinksToIDs(table, providerCustomerLinks);
+    LinksToIDs(table, peerLinks);
+
+    const Adjacency &providers = topology.providers, &customers = topology.customers;
+    topology.providers.Build(numASes, customerProviderLinks);
+    topology.customers.Build(numASes, providerCustomerLinks);
+    topology.peers.Build(numASes, peerLinks);
+
+    //***** Ranks, a rank at a time
+    std::vector<int> &ranks = topology.ranks;
+    ranks.assign(numASes, 0);
+
+    // Customers of every AS that are not ranked yet, and the providers ranking goes on to (a link left out to break a cycle is NONE)
+    std::unique_ptr<std::atomic<uint32_t>[]> unrankedCustomers(new std::atomic<uint32_t>[numASes]);
+    std::vector<ASN_ID> rankProviders = providers.indices;
+
+    std::vector<ASN_ID> currentRank;
+    for (ASN_ID id = 0; id < numASes; id++) {
+        unrankedCustomers[id] = customers.Size(id);
+        if (customers.Size(id) == 0)
+            currentRank.push_back(id);
+    }
+
+    std::vector<std::vector<ASN_ID>> threadNextRank(threadPool.GetNumThreads());
+    size_t numRanked = 0, numCycles = 0;
+    ASN_ID cycleSearchStart = 0;
+    int rank = 0;
+    while (numRanked < numASes) {
+        if (currentRank.empty()) {
+            // Every AS left waits on a customer. Following such customers from any of them ends up in a cycle (path[i + 1] is a customer of path[i])
+            while (unrankedCustomers[cycleSearchStart] == 0)
+                cycleSearchStart++;
+
+            std::vector<ASN_ID> path;
+            std::unordered_map<ASN_ID, size_t> pathIndices;
+            ASN_ID id = cycleSearchStart;
+            while (pathIndices.find(id) == pathIndices.end()) {
+                pathIndices[id] = path.size();
+                path.push_back(id);
+
+                // A customer that is neither ranked nor already left out of the ranking of this AS
+                for (size_t i = customers.offsets[id]; i < customers.offsets[id + 1]; i++) {
+                    const ASN_ID customer = customers.indices[i];
+                    auto link = std::find(rankProviders.begin() + providers.offsets[customer], rankProviders.begin() + providers.offsets[customer + 1], id);
+                    if (unrankedCustomers[customer] != 0 && link != rankProviders.begin() + providers.offsets[customer + 1]) {
+                        id = customer;
+                        break;
+                    }
+                }
+            }
+
+            // The cycle is path[cycleBegin...] (at least two ASes, links to the AS itself are skipped).
+            // Ranking goes on without its customer to provider link path[cycleBegin + 1] -> path[cycleBegin]
+            const size_t cycleBegin = pathIndices[id];
+            const ASN_ID provider = path[cycleBegin], customer = path[cycleBegin + 1];
+            *std::find(rankProviders.begin() + providers.offsets[customer], rankProviders.begin() + providers.offsets[customer + 1], provider) = ASNTable::NONE;
+            if (--unrankedCustomers[provider] == 0)
+                currentRank.push_back(provider);
+
+            if (numCycles++ < REPORTED_CYCLES) {
+                std::cout << "Cycle of customer to provider links in the CAIDA relationships, ranked without " << asns[customer] << " -> " << asns[provider] << ": "
+                    << asns[provider];
+                for (size_t i = path.size(); i-- > cycleBegin;)
+                    std::cout << " -> " << asns[path[i]];
+                std::cout << std::endl;
+            }
+            continue;
+        }
+
+        for (ASN_ID id : currentRank)
+            ranks[id] = rank;
+        numRanked += currentRank.size();
+
+        // The providers whose last customer is in this rank make up the next one
+        threadPool.ParallelFor(0, currentRank.size(), [&](size_t threadIndex, size_t begin, size_t end) {
+            std::vector<ASN_ID> &nextRank = threadNextRank[threadIndex];
+            for (size_t i = begin; i < end; i++) {
+                const ASN_ID id = currentRank[i];
+                for (size_t j = providers.offsets[id]; j < providers.offsets[id + 1]; j++) {
+                    const ASN_ID provider = rankProviders[j];
+                    if (provider != ASNTable::NONE && unrankedCustomers[provider].fetch_sub(1, std::memory_order_relaxed) == 1)
+                        nextRank.push_back(provider);
+                }
+            }
+        });
+
+        currentRank.clear();
+        for (auto &nextRank : threadNextRank) {
+            currentRank.insert(currentRank.end(), nextRank.begin(), nextRank.end());
+            nextRank.clear();
+        }
+        rank++;
+    }
+
+    if (numCycles > REPORTED_CYCLES)
+        std::cout << numCycles << " cycles of customer to provider links in the CAIDA relationships in all, each ranked without one of its links" << std::endl;
+
+    topology.asns.swap(asns);
+    return true;
+}
@@ -1,19 +1,17 @@
 #include <chrono>
 #include <stdarg.h>
 #include <cstring>
+#include <algorithm>
+#include <set>
 
 #include "Graphs/Graph.hpp"
+#include "Graphs/RibOverlay.hpp"
+#include "Graphs/CAIDARelationships.hpp"
+#include "RunReport.hpp"
+#include "TraceRecorder.hpp"
+#include "InputFile.hpp"
 #include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
 
-//Temporary struct for building the ranks
-struct RelationshipInfo {
-    ASN asn;
-    ASN_ID asnID;
-
-    int rank;
-    std::vector<ASN> peers, customers, providers, stubs;
-};
-
 /**
  * The plain C++ file buffering wasn't performing well in this case.
  * So here is a basic file buffer that lets you write into a buffer and flushes when it gets too full
@@ -28,11 +26,19 @@ private:
 
     char buffer[BUFFER_CAPACITY];
     int bufferLength;
+    size_t bytesWritten;
+    bool failed;
 
     FILE *f;
 
+    void put(const char *data, const size_t length) {
+        if (fwrite(data, sizeof(char), length, f) != length)
+            failed = true;
+        bytesWritten += length;
+    }
+
 public:
-    FileBuffer(FILE *f) : bufferLength(0), f(f) {
+    FileBuffer(FILE *f) : bufferLength(0), bytesWritten(0), failed(false), f(f) {
 
     }
 
@@ -43,51 +49,297 @@ public:
         bufferLength += vsprintf(&buffer[bufferLength], format, argptr);
 
         if (bufferLength > BUFFER_CAPACITY - BUFFER_FLUSH_THRESHOLD) {
-            fwrite(buffer, sizeof(char), bufferLength, f);
+            put(buffer, bufferLength);
             bufferLength = 0;
         }
 
         va_end(argptr);
     }
 
+    /**
+     * Writes the bytes as they are, however long
+     */
+    void append(const char *data, const size_t length) {
+        if (bufferLength + length > BUFFER_CAPACITY - BUFFER_FLUSH_THRESHOLD) {
+            flush();
+            if (length > BUFFER_CAPACITY - BUFFER_FLUSH_THRESHOLD) {
+                put(data, length);
+                return;
+            }
+        }
+
+        memcpy(&buffer[bufferLength], data, length);
+        bufferLength += length;
+    }
+
     void flush() {
-        fwrite(buffer, sizeof(char), bufferLength, f);
+        put(buffer, bufferLength);
         bufferLength = 0;
     }
+
+    inline size_t getBytesWritten() const { return bytesWritten; }
+
+    /**
+     * @return whether any write came up short (disk full, I/O error)
+     */
+    inline bool hasFailed() const { return failed; }
 };
 
-Graph::Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval) 
-    : customerToProviderPreferences(customerToProviderPreferences), stubRemoval(stubRemoval)
-{
-    rapidcsv::Document relationshipsCSV(relationshipsFilePath, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(SEPARATED_VALUES_DELIMETER));
-    std::vector<RelationshipInfo> relationshipInfo;
+/**
+ * The received from pointers of one prefix block form a forest: every AS with the prefix points at the neighbor it came from,
+ *  up to the origins, which point at themselves. The path of an AS is its own ASN followed by the path of its parent,
+ *  so every path is formatted once and reused by all the ASes below it, rather than walking (and formatting) the hops again for every AS.
+ * Paths are only formatted for the ASes asked for and their ancestors, into one text arena that is reused from block to block.
+ *
+ * A path longer than Traceback would follow, or a cycle, is left to Traceback so the results stay the same.
+ */
+class TracebackForest {
+private:
+    static const uint8_t UNSEEN = 0;
+    static const uint8_t ON_STACK = 1;
+    static const uint8_t FORMATTED = 2;
+    static const uint8_t TOO_LONG = 3;
+
+    // Traceback gives up after this many ASNs
+    static const uint8_t MAXIMUM_PATH_LENGTH = 99;
+
+    // "-2147483648,"
+    static const size_t MAXIMUM_ASN_TEXT_LENGTH = 12;
+
+    const std::vector<ASN> &idToASN;
+
+    // Per AS: its path as "asn,...,origin" (what is written between the braces) in the arena, the number of ASNs in it and the last one
+    std::vector<uint8_t> state;
+    std::vector<uint32_t> textBegin;
+    std::vector<uint16_t> textLength;
+    std::vector<uint8_t> pathLength;
+    std::vector<ASN> pathOrigin;
+    std::vector<char> arena;
+    size_t arenaLength;
+
+    std::vector<ASN_ID> touched;
+    std::vector<ASN_ID> stack;
+
+    /**
+     * Same as printf %d, like the rest of the results row
+     */
+    inline void AppendASN(const ASN asn) {
+        char digits[12];
+        int value = (int) asn;
+        unsigned int magnitude = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+
+        int length = 0;
+        do {
+            digits[length++] = '0' + magnitude % 10;
+            magnitude /= 10;
+        } while (magnitude != 0);
+
+        if (value < 0)
+            arena[arenaLength++] = '-';
+        while (length > 0)
+            arena[arenaLength++] = digits[--length];
+    }
 
-    size_t maximumRank = 0;
-    ASN_ID nextID = 0;
+public:
+    TracebackForest(const std::vector<ASN> &idToASN) : idToASN(idToASN), state(idToASN.size(), UNSEEN), textBegin(idToASN.size(), 0),
+        textLength(idToASN.size(), 0), pathLength(idToASN.size(), 0), pathOrigin(idToASN.size(), 0), arenaLength(0) {
+
+    }
+
+    /**
+     * Forgets the paths of the previous prefix block, only touching the ASes it formatted
+     */
+    void Reset() {
+        for (ASN_ID id : touched)
+            state[id] = UNSEEN;
+        touched.clear();
+        arenaLength = 0;
+    }
+
+    /**
+     * Formats the path of an AS, and of every ancestor not formatted yet: up the received from pointers to the first formatted one (or an origin),
+     *  then back down, every AS appending the path of its parent to its own ASN
+     *
+     * @return false if Traceback has to be used for this AS
+     */
+    template <typename RibView>
+    bool Resolve(const RibView &view, const ASN_ID startingID, const uint32_t prefixBlockID) {
+        ASN_ID id = startingID;
+        while (state[id] == UNSEEN) {
+            state[id] = ON_STACK;
+            touched.push_back(id);
+            stack.push_back(id);
+
+            const ASN_ID parentID = view.GetCachedData_ReadOnly(id, prefixBlockID).GetRecievedFromID();
+            if (parentID == id)
+                break;
+            id = parentID;
+        }
+
+        // Back on the stack: a cycle, nothing on it has a path Traceback would agree with
+        if (state[id] == ON_STACK && id != stack.back()) {
+            for (ASN_ID stackID : stack)
+                state[stackID] = TOO_LONG;
+            stack.clear();
+            return false;
+        }
+
+        while (!stack.empty()) {
+            const ASN_ID current = stack.back();
+            stack.pop_back();
+
+            const AnnouncementCachedData &ann = view.GetCachedData_ReadOnly(current, prefixBlockID);
+            const ASN_ID parentID = ann.GetRecievedFromID();
+            const bool origin = parentID == current;
+            if (!origin && (state[parentID] != FORMATTED || pathLength[parentID] >= MAXIMUM_PATH_LENGTH)) {
+                state[current] = TOO_LONG;
+                continue;
+            }
+
+            // Room for the whole path up front, the parent's text is copied from the arena itself
+            const size_t needed = 2 * MAXIMUM_ASN_TEXT_LENGTH + (origin ? 0 : textLength[parentID]);
+            if (arenaLength + needed > arena.size())
+                arena.resize(std::max(arena.size() * 2, arenaLength + needed));
 
-    //Store the relationships, assign IDs, and find the maximum rank
-    for (size_t rowIndex = 0; rowIndex < relationshipsCSV.GetRowCount(); rowIndex++) {
-        if (stubRemoval && relationshipsCSV.GetCell<std::string>("stub", rowIndex) == "TRUE")
+            textBegin[current] = arenaLength;
+            AppendASN(idToASN[current]);
+
+            if (origin) {
+                pathLength[current] = 1;
+                pathOrigin[current] = idToASN[current];
+
+                // The origin was not in the graph (stub removal), its ASN comes from the static data
+                if (ann.GetPathLength() == 2) {
+                    pathOrigin[current] = view.GetStaticData_ReadOnly(ann.GetStaticDataIndex()).originASN;
+                    arena[arenaLength++] = ',';
+                    AppendASN(pathOrigin[current]);
+                    pathLength[current] = 2;
+                }
+            } else {
+                arena[arenaLength++] = ',';
+                memcpy(&arena[arenaLength], &arena[textBegin[parentID]], textLength[parentID]);
+                arenaLength += textLength[parentID];
+                pathLength[current] = pathLength[parentID] + 1;
+                pathOrigin[current] = pathOrigin[parentID];
+            }
+
+            textLength[current] = arenaLength - textBegin[current];
+            state[current] = FORMATTED;
+        }
+
+        return state[startingID] == FORMATTED;
+    }
+
+    inline const char* GetPathText(const ASN_ID id) const { return &arena[textBegin[id]]; }
+    inline size_t GetPathTextLength(const ASN_ID id) const { return textLength[id]; }
+    inline ASN GetPathOrigin(const ASN_ID id) const { return pathOrigin[id]; }
+};
+
+Graph::Graph() : numLanes(1), stubRemoval(false), retainSeededPaths(false), threadPool(new ThreadPool(1)), numaPlacement(false), profiling(false) {
+
+}
+
+/**
+ * Reads a compressed relationships file (see InputFile) a line at a time into one entry per AS, skipping stubs with stub removal
+ *
+ * @return false if the file could not be read, misses a column or is corrupt
+ */
+static bool ReadCompressedRelationships(const std::string &filePath, const bool stubRemoval, std::vector<RelationshipInfo> &relationshipInfo) {
+    InputFile input;
+    std::string line;
+    std::vector<std::string> cells;
+    if (!input.Open(filePath) || !input.ReadLine(line))
+        return false;
+
+    Util::splitSeparatedValues(line, cells);
+    const int asnColumn = Util::findColumn(cells, "asn"), rankColumn = Util::findColumn(cells, "propagation_rank"), stubColumn = Util::findColumn(cells, "stub"),
+        providersColumn = Util::findColumn(cells, "providers"), peersColumn = Util::findColumn(cells, "peers"), customersColumn = Util::findColumn(cells, "customers"),
+        stubsColumn = Util::findColumn(cells, "stubs");
+    if (asnColumn < 0 || rankColumn < 0 || stubColumn < 0 || providersColumn < 0 || peersColumn < 0 || customersColumn < 0 || stubsColumn < 0)
+        return false;
+
+    const size_t numColumns = cells.size();
+    while (input.ReadLine(line)) {
+        Util::splitSeparatedValues(line, cells);
+        if (cells.size() < numColumns)
+            continue;
+
+        if (stubRemoval && cells[stubColumn] == "TRUE")
             continue;
 
         RelationshipInfo info;
+        info.asn = strtoul(cells[asnColumn].c_str(), nullptr, 10);
+        info.rank = atoi(cells[rankColumn].c_str());
+        Util::parseASNList(cells[providersColumn], info.providers);
+        Util::parseASNList(cells[peersColumn], info.peers);
+        Util::parseASNList(cells[customersColumn], info.customers);
+        Util::parseASNList(cells[stubsColumn], info.stubs);
+        relationshipInfo.push_back(std::move(info));
+    }
 
-        info.asn = relationshipsCSV.GetCell<ASN>("asn", rowIndex);
+    return !input.IsCorrupt();
+}
+
+Graph::Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval, const size_t numThreads) 
+    : customerToProviderPreferences(customerToProviderPreferences), numLanes(1), stubRemoval(stubRemoval), retainSeededPaths(false), threadPool(new ThreadPool(numThreads)), numaPlacement(false), profiling(false)
+{
+    if (CAIDARelationships::IsCAIDAFile(relationshipsFilePath)) {
+        // Ranks and stubs are not in the file, they are computed from the links
+        CAIDATopology topology;
+        if (!CAIDARelationships::Read(relationshipsFilePath, *threadPool, topology))
+            topology = CAIDATopology();
+
+        BuildRelationships(topology);
+        return;
+    }
+
+    std::vector<RelationshipInfo> relationshipInfo;
+    if (InputFile::IsCompressed(relationshipsFilePath)) {
+        // A partial topology would propagate without complaint, none at all is noticed
+        if (!ReadCompressedRelationships(relationshipsFilePath, stubRemoval, relationshipInfo)) {
+            std::cout << "Could not read the relationships file (corrupt or truncated?): " << relationshipsFilePath << std::endl;
+            relationshipInfo.clear();
+        }
+    } else {
+        rapidcsv::Document relationshipsCSV(relationshipsFilePath, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(SEPARATED_VALUES_DELIMETER));
+
+        for (size_t rowIndex = 0; rowIndex < relationshipsCSV.GetRowCount(); rowIndex++) {
+            if (stubRemoval && relationshipsCSV.GetCell<std::string>("stub", rowIndex) == "TRUE")
+                continue;
+
+            RelationshipInfo info;
+            info.asn = relationshipsCSV.GetCell<ASN>("asn", rowIndex);
+            info.rank = relationshipsCSV.GetCell<int>("propagation_rank", rowIndex);
+            Util::parseASNList(relationshipsCSV.GetCell<std::string>("providers", rowIndex), info.providers);
+            Util::parseASNList(relationshipsCSV.GetCell<std::string>("peers", rowIndex), info.peers);
+            Util::parseASNList(relationshipsCSV.GetCell<std::string>("customers", rowIndex), info.customers);
+            Util::parseASNList(relationshipsCSV.GetCell<std::string>("stubs", rowIndex), info.stubs);
+            relationshipInfo.push_back(std::move(info));
+        }
+    }
+
+    BuildRelationships(relationshipInfo);
+}
+
+Graph::Graph(std::vector<RelationshipInfo> relationshipInfo, std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences, const bool stubRemoval)
+    : customerToProviderPreferences(customerToProviderPreferences), numLanes(1), stubRemoval(stubRemoval), retainSeededPaths(false), threadPool(new ThreadPool(1)), numaPlacement(false), profiling(false)
+{
+    BuildRelationships(relationshipInfo);
+}
+
+void Graph::BuildRelationships(std::vector<RelationshipInfo> &relationshipInfo) {
+    size_t maximumRank = 0;
+    ASN_ID nextID = 0;
+
+    //Assign IDs, and find the maximum rank
+    for (RelationshipInfo &info : relationshipInfo) {
         info.asnID = nextID;
 
-        asnToID.insert({ info.asn, info.asnID });
         idToASN.push_back(info.asn);
 
-        info.rank = relationshipsCSV.GetCell<int>("propagation_rank", rowIndex);
-
         if (info.rank > maximumRank)
             maximumRank = info.rank;
 
-        info.providers = Util::parseASNList(relationshipsCSV.GetCell<std::string>("providers", rowIndex));
-        info.peers = Util::parseASNList(relationshipsCSV.GetCell<std::string>("peers", rowIndex));
-        info.customers = Util::parseASNList(relationshipsCSV.GetCell<std::string>("customers", rowIndex));
-        info.stubs = Util::parseASNList(relationshipsCSV.GetCell<std::string>("stubs", rowIndex));
-
         // write down the priorities to be lookedup later during seeding
         //PERF_TODO: These can be optimized (redundant inserts). Eh? Is it worth it?
         for (auto providerASN : info.providers) {
@@ -105,8 +357,6 @@ Graph::Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, s
             relationshipPriority.insert({ std::make_pair(cutomerASN, info.asn), RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER });
         }
 
-        relationshipInfo.push_back(info);
-
         idToImportPolicy.push_back(std::unique_ptr<BGPPolicy>(new BGPPolicy(info.asn, info.asnID)));
 
         nextID++;
@@ -127,6 +377,13 @@ Graph::Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, s
     // Allocate space for the rank structure and point its content to the corresponding data
     // Also put the pointer to other AS data in relationship structures 
 
+    // Every stub goes to the first provider listing it
+    std::vector<std::pair<ASN, ASN_ID>> stubToProviderID;
+    for (const RelationshipInfo& info : relationshipInfo)
+        for (ASN stubASN : info.stubs)
+            stubToProviderID.push_back(std::make_pair(stubASN, info.asnID));
+    asnTable.Build(idToASN, stubToProviderID);
+
     //ranks are 0 indexed, so the size of the structure holding the ranks is 1 + maximum index
     rankToIDs.resize(maximumRank + 1);
     for (int i = 0; i < relationshipInfo.size(); i++) {
@@ -135,45 +392,150 @@ Graph::Graph(const std::string &relationshipsFilePath, std::unordered_map<ASN, s
         rankToIDs[relationshipInfo[i].rank].push_back(info.asnID);
 
         // Write down the ASN and ID of each AS for each relationship
+        ASN_ID id;
         for (ASN provider : info.providers) {
-            auto idSearch = asnToID.find(provider);
-            if (idSearch == asnToID.end())
+            if (!asnTable.FindID(provider, id))
                 continue;
 
-            asIDToProviderIDs[i].push_back( { provider, idSearch->second } );
+            asIDToProviderIDs[i].push_back( { provider, id } );
         }
 
         for (ASN peer : info.peers) {
-            auto idSearch = asnToID.find(peer);
-            if (idSearch == asnToID.end())
+            if (!asnTable.FindID(peer, id))
                 continue;
 
-            asIDToPeerIDs[i].push_back( { peer, idSearch->second } );
-        }
-
-        for(ASN stubASN : info.stubs) {
-            stubASNToProviderID.insert(std::make_pair(stubASN, i));
+            asIDToPeerIDs[i].push_back( { peer, id } );
         }
 
         for (ASN customer : info.customers) {
-            auto idSearch = asnToID.find(customer);
-            if (idSearch == asnToID.end())
+            if (!asnTable.FindID(customer, id))
                 continue;
 
-            asIDToCustomerIDs[i].push_back( { customer, idSearch->second } );
+            asIDToCustomerIDs[i].push_back( { customer, id } );
         }
     }
 }
 
+void Graph::BuildRelationships(const CAIDATopology &topology) {
+    // IDs in the order of the ASNs, as the rows of a relationships file would be. Removed stubs get none
+    std::vector<ASN_ID> indexToID(topology.asns.size(), ASNTable::NONE);
+    size_t maximumRank = 0;
+    for (uint32_t index = 0; index < topology.asns.size(); index++) {
+        if (stubRemoval && topology.IsStub(index))
+            continue;
+
+        indexToID[index] = idToASN.size();
+        idToASN.push_back(topology.asns[index]);
+        maximumRank = std::max(maximumRank, (size_t) topology.ranks[index]);
+    }
+
+    asIDToProviderIDs.resize(idToASN.size());
+    asIDToPeerIDs.resize(idToASN.size());
+    asIDToCustomerIDs.resize(idToASN.size());
+    localRibs.SetNumASes(idToASN.size());
+    rankToIDs.resize(maximumRank + 1);
+
+    // Same priorities, neighbors and stubs as the rows of the file would give, straight from the links
+    std::vector<std::pair<ASN, ASN_ID>> stubToProviderID;
+    for (uint32_t index = 0; index < topology.asns.size(); index++) {
+        const ASN_ID id = indexToID[index];
+        if (id == ASNTable::NONE)
+            continue;
+
+        const ASN asn = topology.asns[index];
+        auto link = [&](const Adjacency &adjacency, std::vector<ASN_ASNID_PAIR> &neighborIDs, const uint8_t priority, const uint8_t neighborPriority) {
+            for (size_t i = adjacency.offsets[index]; i < adjacency.offsets[index + 1]; i++) {
+                const ASN neighbor = topology.asns[adjacency.indices[i]];
+                relationshipPriority.insert({ std::make_pair(asn, neighbor), priority });
+                relationshipPriority.insert({ std::make_pair(neighbor, asn), neighborPriority });
+
+                if (indexToID[adjacency.indices[i]] != ASNTable::NONE)
+                    neighborIDs.push_back( { neighbor, indexToID[adjacency.indices[i]] } );
+            }
+        };
+
+        link(topology.providers, asIDToProviderIDs[id], RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER, RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER);
+        link(topology.peers, asIDToPeerIDs[id], RELATIONSHIP_PRIORITY_PEER_TO_PEER, RELATIONSHIP_PRIORITY_PEER_TO_PEER);
+        link(topology.customers, asIDToCustomerIDs[id], RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER, RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER);
+
+        for (size_t i = topology.customers.offsets[index]; i < topology.customers.offsets[index + 1]; i++) {
+            if (topology.IsStub(topology.customers.indices[i]))
+                stubToProviderID.push_back(std::make_pair(topology.asns[topology.customers.indices[i]], id));
+        }
+
+        rankToIDs[topology.ranks[index]].push_back(id);
+        idToImportPolicy.push_back(std::unique_ptr<BGPPolicy>(new BGPPolicy(asn, id)));
+    }
+
+    asnTable.Build(idToASN, stubToProviderID);
+}
+
+void Graph::SetNumThreads(const size_t numThreads) {
+    threadPool.reset(new ThreadPool(numThreads));
+    shardPeerStaging.clear();
+
+    if (numaPlacement)
+        ApplyNumaPlacement();
+    if (profiling)
+        SetProfiling(true);
+}
+
+bool Graph::SetProfiling(const bool enabled) {
+    profiling = enabled;
+    threadCounters.clear();
+    if (!profiling)
+        return true;
+
+    // Counters only count the thread that opens them, so every thread of the pool opens its own
+    threadCounters.resize(GetNumThreads());
+    std::vector<char> opened(GetNumThreads(), 0);
+    threadPool->ParallelFor(0, GetNumThreads(), [&](size_t threadIndex, size_t, size_t) {
+        threadCounters[threadIndex].reset(new PerfCounters());
+        opened[threadIndex] = threadCounters[threadIndex]->Open();
+    });
+
+    return std::find(opened.begin(), opened.end(), 0) == opened.end();
+}
+
+void Graph::SetNumaPlacement(const bool enabled) {
+    numaPlacement = enabled;
+    shardPeerStaging.clear();
+
+    if (numaPlacement)
+        ApplyNumaPlacement();
+    else
+        localRibs.SetShardNodes(std::vector<int>());
+}
+
+void Graph::ApplyNumaPlacement() {
+    const size_t numThreads = GetNumThreads();
+    const size_t numNodes = NumaTopology::GetNumNodes();
+
+    // Consecutive threads share a node, so consecutive shards (and tiles) do too
+    std::vector<int> threadNodes(numThreads);
+    for (size_t i = 0; i < numThreads; i++)
+        threadNodes[i] = (i * numNodes) / numThreads;
+
+    // A range of one index per thread, so every thread (the calling thread included) pins itself
+    threadPool->ParallelFor(0, numThreads, [&](size_t threadIndex, size_t, size_t) {
+        NumaTopology::PinCurrentThreadToNode(threadNodes[threadIndex]);
+    });
+
+    localRibs.SetShardNodes(threadNodes);
+}
+
+void Graph::SetRibBacking(const std::string &backingFilePath, const size_t tileMemoryBytes) {
+    size_t bytesPerPrefix = std::max(GetNumASes(), (size_t) 1) * sizeof(AnnouncementCachedData);
+    localRibs.UseFileBacking(backingFilePath, std::max(tileMemoryBytes / bytesPerPrefix, (size_t) 1));
+}
+
 void Graph::ResetAllAnnouncements() {
-    for (int i = 0; i < GetNumASes(); i++) {
-    for (int j = 0; j < GetNumPrefixes(); j++) {
-        AnnouncementCachedData& ann = GetCachedData(i, j);
-        ann.SetDefaultState();
-    }}
+    routeIndex.reset();
+    localRibs.ResetAll();
 }
 
 void Graph::ResetAllNonSeededAnnouncements() {
+    routeIndex.reset();
     for (int i = 0; i < GetNumASes(); i++) {
     for (int j = 0; j < GetNumPrefixes(); j++) {
         AnnouncementCachedData& ann = GetCachedData(i, j);
@@ -184,21 +546,144 @@ void Graph::ResetAllNonSeededAnnouncements() {
     }}
 }
 
+void Graph::ResetPrefixBlock(const uint32_t prefixBlockID) {
+    routeIndex.reset();
+    for (ASN_ID i = 0; i < GetNumASes(); i++)
+        GetCachedData(i, prefixBlockID).SetDefaultState();
+}
+
 void Graph::SeedBlock(const std::string& filePathAnnouncements, const SeedingConfiguration &config) {
+    SetLaneProviderPreferences(std::vector<LaneConfiguration>());
+    SeedLanes(filePathAnnouncements, std::vector<SeedingConfiguration>(1, config));
+}
+
+void Graph::SeedBlock(const std::string& filePathAnnouncements, const std::vector<LaneConfiguration> &lanes) {
+    std::vector<SeedingConfiguration> configs;
+    for (auto &lane : lanes)
+        configs.push_back(lane.seeding);
+
+    SetLaneProviderPreferences(lanes);
+    SeedLanes(filePathAnnouncements, configs);
+}
+
+void Graph::SeedBlock(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const SeedingConfiguration &config) {
+    SetLaneProviderPreferences(std::vector<LaneConfiguration>());
+    SeedLanes(announcements, numPrefixBlocks, std::vector<SeedingConfiguration>(1, config));
+}
+
+void Graph::SeedBlock(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const std::vector<LaneConfiguration> &lanes) {
+    std::vector<SeedingConfiguration> configs;
+    for (auto &lane : lanes)
+        configs.push_back(lane.seeding);
+
+    SetLaneProviderPreferences(lanes);
+    SeedLanes(announcements, numPrefixBlocks, configs);
+}
+
+void Graph::SwapPropagatedBlocks(PropagatedBlocks &blocks) {
+    routeIndex.reset();
+    if (blocks.localRibs.GetNumASes() != GetNumASes())
+        blocks.localRibs.SetNumASes(GetNumASes());
+
+    localRibs.Swap(blocks.localRibs);
+    announcementStaticData.swap(blocks.announcementStaticData);
+}
+
+void Graph::SetLaneProviderPreferences(const std::vector<LaneConfiguration> &lanes) {
+    laneProviderPreferences.clear();
+    laneDependentCustomers.clear();
+    if (lanes.size() <= 1) {
+        if (lanes.size() == 1)
+            laneProviderPreferences.push_back(lanes[0].customerToProviderPreferences);
+        return;
+    }
+
+    for (auto &lane : lanes)
+        laneProviderPreferences.push_back(lane.customerToProviderPreferences);
+
+    // A customer is lane dependent if any lane has other preferences for it than lane 0 (including none at all)
+    for (auto &preferences : laneProviderPreferences) {
+        for (auto &kv : preferences) {
+            for (auto &other : laneProviderPreferences) {
+                auto search = other.find(kv.first);
+                if (search == other.end() || search->second != kv.second) {
+                    laneDependentCustomers.insert(kv.first);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Reads a compressed announcements file (see InputFile) a line at a time
+ *
+ * @param numPrefixBlocks -> Set to one past the highest prefix block ID
+ * @return false if the file could not be read, misses a column or is corrupt
+ */
+static bool ReadCompressedAnnouncements(const std::string &filePath, std::vector<ScenarioAnnouncement> &announcements, uint32_t &numPrefixBlocks) {
+    numPrefixBlocks = 0;
+
+    InputFile input;
+    std::string line;
+    std::vector<std::string> cells;
+    if (!input.Open(filePath) || !input.ReadLine(line))
+        return false;
+
+    Util::splitSeparatedValues(line, cells);
+    const int prefixColumn = Util::findColumn(cells, "prefix"), pathColumn = Util::findColumn(cells, "as_path"), timestampColumn = Util::findColumn(cells, "timestamp"),
+        prefixIDColumn = Util::findColumn(cells, "prefix_id"), blockColumn = Util::findColumn(cells, "prefix_block_id");
+    if (prefixColumn < 0 || pathColumn < 0 || timestampColumn < 0 || prefixIDColumn < 0 || blockColumn < 0)
+        return false;
+
+    const size_t numColumns = cells.size();
+    while (input.ReadLine(line)) {
+        Util::splitSeparatedValues(line, cells);
+        if (cells.size() < numColumns)
+            continue;
+
+        announcements.push_back(ScenarioAnnouncement());
+        ScenarioAnnouncement &announcement = announcements.back();
+        announcement.prefixString = cells[prefixColumn];
+        Util::parseASNList(cells[pathColumn], announcement.asPath);
+        announcement.timestamp = strtoll(cells[timestampColumn].c_str(), nullptr, 10);
+        announcement.prefix.global_id = strtoul(cells[prefixIDColumn].c_str(), nullptr, 10);
+        announcement.prefix.block_id = strtoul(cells[blockColumn].c_str(), nullptr, 10);
+
+        numPrefixBlocks = std::max(numPrefixBlocks, announcement.prefix.block_id + 1);
+    }
+
+    return !input.IsCorrupt();
+}
+
+void Graph::SeedLanes(const std::string& filePathAnnouncements, const std::vector<SeedingConfiguration> &configs) {
+    // rapidcsv needs the whole file, a compressed one is decompressed and parsed a chunk at a time instead
+    if (InputFile::IsCompressed(filePathAnnouncements)) {
+        std::vector<ScenarioAnnouncement> announcements;
+        uint32_t numPrefixBlocks;
+        if (!ReadCompressedAnnouncements(filePathAnnouncements, announcements, numPrefixBlocks))
+            std::cout << "Could not read the announcements file: " << filePathAnnouncements << std::endl;
+
+        SeedLanes(announcements, numPrefixBlocks, configs);
+        return;
+    }
+
+    BGPX_TRACE_SCOPE("seed_block", "seed");
     rapidcsv::Document announcements_csv(filePathAnnouncements, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(SEPARATED_VALUES_DELIMETER));
 
-    // Allocate memory for the local ribs and the static announcement data
-    announcementStaticData.resize(announcements_csv.GetRowCount());   
-    localRibs.SetNumPrefixes(announcements_csv.GetRowCount()); // poor-man estimate of the number of unique prefixes
+    // One prefix block per row is a poor-man estimate of the number of unique prefixes
+    PrepareSeeding(announcements_csv.GetRowCount(), announcements_csv.GetRowCount(), configs.size());
+    const PropagationStatistics statisticsStart = DefaultStatistics::ReadThread();
 
-    ResetAllAnnouncements();
+    // Reused by every row, SeedRow copies what it keeps
+    std::vector<ASN> as_path;
 
     for (size_t row_index = 0; row_index < announcements_csv.GetRowCount(); row_index++) {
         //***** PARSING
         std::string prefixString = announcements_csv.GetCell<std::string>("prefix", row_index);
         std::string as_path_string = announcements_csv.GetCell<std::string>("as_path", row_index);
 
-        std::vector<ASN> as_path = Util::parseASNList(as_path_string);
+        Util::parseASNList(as_path_string, as_path);
 
         int64_t timestamp = announcements_csv.GetCell<int64_t>("timestamp", row_index);
         ASN origin = announcements_csv.GetCell<ASN>("origin", row_index);
@@ -210,8 +695,52 @@ void Graph::SeedBlock(const std::string& filePathAnnouncements, const SeedingCon
         prefix.global_id = prefix_id;
         prefix.block_id = prefix_block_id;
 
-        SeedPath(as_path, row_index, prefix, prefixString, timestamp, config);
+        SeedRow(as_path, row_index, prefix, prefixString, timestamp, configs);
+    }
+
+    statisticsProfile.seeding = DefaultStatistics::ReadThread().Since(statisticsStart);
+}
+
+void Graph::SeedLanes(const std::vector<ScenarioAnnouncement>& announcements, const uint32_t numPrefixBlocks, const std::vector<SeedingConfiguration> &configs) {
+    BGPX_TRACE_SCOPE("seed_block", "seed");
+    PrepareSeeding(announcements.size(), numPrefixBlocks, configs.size());
+    const PropagationStatistics statisticsStart = DefaultStatistics::ReadThread();
+
+    for (size_t row_index = 0; row_index < announcements.size(); row_index++) {
+        const ScenarioAnnouncement &announcement = announcements[row_index];
+        SeedRow(announcement.asPath, row_index, announcement.prefix, announcement.prefixString, announcement.timestamp, configs);
+    }
+
+    statisticsProfile.seeding = DefaultStatistics::ReadThread().Since(statisticsStart);
+}
+
+void Graph::PrepareSeeding(const size_t numRows, const size_t numPrefixBlocks, const size_t lanes) {
+    // Allocate memory for the local ribs and the static announcement data
+    routeIndex.reset();
+    announcementStaticData.clear();
+    announcementStaticData.resize(numRows);
+    seededPaths.clear();
+    freeStaticDataIndices.clear();
+    numLanes = std::max(lanes, (size_t) 1);
+    localRibs.Reshape(numPrefixBlocks * numLanes); // Reset, reusing the previous allocation
+
+    statisticsProfile = PropagationStatisticsProfile();
+}
+
+void Graph::SeedRow(const std::vector<ASN>& asPath, size_t staticDataIndex, const Prefix& prefix, const std::string& prefixString, int64_t timestamp, const std::vector<SeedingConfiguration> &configs) {
+    if (numLanes == 1) {
+        SeedPath(asPath, staticDataIndex, prefix, prefixString, timestamp, configs[0]);
+        return;
     }
+
+    // Every lane seeds its own column of the prefix block. The static data is shared, and keeps the block ID of the announcement
+    for (size_t lane = 0; lane < numLanes; lane++) {
+        Prefix lanePrefix = prefix;
+        lanePrefix.block_id = prefix.block_id * numLanes + lane;
+        SeedPath(asPath, staticDataIndex, lanePrefix, prefixString, timestamp, configs[lane]);
+    }
+
+    announcementStaticData[staticDataIndex].prefix = prefix;
 }
 
 //TODO Recieved_from needs to be much more robust to the absence of known ASNs in the graph.
@@ -220,7 +749,23 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
     if (asPath.size() == 0)
         return;
 
+    // Re-seeding an announcement (delta mode) keeps the path it already has in the arena
     AnnouncementStaticData &staticData = announcementStaticData[staticDataIndex];
+    if (retainSeededPaths && staticData.seededPathLength == 0) {
+        staticData.seededPathOffset = seededPaths.size();
+        staticData.seededPathLength = asPath.size();
+        seededPaths.insert(seededPaths.end(), asPath.begin(), asPath.end());
+    }
+
+    SeedPath(*this, asPath, staticDataIndex, prefix, prefixString, timestamp, config);
+}
+
+template <typename RibView, typename Statistics>
+void Graph::SeedPath(RibView &view, const std::vector<ASN>& asPath, size_t staticDataIndex, const Prefix& prefix, const std::string& prefixString, int64_t timestamp, const SeedingConfiguration &config) const {
+    if (asPath.size() == 0)
+        return;
+
+    AnnouncementStaticData &staticData = view.GetStaticData(staticDataIndex);
 
     staticData.originASN = asPath[asPath.size() - 1];
     staticData.prefix = prefix;
@@ -229,26 +774,26 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
 
     ASN_ID lastID;
     bool lastIDSet = false;
+    Statistics statistics;
 
     int end_index = config.originOnly ? asPath.size() - 1 : 0;
     for (int i = asPath.size() - 1; i >= end_index; i--) {
         // If AS not in the graph, skip it
         // TODO: This should be an error
-        auto asn_search = asnToID.find(asPath[i]);
-        if (asn_search == asnToID.end()) {
-            auto stubSearch = stubASNToProviderID.find(asPath[i]);
-            if (stubRemoval && (config.originOnly || asPath.size() == 1) && stubSearch != stubASNToProviderID.end()) {
+        const ASNTable::Entry entry = asnTable.Find(asPath[i]);
+        if (entry.id == ASNTable::NONE) {
+            if (stubRemoval && (config.originOnly || asPath.size() == 1) && entry.stubProviderID != ASNTable::NONE) {
                 // We have a stub on the path during stub removal, and it is the only one getting a seeded announcement.
                 // When removing stubs, this is a problem because there is no local rib to put the announcement in (since the stub was removed).
                 // Thus we must propagate to the provider now
                 // TODO handle when there is more than one stub propagating the same prefix (technically the ann in the stub is seeded. This is not accounted for in the result generation)
 
-                AnnouncementCachedData &providerAnn = localRibs.GetAnnouncement(stubSearch->second, prefix.block_id);
+                AnnouncementCachedData &providerAnn = view.GetCachedData(entry.stubProviderID, prefix.block_id);
                 if (providerAnn.isDefaultState()) {
                     providerAnn.SetRelationship(RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER);
                     providerAnn.SetStaticDataIndex(staticDataIndex);
                     providerAnn.SetPathLength(2);
-                    providerAnn.SetRecievedFromID(stubSearch->second);
+                    providerAnn.SetRecievedFromID(entry.stubProviderID);
                 }
             }
             continue;
@@ -258,8 +803,8 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
         if (i < asPath.size() - 1 && asPath[i] == asPath[i + 1])
             continue;
 
-        ASN currentASN = asn_search->first;
-        ASN_ID currentID = asn_search->second;
+        ASN currentASN = asPath[i];
+        ASN_ID currentID = entry.id;
 
         uint8_t relationship = RELATIONSHIP_PRIORITY_ORIGIN;
         if (i < asPath.size() - 1) {
@@ -285,13 +830,13 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
         //TODO: Not all of these if-statements plz
          
         //If there exists an announcement for this prefix already
-        AnnouncementCachedData& currentAnn = GetCachedData(currentID, prefix.block_id);
+        AnnouncementCachedData& currentAnn = view.GetCachedData(currentID, prefix.block_id);
 
         //Recieve from itself if it is the origin
         ASN recieved_from_asn = i < asPath.size() - 1 ? asPath[i + 1] : currentASN;
 
         if (!currentAnn.isDefaultState()) {
-            const AnnouncementStaticData &currentStaticData = announcementStaticData[currentAnn.GetStaticDataIndex()];
+            const AnnouncementStaticData &currentStaticData = view.GetStaticData_ReadOnly(currentAnn.GetStaticDataIndex());
             int64_t currentTimestamp = currentStaticData.timestamp;
             ASN currentRecievedFromASN;
 
@@ -303,27 +848,44 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
                 currentRecievedFromASN = idToASN[currentAnn.GetRecievedFromID()];
             }
 
-            if (config.timestampComparison == TIMESTAMP_COMPARISON::PREFER_NEWER && timestamp > currentTimestamp)
+            if (config.timestampComparison == TIMESTAMP_COMPARISON::PREFER_NEWER && timestamp > currentTimestamp) {
+                statistics.Seeded(SEEDING_RULE_TIMESTAMP, false);
                 continue;
-            else if (config.timestampComparison == TIMESTAMP_COMPARISON::PREFER_OLDER && timestamp < currentTimestamp)
+            } else if (config.timestampComparison == TIMESTAMP_COMPARISON::PREFER_OLDER && timestamp < currentTimestamp) {
+                statistics.Seeded(SEEDING_RULE_TIMESTAMP, false);
                 continue;
+            }
 
             if (timestamp == currentTimestamp) {
                 uint8_t currentRelationship = currentAnn.GetRelationship();
                 uint8_t currentPathLength = currentAnn.GetPathLength();
-                if (currentRelationship > relationship || currentPathLength < newPathLength)
+                if (currentRelationship > relationship || currentPathLength < newPathLength) {
+                    statistics.Seeded(currentRelationship != relationship ? SEEDING_RULE_RELATIONSHIP : SEEDING_RULE_PATH_LENGTH, false);
                     continue;
+                }
 
                 if (currentRelationship == relationship && currentPathLength == newPathLength) {
                     if (config.tiebrakingMethod == TIEBRAKING_METHOD::RANDOM) {
-                        if (rand() % 2 == 0)
+                        if (rand() % 2 == 0) {
+                            statistics.Seeded(SEEDING_RULE_TIEBREAK, false);
                             continue;
+                        }
                     } else {//lowest recieved_from ASN wins
-                        if (currentRecievedFromASN < recieved_from_asn)
+                        if (currentRecievedFromASN < recieved_from_asn) {
+                            statistics.Seeded(SEEDING_RULE_TIEBREAK, false);
                             continue;
+                        }
                     }
+
+                    statistics.Seeded(SEEDING_RULE_TIEBREAK, true);
+                } else {
+                    statistics.Seeded(currentRelationship != relationship ? SEEDING_RULE_RELATIONSHIP : SEEDING_RULE_PATH_LENGTH, true);
                 }
+            } else {
+                statistics.Seeded(SEEDING_RULE_TIMESTAMP, true);
             }
+        } else {
+            statistics.Seeded(SEEDING_RULE_NOTHING_HELD, true);
         }
 
         //accept the announcement
@@ -336,59 +898,326 @@ void Graph::SeedPath(const std::vector<ASN>& asPath, size_t staticDataIndex, con
 }
 
 void Graph::Propagate() {
+    routeIndex.reset();
+    propagationTimings = PropagationTimings();
+    propagationProfile = PropagationProfile();
+    ResetPropagationStatistics();
+
+    // Out of core ribs keep going one tile at a time, even when placed
+    if (numaPlacement && !localRibs.IsFileBacked()) {
+        PropagateShards();
+        return;
+    }
+
+    // One tile at a time, so out of core ribs only need one tile in memory. In memory ribs are a single tile
+    const size_t tileLength = localRibs.GetTileLength();
+    for (size_t tileBegin = 0; tileBegin < GetNumPrefixes(); tileBegin += tileLength) {
+        BGPX_TRACE_SCOPE_ARG("tile", "propagate", "prefix_begin", tileBegin);
+        localRibs.PrefetchTile(tileBegin + tileLength);
+
+        Propagate(tileBegin, std::min(tileBegin + tileLength, GetNumPrefixes()));
+
+        localRibs.ReleaseTile(tileBegin);
+    }
+}
+
+void Graph::PropagateShards() {
+    const size_t numThreads = GetNumThreads();
+    shardPeerStaging.resize(numThreads);
+    shardTimings.assign(numThreads, PropagationTimings());
+    shardProfiles.assign(numThreads, PropagationProfile());
+    shardStatistics.assign(numThreads, PropagationStatisticsProfile());
+
+    threadPool->ParallelFor(0, numThreads, [&](size_t threadIndex, size_t, size_t) {
+        BGPX_TRACE_SCOPE_ARG("shard", "propagate", "shard", threadIndex);
+        uint32_t shardBegin, shardEnd;
+        localRibs.GetShardPrefixRange(threadIndex, shardBegin, shardEnd);
+
+        const size_t tileLength = localRibs.GetTileLength();
+        for (size_t tileBegin = shardBegin; tileBegin < shardEnd; tileBegin += tileLength) {
+            BGPX_TRACE_SCOPE_ARG("tile", "propagate", "prefix_begin", tileBegin);
+            PropagateRange(tileBegin, std::min(tileBegin + tileLength, (size_t) shardEnd), nullptr,
+                shardPeerStaging[threadIndex], PEER_STAGING_BUDGET_BYTES / numThreads, shardTimings[threadIndex], shardStatistics[threadIndex],
+                profiling ? &shardProfiles[threadIndex] : nullptr, profiling ? threadCounters[threadIndex].get() : nullptr);
+        }
+    });
+
+    for (auto &timings : shardTimings)
+        propagationTimings.Add(timings);
+    for (auto &profile : shardProfiles)
+        propagationProfile.Add(profile);
+    for (auto &statistics : shardStatistics)
+        statisticsProfile.Add(statistics);
+}
+
+void Graph::Propagate(const uint32_t prefixBegin, const uint32_t prefixEnd) {
+    routeIndex.reset();
+    PropagateRange(prefixBegin, prefixEnd, threadPool.get(), peerStaging, PEER_STAGING_BUDGET_BYTES, propagationTimings, statisticsProfile,
+        profiling ? &propagationProfile : nullptr, nullptr);
+}
+
+PerfCounterValues Graph::ReadCounters(const PerfCounters *counters) const {
+    if (counters != nullptr)
+        return counters->Read();
+
+    PerfCounterValues total;
+    for (auto &threadCounter : threadCounters)
+        total.Add(threadCounter->Read());
+
+    return total;
+}
+
+void Graph::ResetPropagationStatistics() {
+    // The seeding statistics belong to the seeding before this propagation, they stay
+    PropagationStatistics seeding = statisticsProfile.seeding;
+    statisticsProfile = PropagationStatisticsProfile();
+    statisticsProfile.seeding = seeding;
+}
+
+/**
+ * Statistics counted so far by the threads propagating: every thread of the pool, or only the calling thread without one
+ */
+static inline PropagationStatistics ReadStatistics(const ThreadPool *pool) {
+    return pool != nullptr ? DefaultStatistics::ReadAllThreads() : DefaultStatistics::ReadThread();
+}
+
+void Graph::PropagateRange(const uint32_t prefixBegin, const uint32_t prefixEnd, ThreadPool *pool, std::vector<AnnouncementCachedData> &staging, const size_t stagingBudgetBytes, PropagationTimings &timings,
+        PropagationStatisticsProfile &statistics, PropagationProfile *profile, const PerfCounters *counters) {
+    timings.upRankMilliseconds.resize(rankToIDs.size(), 0);
+    timings.downRankMilliseconds.resize(rankToIDs.size(), 0);
+    if (DefaultStatistics::enabled) {
+        statistics.upRanks.resize(rankToIDs.size());
+        statistics.downRanks.resize(rankToIDs.size());
+    }
+    if (profile != nullptr) {
+        profile->upRanks.resize(rankToIDs.size());
+        profile->downRanks.resize(rankToIDs.size());
+    }
+
+    const uint64_t rangeLength = prefixEnd - prefixBegin;
+    Stopwatch phaseStopwatch, rankStopwatch;
+    PerfCounterValues phaseStart, rankStart;
+    PropagationStatistics phaseStatistics, rankStatistics;
+    uint64_t cellsReplaced;
+
     // ************ Propagate Up ************//
+    BGPX_TRACE_BEGIN(upSpan, "propagate_up", "propagate");
+    if (profile != nullptr)
+        phaseStart = ReadCounters(counters);
+    if (DefaultStatistics::enabled)
+        phaseStatistics = ReadStatistics(pool);
 
     // start at the second rank because the first has no customers
     for (size_t i = 1; i < rankToIDs.size(); i++) {
+        BGPX_TRACE_SCOPE_ARG("up_rank", "propagate", "rank", i);
+        rankStopwatch.Restart();
+        if (profile != nullptr)
+            rankStart = ReadCounters(counters);
+        if (DefaultStatistics::enabled)
+            rankStatistics = ReadStatistics(pool);
+        cellsReplaced = 0;
+
         for (auto& providerID : rankToIDs[i]) {
             for (auto& customerID : asIDToCustomerIDs[providerID]) {
 
-                idToImportPolicy[providerID]->ProcessCustomerAnnouncements(*this, customerID);
+                cellsReplaced += idToImportPolicy[providerID]->ProcessCustomerAnnouncements(*this, customerID, prefixBegin, prefixEnd);
             }
         }
-    }
 
-    for (size_t i = 0; i < rankToIDs.size(); i++) {
-        for (auto& asID : rankToIDs[i]) {
-            for (auto& peerID : asIDToPeerIDs[asID]) {
-                idToImportPolicy[asID]->ProcessPeerAnnouncements(*this, peerID);
-             }
+        timings.upRankMilliseconds[i] += rankStopwatch.ElapsedMilliseconds();
+        if (DefaultStatistics::enabled)
+            statistics.upRanks[i].Add(ReadStatistics(pool).Since(rankStatistics));
+
+        if (profile != nullptr) {
+            PropagationProfileEntry &entry = profile->upRanks[i];
+            entry.counters.Add(ReadCounters(counters).Since(rankStart));
+            entry.cellsReplaced += cellsReplaced;
+
+            // Imports skipped by provider preferences compare nothing
+            uint64_t cellsCompared = 0;
+            for (auto& providerID : rankToIDs[i]) {
+                for (auto& customerID : asIDToCustomerIDs[providerID]) {
+                    if (IsPrefferedProvider(idToASN[providerID], customerID.asn))
+                        cellsCompared += rangeLength;
+                }
+            }
+
+            entry.cellsCompared += cellsCompared;
+            profile->up.cellsCompared += cellsCompared;
+            profile->up.cellsReplaced += cellsReplaced;
         }
     }
 
+    timings.upMilliseconds += phaseStopwatch.ElapsedMilliseconds();
+    if (profile != nullptr)
+        profile->up.counters.Add(ReadCounters(counters).Since(phaseStart));
+    if (DefaultStatistics::enabled)
+        statistics.up.Add(ReadStatistics(pool).Since(phaseStatistics));
+    BGPX_TRACE_END(upSpan);
+
+    // ************ Propagate Across ************//
+    BGPX_TRACE_BEGIN(peersSpan, "propagate_peers", "propagate");
+    phaseStopwatch.Restart();
+    if (profile != nullptr)
+        phaseStart = ReadCounters(counters);
+    if (DefaultStatistics::enabled)
+        phaseStatistics = ReadStatistics(pool);
+
+    cellsReplaced = PropagatePeers(prefixBegin, prefixEnd, pool, staging, stagingBudgetBytes);
+
+    timings.peersMilliseconds += phaseStopwatch.ElapsedMilliseconds();
+    if (profile != nullptr) {
+        profile->peers.counters.Add(ReadCounters(counters).Since(phaseStart));
+        profile->peers.cellsReplaced += cellsReplaced;
+        for (ASN_ID asID = 0; asID < GetNumASes(); asID++)
+            profile->peers.cellsCompared += asIDToPeerIDs[asID].size() * rangeLength;
+    }
+    if (DefaultStatistics::enabled)
+        statistics.peers.Add(ReadStatistics(pool).Since(phaseStatistics));
+    BGPX_TRACE_END(peersSpan);
 
     // ************ Propagate Down ************//
+    BGPX_TRACE_BEGIN(downSpan, "propagate_down", "propagate");
+    phaseStopwatch.Restart();
+    if (profile != nullptr)
+        phaseStart = ReadCounters(counters);
+    if (DefaultStatistics::enabled)
+        phaseStatistics = ReadStatistics(pool);
+
     //Customer looks up to the provider and looks at its data, that is why the - 2 is there
     for (int i = rankToIDs.size() - 2; i >= 0; i--) {
+        BGPX_TRACE_SCOPE_ARG("down_rank", "propagate", "rank", i);
+        rankStopwatch.Restart();
+        if (profile != nullptr)
+            rankStart = ReadCounters(counters);
+        if (DefaultStatistics::enabled)
+            rankStatistics = ReadStatistics(pool);
+        cellsReplaced = 0;
+
         for (auto& customerID : rankToIDs[i]) {
             for (auto& providerID : asIDToProviderIDs[customerID]) {
-                idToImportPolicy[customerID]->ProcessProviderAnnouncements(*this, providerID);
+                cellsReplaced += idToImportPolicy[customerID]->ProcessProviderAnnouncements(*this, providerID, prefixBegin, prefixEnd);
             }
         }
+
+        timings.downRankMilliseconds[i] += rankStopwatch.ElapsedMilliseconds();
+        if (DefaultStatistics::enabled)
+            statistics.downRanks[i].Add(ReadStatistics(pool).Since(rankStatistics));
+
+        if (profile != nullptr) {
+            PropagationProfileEntry &entry = profile->downRanks[i];
+            entry.counters.Add(ReadCounters(counters).Since(rankStart));
+            entry.cellsReplaced += cellsReplaced;
+            uint64_t cellsCompared = 0;
+            for (auto& customerID : rankToIDs[i])
+                cellsCompared += asIDToProviderIDs[customerID].size() * rangeLength;
+
+            entry.cellsCompared += cellsCompared;
+            profile->down.cellsCompared += cellsCompared;
+            profile->down.cellsReplaced += cellsReplaced;
+        }
     }
+
+    timings.downMilliseconds += phaseStopwatch.ElapsedMilliseconds();
+    if (profile != nullptr)
+        profile->down.counters.Add(ReadCounters(counters).Since(phaseStart));
+    if (DefaultStatistics::enabled)
+        statistics.down.Add(ReadStatistics(pool).Since(phaseStatistics));
+    BGPX_TRACE_END(downSpan);
+}
+
+uint64_t Graph::PropagatePeers(const uint32_t prefixBegin, const uint32_t prefixEnd, ThreadPool *pool, std::vector<AnnouncementCachedData> &stagingBuffer, const size_t stagingBudgetBytes) {
+    const size_t numASes = GetNumASes();
+    const size_t numPrefixes = prefixEnd - prefixBegin;
+    if (numASes == 0 || prefixBegin >= prefixEnd)
+        return 0;
+
+    // Replacements counted per thread, added up at the end
+    std::vector<uint64_t> threadReplaced(pool != nullptr ? pool->GetNumThreads() : 1, 0);
+
+    size_t chunkLength = stagingBudgetBytes / (numASes * sizeof(AnnouncementCachedData));
+    if (chunkLength == 0)
+        chunkLength = 1;
+    if (chunkLength > numPrefixes)
+        chunkLength = numPrefixes;
+
+    if (stagingBuffer.size() < numASes * chunkLength)
+        stagingBuffer.resize(numASes * chunkLength);
+
+    for (size_t chunkStart = prefixBegin; chunkStart < prefixEnd; chunkStart += chunkLength) {
+        const uint32_t chunkBegin = chunkStart;
+        const uint32_t chunkEnd = std::min(chunkStart + chunkLength, (size_t) prefixEnd);
+
+        // Stage: only reads the local ribs, each AS writes to its own slice of the staging buffer
+        auto stage = [&](size_t threadIndex, size_t begin, size_t end) {
+            BGPX_TRACE_SCOPE_ARG("peer_stage", "propagate", "prefix_begin", chunkBegin);
+            for (ASN_ID asID = begin; asID < end; asID++) {
+                if (asIDToPeerIDs[asID].empty())
+                    continue;
+
+                AnnouncementCachedData *staging = &stagingBuffer[asID * chunkLength];
+                for (uint32_t prefixBlockID = chunkBegin; prefixBlockID < chunkEnd; prefixBlockID++)
+                    staging[prefixBlockID - chunkBegin] = GetCachedData_ReadOnly(asID, prefixBlockID);
+
+                for (auto& peer : asIDToPeerIDs[asID])
+                    threadReplaced[threadIndex] += idToImportPolicy[asID]->StagePeerAnnouncements(*this, peer, staging, chunkBegin, chunkEnd);
+            }
+        };
+
+        // Commit: each AS only writes to its own local rib
+        auto commit = [&](size_t, size_t begin, size_t end) {
+            BGPX_TRACE_SCOPE_ARG("peer_commit", "propagate", "prefix_begin", chunkBegin);
+            for (ASN_ID asID = begin; asID < end; asID++) {
+                if (asIDToPeerIDs[asID].empty())
+                    continue;
+
+                const AnnouncementCachedData *staging = &stagingBuffer[asID * chunkLength];
+                for (uint32_t prefixBlockID = chunkBegin; prefixBlockID < chunkEnd; prefixBlockID++)
+                    GetCachedData(asID, prefixBlockID) = staging[prefixBlockID - chunkBegin];
+            }
+        };
+
+        if (pool != nullptr) {
+            pool->ParallelFor(0, numASes, stage);
+            pool->ParallelFor(0, numASes, commit);
+        } else {
+            stage(0, 0, numASes);
+            commit(0, 0, numASes);
+        }
+    }
+
+    uint64_t replaced = 0;
+    for (auto threadCount : threadReplaced)
+        replaced += threadCount;
+
+    return replaced;
 }
 
 void Graph::Traceback(std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const {
+    Traceback(*this, as_path, startingASN, prefixBlockID);
+}
+
+template <typename RibView>
+void Graph::Traceback(const RibView &view, std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const {
     as_path.clear();
 
-    auto starting_search = asnToID.find(startingASN);
-    if (starting_search == asnToID.end())
+    ASN_ID asnID;
+    if (!asnTable.FindID(startingASN, asnID))
         return;
 
-    ASN_ID asnID = starting_search->second;
     size_t path_length = 1;
     as_path.push_back(startingASN);
 
     // If the path length is greater than 99, there is a cycle or soem other kind of problem. Path lengths should not be this long
     while (path_length < 99) {
-        const AnnouncementCachedData& ann = GetCachedData_ReadOnly(asnID, prefixBlockID);
+        const AnnouncementCachedData& ann = view.GetCachedData_ReadOnly(asnID, prefixBlockID);
 
         // origin recieves from itself
         if (ann.GetRecievedFromID() == asnID) {
             if (ann.GetPathLength() == 2) {
                 // this means that the origin was not in the graph (stub removal)
                 // but we can get the ASN from the static info since it the origin
-                as_path.push_back(GetStaticData_ReadOnly(ann.GetStaticDataIndex()).originASN);
+                as_path.push_back(view.GetStaticData_ReadOnly(ann.GetStaticDataIndex()).originASN);
                 path_length++;
             }
             break;
@@ -400,84 +1229,432 @@ void Graph::Traceback(std::vector<ASN> &as_path, const ASN startingASN, const ui
     }
 }
 
+void Graph::RunScenario(RibOverlay &overlay, const std::vector<ScenarioAnnouncement> &announcements, const SeedingConfiguration &config) const {
+    std::set<uint32_t> affectedBlocks;
+    for (const ScenarioAnnouncement &announcement : announcements)
+        affectedBlocks.insert(announcement.prefix.block_id);
+
+    // Bring every affected column back to its seeded state.
+    // A non-seeded announcement recieved from the AS itself is a provider holding its stub's origin announcement (stub removal), which is also seeding
+    for (uint32_t prefixBlockID : affectedBlocks) {
+        std::vector<AnnouncementCachedData> &column = overlay.GetColumn(prefixBlockID);
+        for (ASN_ID id = 0; id < column.size(); id++) {
+            AnnouncementCachedData &ann = column[id];
+            if (!ann.isSeeded() && ann.GetRecievedFromID() != id)
+                ann.SetDefaultState();
+        }
+    }
+
+    for (const ScenarioAnnouncement &announcement : announcements) {
+        uint32_t staticDataIndex = overlay.AddStaticData();
+        SeedPath(overlay, announcement.asPath, staticDataIndex, announcement.prefix, announcement.prefixString, announcement.timestamp, config);
+    }
+
+    std::vector<AnnouncementCachedData> peerStagingColumn(GetNumASes());
+    for (uint32_t prefixBlockID : affectedBlocks) {
+        const uint32_t prefixEnd = prefixBlockID + 1;
+
+        for (size_t i = 1; i < rankToIDs.size(); i++)
+            for (auto& providerID : rankToIDs[i])
+                for (auto& customerID : asIDToCustomerIDs[providerID])
+                    idToImportPolicy[providerID]->ProcessCustomerAnnouncements(overlay, customerID, prefixBlockID, prefixEnd);
+
+        // Same snapshot semantics as PropagatePeers, with a single prefix per AS in the staging buffer
+        for (ASN_ID asID = 0; asID < GetNumASes(); asID++) {
+            if (asIDToPeerIDs[asID].empty())
+                continue;
+
+            peerStagingColumn[asID] = overlay.GetCachedData_ReadOnly(asID, prefixBlockID);
+            for (auto& peer : asIDToPeerIDs[asID])
+                idToImportPolicy[asID]->StagePeerAnnouncements(overlay, peer, &peerStagingColumn[asID], prefixBlockID, prefixEnd);
+        }
+
+        for (ASN_ID asID = 0; asID < GetNumASes(); asID++)
+            if (!asIDToPeerIDs[asID].empty())
+                overlay.GetCachedData(asID, prefixBlockID) = peerStagingColumn[asID];
+
+        for (int i = rankToIDs.size() - 2; i >= 0; i--)
+            for (auto& customerID : rankToIDs[i])
+                for (auto& providerID : asIDToProviderIDs[customerID])
+                    idToImportPolicy[customerID]->ProcessProviderAnnouncements(overlay, providerID, prefixBlockID, prefixEnd);
+    }
+}
+
+template void Graph::Traceback<RibOverlay>(const RibOverlay &view, std::vector<ASN> &as_path, const ASN startingASN, const uint32_t prefixBlockID) const;
+
+// ************************ QUERIES ************************ //
+
+void Graph::BuildRouteIndex() {
+    std::vector<std::pair<ASN, ASN_ID>> removedStubs;
+    for (auto &stub : asnTable.GetStubs())
+        if (!ContainsASN(stub.first))
+            removedStubs.push_back(stub);
+
+    // The old index goes first, no need for both at once
+    routeIndex.reset();
+    routeIndex.reset(new RouteIndex(*this, *threadPool, removedStubs));
+}
+
+std::vector<uint32_t> Graph::FindPrefixBlocks(const std::string &prefixString, const size_t lane) const {
+    std::vector<uint32_t> prefixBlockIDs;
+    if (routeIndex == nullptr)
+        return prefixBlockIDs;
+
+    for (uint32_t prefixBlockID : routeIndex->GetPrefixBlocks(prefixString))
+        if (prefixBlockID % numLanes == lane)
+            prefixBlockIDs.push_back(prefixBlockID);
+
+    return prefixBlockIDs;
+}
+
+bool Graph::QueryRoute(const ASN asn, const uint32_t prefixBlockID, QueriedRoute &route) const {
+    route = QueriedRoute();
+    if (prefixBlockID >= GetNumPrefixes())
+        return false;
+
+    // A removed stub has the route of its provider
+    const ASNTable::Entry entry = asnTable.Find(asn);
+    const bool removedStub = entry.id == ASNTable::NONE;
+    const ASN_ID id = removedStub ? entry.stubProviderID : entry.id;
+    if (id == ASNTable::NONE)
+        return false;
+
+    const AnnouncementCachedData &ann = GetCachedData_ReadOnly(id, prefixBlockID);
+    if (ann.isDefaultState())
+        return false;
+
+    const AnnouncementStaticData &staticData = GetStaticData_ReadOnly(ann.GetStaticDataIndex());
+    route.prefixString = staticData.prefixString;
+    route.originASN = staticData.originASN;
+    route.timestamp = staticData.timestamp;
+
+    Traceback(route.asPath, idToASN[id], prefixBlockID);
+    if (removedStub) {
+        // Same as the results: the provider's path ends at the stub when the stub is the origin
+        if (route.asPath.back() == asn)
+            route.asPath.assign(1, asn);
+        else
+            route.asPath.insert(route.asPath.begin(), asn);
+    }
+
+    if (route.asPath.size() > 1)
+        route.nextHopASN = route.asPath[1];
+
+    return true;
+}
+
+bool Graph::QueryASesByOrigin(const uint32_t prefixBlockID, const ASN originASN, std::vector<ASN> &asns) const {
+    asns.clear();
+    if (routeIndex == nullptr)
+        return false;
+
+    std::vector<ASN_ID> ids;
+    routeIndex->GetOriginMembers(prefixBlockID, originASN, ids);
+    for (ASN_ID id : ids) {
+        asns.push_back(idToASN[id]);
+
+        // Removed stubs route via whatever origin their provider does (themselves included, when they originate the prefix)
+        const ASN *stubsBegin, *stubsEnd;
+        routeIndex->GetRemovedStubs(id, stubsBegin, stubsEnd);
+        asns.insert(asns.end(), stubsBegin, stubsEnd);
+    }
+
+    std::sort(asns.begin(), asns.end());
+    return true;
+}
+
+bool Graph::QueryASesByNextHop(const uint32_t prefixBlockID, const ASN nextHopASN, std::vector<ASN> &asns) const {
+    asns.clear();
+    if (routeIndex == nullptr)
+        return false;
+
+    ASN_ID nextHopID;
+    if (asnTable.FindID(nextHopASN, nextHopID)) {
+        const ASN_ID *membersBegin, *membersEnd;
+        routeIndex->GetNextHopMembers(prefixBlockID, nextHopID, membersBegin, membersEnd);
+        for (const ASN_ID *member = membersBegin; member != membersEnd; member++)
+            asns.push_back(idToASN[*member]);
+
+        // Removed stubs of the next hop use it too, except for the one originating the prefix (if any)
+        const ASN *stubsBegin, *stubsEnd;
+        routeIndex->GetRemovedStubs(nextHopID, stubsBegin, stubsEnd);
+        if (stubsBegin != stubsEnd && prefixBlockID < GetNumPrefixes() && !GetCachedData_ReadOnly(nextHopID, prefixBlockID).isDefaultState()) {
+            std::vector<ASN> as_path;
+            Traceback(as_path, nextHopASN, prefixBlockID);
+
+            for (const ASN *stub = stubsBegin; stub != stubsEnd; stub++)
+                if (*stub != as_path.back())
+                    asns.push_back(*stub);
+        }
+    } else {
+        // A removed stub is only the next hop of the providers it originates the prefix to
+        std::vector<ASN_ID> ids;
+        routeIndex->GetStubNextHopMembers(prefixBlockID, nextHopASN, ids);
+        for (ASN_ID id : ids)
+            asns.push_back(idToASN[id]);
+    }
+
+    std::sort(asns.begin(), asns.end());
+    return true;
+}
+
+std::vector<std::pair<std::string, size_t>> Graph::GetMemoryUsage() const {
+    std::vector<std::pair<std::string, size_t>> usage;
+
+    usage.push_back( { "local_ribs", localRibs.GetArenaSize() * sizeof(AnnouncementCachedData) } );
+
+    size_t staticDataBytes = announcementStaticData.capacity() * sizeof(AnnouncementStaticData);
+    for (auto &staticData : announcementStaticData)
+        staticDataBytes += staticData.prefixString.capacity();
+    usage.push_back( { "announcement_static_data", staticDataBytes } );
+
+    usage.push_back( { "seeded_paths", seededPaths.capacity() * sizeof(ASN) + freeStaticDataIndices.capacity() * sizeof(uint32_t) } );
+
+    size_t relationshipBytes = 0;
+    for (auto neighbors : { &asIDToProviderIDs, &asIDToPeerIDs, &asIDToCustomerIDs }) {
+        relationshipBytes += neighbors->capacity() * sizeof(std::vector<ASN_ASNID_PAIR>);
+        for (auto &list : *neighbors)
+            relationshipBytes += list.capacity() * sizeof(ASN_ASNID_PAIR);
+    }
+    usage.push_back( { "relationships", relationshipBytes } );
+
+    size_t rankBytes = rankToIDs.capacity() * sizeof(std::vector<ASN_ID>);
+    for (auto &rank : rankToIDs)
+        rankBytes += rank.capacity() * sizeof(ASN_ID);
+    usage.push_back( { "ranks", rankBytes } );
+
+    // Hash tables: a node per entry (value + next pointer) and a pointer per bucket
+    usage.push_back( { "asn_lookup", idToASN.capacity() * sizeof(ASN) + asnTable.GetMemoryUsage() } );
+
+    // Tree nodes: the value plus three pointers and the color
+    usage.push_back( { "relationship_priorities", relationshipPriority.size() * (sizeof(std::pair<std::pair<ASN, ASN>, uint8_t>) + 4 * sizeof(void*)) } );
+
+    usage.push_back( { "import_policies", idToImportPolicy.capacity() * sizeof(std::unique_ptr<PropagationImportPolicy>) + idToImportPolicy.size() * sizeof(BGPPolicy) } );
+
+    size_t stagingBytes = peerStaging.capacity() * sizeof(AnnouncementCachedData);
+    for (auto &staging : shardPeerStaging)
+        stagingBytes += staging.capacity() * sizeof(AnnouncementCachedData);
+    usage.push_back( { "peer_staging", stagingBytes } );
+
+    usage.push_back( { "route_index", routeIndex == nullptr ? 0 : routeIndex->GetMemoryUsage() } );
+
+    return usage;
+}
+
 // ************************ FILE I/O ************************ //
  
 //TODO: Check the provider local rib after seeding for stub removal. See if the stub's ASN is the recieved_from_asn when the stub is the origin. Add a check for this when generating the localribs
-void Graph::GenerateTracebackResultsCSV(const std::string& resultsFilePath, std::vector<ASN> localRibsToDump) {
-    //Create the file, delete if it exists already (std::fstream::trunc)
-    FILE *f = fopen(resultsFilePath.c_str(), "w");
-    FileBuffer fileBuffer(f);
-
-    if (localRibsToDump.empty()) {
-        for (const auto& kv : asnToID)
-            localRibsToDump.push_back(kv.first);
-        if (stubRemoval) {
-            for (const auto& kv : stubASNToProviderID)
-                localRibsToDump.push_back(kv.first);
+bool Graph::GenerateTracebackResultsCSV(const std::string& resultsFilePath, std::vector<ASN> localRibsToDump, size_t &bytesWritten, const ResultsFilter &filter) {
+    std::vector<size_t> fileBytesWritten;
+    bool ok = GenerateTracebackResultsCSV(std::vector<std::string>(1, resultsFilePath), localRibsToDump, fileBytesWritten, filter);
+    bytesWritten = fileBytesWritten[0];
+    return ok;
+}
+
+bool Graph::GenerateTracebackResultsCSV(const std::vector<std::string>& resultsFilePaths, std::vector<ASN> localRibsToDump, std::vector<size_t> &bytesWritten,
+        const ResultsFilter &filter) {
+    bytesWritten.assign(resultsFilePaths.size(), 0);
+
+    //Create the files, delete if they exist already (std::fstream::trunc)
+    std::vector<FILE*> files;
+    std::vector<std::unique_ptr<FileBuffer>> fileBuffers;
+    for (auto &resultsFilePath : resultsFilePaths) {
+        FILE *file = fopen(resultsFilePath.c_str(), "w");
+        if (file == nullptr) {
+            std::cout << "Could not open the results file for writing: " << resultsFilePath << std::endl;
+            for (FILE *opened : files)
+                fclose(opened);
+            return false;
         }
+
+        files.push_back(file);
+        fileBuffers.push_back(std::unique_ptr<FileBuffer>(new FileBuffer(file)));
     }
 
-    //First, dump the static info at the top of the file
-    fileBuffer.write("prefix\torigin\ttimestamp\tas_path\n");
+    //First, dump the static info at the top of the files
+    for (auto &fileBuffer : fileBuffers)
+        fileBuffer->write("prefix\torigin\ttimestamp\tas_path\n");
     
     //Only dump the RIB of ASes we care about.
-    std::vector<ASN> as_path;
-    for (auto asn : localRibsToDump) {
-        // Determine the ID and ASN of the current AS.
-        // Gets funky if we are interested in a stub, where we trace from the provider and then append to the path
-        ASN_ID id;
-        int64_t stubASN = -1;
+    //Resolve them first, then go through the local ribs tile by tile (the whole rib is one tile unless the ribs are out of core)
+    std::vector<ASN_ID> dumpIDs;
+    std::vector<int64_t> dumpStubASNs;
+    ResolveDumpIDs(localRibsToDump, dumpIDs, dumpStubASNs);
+
+    const size_t tileLength = localRibs.GetTileLength();
+    for (size_t tileBegin = 0; tileBegin < GetNumPrefixes(); tileBegin += tileLength) {
+        BGPX_TRACE_SCOPE_ARG("write_tile", "write", "prefix_begin", tileBegin);
+        const uint32_t tileEnd = std::min(tileBegin + tileLength, GetNumPrefixes());
+        localRibs.PrefetchTile(tileBegin + tileLength);
+
+        WriteTracebackResults(*this, tileBegin, tileEnd, dumpIDs, dumpStubASNs, filter, fileBuffers);
+
+        localRibs.ReleaseTile(tileBegin);
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < fileBuffers.size(); i++) {
+        fileBuffers[i]->flush();
+        bytesWritten[i] = fileBuffers[i]->getBytesWritten();
+        if (fclose(files[i]) != 0 || fileBuffers[i]->hasFailed()) {
+            std::cout << "Could not write the results file: " << resultsFilePaths[i] << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+std::vector<size_t> Graph::AppendTracebackResults(const PropagatedBlocks &blocks, const std::vector<FILE*> &files, const std::vector<ASN> &localRibsToDump, const bool writeHeader,
+        const ResultsFilter &filter) const {
+    BGPX_TRACE_SCOPE("write_blocks", "write");
+    std::vector<std::unique_ptr<FileBuffer>> fileBuffers;
+    for (FILE *file : files) {
+        fileBuffers.push_back(std::unique_ptr<FileBuffer>(new FileBuffer(file)));
+        if (writeHeader)
+            fileBuffers.back()->write("prefix\torigin\ttimestamp\tas_path\n");
+    }
+
+    std::vector<ASN_ID> dumpIDs;
+    std::vector<int64_t> dumpStubASNs;
+    ResolveDumpIDs(localRibsToDump, dumpIDs, dumpStubASNs);
 
-        auto id_search = asnToID.find(asn);
-        if (id_search == asnToID.end()) {
-            auto stub_search = stubASNToProviderID.find(asn);
-            if (stub_search == stubASNToProviderID.end())
+    WriteTracebackResults(blocks, 0, blocks.GetNumPrefixes(), dumpIDs, dumpStubASNs, filter, fileBuffers);
+
+    std::vector<size_t> bytesWritten;
+    for (auto &fileBuffer : fileBuffers) {
+        fileBuffer->flush();
+        bytesWritten.push_back(fileBuffer->getBytesWritten());
+    }
+
+    return bytesWritten;
+}
+
+void Graph::ResolveDumpIDs(const std::vector<ASN> &localRibsToDump, std::vector<ASN_ID> &dumpIDs, std::vector<int64_t> &dumpStubASNs) const {
+    std::vector<ASN> asns = localRibsToDump;
+    if (asns.empty()) {
+        asns = idToASN;
+        if (stubRemoval) {
+            for (const auto& stub : asnTable.GetStubs())
+                asns.push_back(stub.first);
+        }
+    }
+
+    dumpIDs.clear();
+    dumpStubASNs.clear();
+    for (auto asn : asns) {
+        // Determine the ID of the current AS.
+        // Gets funky if we are interested in a stub, where we trace from the provider and then append to the path
+        const ASNTable::Entry entry = asnTable.Find(asn);
+        if (entry.id == ASNTable::NONE) {
+            if (entry.stubProviderID == ASNTable::NONE)
                 continue;
 
-            id = stub_search->second;
-            asn = idToASN.at(id);
-            stubASN = stub_search->first;
+            dumpIDs.push_back(entry.stubProviderID);
+            dumpStubASNs.push_back(asn);
         } else {
-            id = id_search->second;
+            dumpIDs.push_back(entry.id);
+            dumpStubASNs.push_back(-1);
         }
+    }
+}
 
-        for (uint32_t prefixBlockID = 0; prefixBlockID < GetNumPrefixes(); prefixBlockID++) {
-            const AnnouncementCachedData &ann = GetCachedData(id, prefixBlockID);
-            
-            //Do nothing if there is no actual announcement at the prefix
-            if (ann.isDefaultState())
-                continue;
+template <typename RibView>
+void Graph::WriteTracebackResults(const RibView &view, const uint32_t prefixBegin, const uint32_t prefixEnd, const std::vector<ASN_ID> &dumpIDs,
+        const std::vector<int64_t> &dumpStubASNs, const ResultsFilter &filter, std::vector<std::unique_ptr<FileBuffer>> &fileBuffers) const {
+    // Prefixes and origins are decided once per announcement, every row then only looks up its announcement
+    std::vector<uint8_t> announcementMatches;
+    if (filter.FiltersAnnouncements()) {
+        announcementMatches.resize(view.GetNumStaticData());
+        for (size_t i = 0; i < announcementMatches.size(); i++) {
+            const AnnouncementStaticData &staticData = view.GetStaticData_ReadOnly(i);
+            announcementMatches[i] = filter.MatchesAnnouncement(staticData.prefixString, staticData.originASN);
+        }
+    }
 
-            as_path.clear();
-            Traceback(as_path, asn, prefixBlockID);
+    // The local rib of an AS holds its prefix blocks side by side: a few blocks at a time (one forest each) read a cache line per AS rather than one per AS and block
+    std::vector<TracebackForest> forests;
+    forests.reserve(TRACEBACK_BLOCKS_PER_PASS);
+    for (uint32_t i = 0; i < TRACEBACK_BLOCKS_PER_PASS; i++)
+        forests.emplace_back(idToASN);
+
+    std::vector<ASN> as_path;
+    std::string fallbackText;
 
-            //***** Build String
-            AnnouncementStaticData& staticData = announcementStaticData[ann.GetStaticDataIndex()];
+    for (uint32_t passBegin = prefixBegin; passBegin < prefixEnd; passBegin += TRACEBACK_BLOCKS_PER_PASS) {
+        const uint32_t passEnd = std::min(passBegin + TRACEBACK_BLOCKS_PER_PASS, prefixEnd);
+        for (auto &forest : forests)
+            forest.Reset();
 
-            fileBuffer.write("%s\t%i\t%lli\t{", staticData.prefixString.c_str(), staticData.originASN, staticData.timestamp);
+        for (size_t dumpIndex = 0; dumpIndex < dumpIDs.size(); dumpIndex++) {
+            const ASN_ID id = dumpIDs[dumpIndex];
+            const int64_t stubASN = dumpStubASNs[dumpIndex];
 
-            if (stubASN >= 0) {
-                // If the AS path has the stub as the origin and we are dumping the local rib of the stub
-                // Then the path will have the provider and the stub, which is not correct
-                if (as_path[as_path.size() - 1] == stubASN) {
-                    fileBuffer.write("%d", stubASN);
-                    as_path.clear();
+            for (uint32_t prefixBlockID = passBegin; prefixBlockID < passEnd; prefixBlockID++) {
+                const AnnouncementCachedData &ann = view.GetCachedData_ReadOnly(id, prefixBlockID);
+
+                //Do nothing if there is no actual announcement at the prefix
+                if (ann.isDefaultState())
+                    continue;
+
+                // Seeded announcements are never replaced, and only seeding receives from the AS itself (a removed stub origin on its provider,
+                //  which is not marked as seeded), so these cells hold the same rows as right after seeding. Removed stubs go with their provider
+                if (filter.propagatedOnly && (ann.isSeeded() || ann.GetRecievedFromID() == id))
+                    continue;
+
+                if (!announcementMatches.empty() && !announcementMatches[ann.GetStaticDataIndex()])
+                    continue;
+
+                if (stubASN < 0 && !filter.MatchesRelationship(ann.GetRelationship()))
+                    continue;
+
+                FileBuffer &fileBuffer = *fileBuffers[prefixBlockID % fileBuffers.size()];
+                TracebackForest &forest = forests[prefixBlockID - passBegin];
+
+                const char *pathText;
+                size_t pathTextLength;
+                ASN pathOrigin;
+                if (forest.Resolve(view, id, prefixBlockID)) {
+                    pathText = forest.GetPathText(id);
+                    pathTextLength = forest.GetPathTextLength(id);
+                    pathOrigin = forest.GetPathOrigin(id);
                 } else {
+                    Traceback(view, as_path, idToASN.at(id), prefixBlockID);
+
+                    fallbackText.clear();
+                    for (size_t j = 0; j < as_path.size(); j++) {
+                        if (j > 0)
+                            fallbackText.push_back(',');
+                        fallbackText.append(std::to_string((int) as_path[j]));
+                    }
+                    pathText = fallbackText.data();
+                    pathTextLength = fallbackText.size();
+                    pathOrigin = as_path.back();
+                }
+
+                //***** Build String
+                const AnnouncementStaticData& staticData = view.GetStaticData_ReadOnly(ann.GetStaticDataIndex());
+
+                // Removed stubs receive from their provider, unless they are the origin
+                if (stubASN >= 0 && !filter.MatchesRelationship(pathOrigin == stubASN ? RELATIONSHIP_PRIORITY_ORIGIN : RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER))
+                    continue;
+
+                fileBuffer.write("%s\t%i\t%lli\t{", staticData.prefixString.c_str(), staticData.originASN, staticData.timestamp);
+
+                if (stubASN >= 0) {
+                    // If the AS path has the stub as the origin and we are dumping the local rib of the stub
+                    // Then the path will have the provider and the stub, which is not correct
+                    if (pathOrigin == stubASN) {
+                        fileBuffer.write("%d}\n", stubASN);
+                        continue;
+                    }
+
                     fileBuffer.write("%d,", stubASN);
                 }
-            }
 
-            for (size_t j = 0; j < as_path.size(); j++) {
-                if (j == as_path.size() - 1)
-                    fileBuffer.write("%d", as_path[j]);
-                else
-                    fileBuffer.write("%d,", as_path[j]);
+                fileBuffer.append(pathText, pathTextLength);
+                fileBuffer.write("}\n");
             }
-            
-            fileBuffer.write("}\n");
         }
     }
-
-    fileBuffer.flush();
-    fclose(f);
 }
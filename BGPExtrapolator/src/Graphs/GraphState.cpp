@@ -0,0 +1,596 @@
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <cstring>
+
+#include "Graphs/Graph.hpp"
+#include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
+
+static const char CHECKPOINT_MAGIC[8] = { 'B', 'G', 'P', 'X', 'C', 'K', 'P', 'T' };
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+// The rib arena is page aligned in the file so it can be used in place from the mapping
+static const uint64_t CHECKPOINT_RIBS_ALIGNMENT = 4096;
+static const uint64_t CHECKPOINT_SECTION_ALIGNMENT = 8;
+
+enum CHECKPOINT_SECTION {
+    ID_TO_ASN,              // ASN[numASes]
+    RANK_OFFSETS,           // uint64_t[numRanks + 1], index into RANK_IDS
+    RANK_IDS,               // ASN_ID[numASes]
+    PROVIDER_OFFSETS,       // uint64_t[numASes + 1], index into PROVIDERS
+    PROVIDERS,              // ASN_ASNID_PAIR[]
+    PEER_OFFSETS,
+    PEERS,
+    CUSTOMER_OFFSETS,
+    CUSTOMERS,
+    STUBS,                  // CheckpointStub[]
+    RELATIONSHIP_PRIORITIES,// CheckpointRelationshipPriority[]
+    PROVIDER_PREFERENCES,   // (customer ASN, count, provider ASNs...) repeated
+    STATIC_DATA,            // CheckpointStaticData[numStaticData]
+    STRING_POOL,            // char[], prefix strings
+    SEEDED_PATHS,           // ASN[]
+    FREE_STATIC_DATA,       // uint32_t[]
+    RIBS,                   // AnnouncementCachedData[numASes * numPrefixes], AS major
+    NUM_CHECKPOINT_SECTIONS
+};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t announcementSize;
+
+    uint64_t numASes;
+    uint64_t numPrefixes;
+    uint64_t numStaticData;
+    uint64_t numRanks;
+
+    uint8_t stubRemoval;
+    uint8_t retainSeededPaths;
+    uint8_t padding[6];
+
+    uint64_t sectionOffsets[NUM_CHECKPOINT_SECTIONS];
+    uint64_t sectionSizes[NUM_CHECKPOINT_SECTIONS];
+};
+
+struct CheckpointStub {
+    ASN stubASN;
+    ASN_ID providerID;
+};
+
+struct CheckpointRelationshipPriority {
+    ASN from, to;
+    uint32_t priority;
+};
+
+struct CheckpointStaticData {
+    ASN originASN;
+    uint32_t globalID;
+    uint32_t blockID;
+    uint32_t prefixStringLength;
+    int64_t timestamp;
+    uint64_t prefixStringOffset;
+    uint64_t seededPathOffset;
+    uint64_t seededPathLength;
+};
+
+/**
+ * Sections are written one after the other, the offsets are recorded as they go and the header is written last
+ */
+class CheckpointWriter {
+private:
+    FILE *f;
+    uint64_t position;
+    bool ok;
+
+public:
+    CheckpointHeader header;
+
+    CheckpointWriter(FILE *f) : f(f), position(0), ok(true) {
+        memset(&header, 0, sizeof(header));
+        Pad(sizeof(header));
+    }
+
+    void Pad(uint64_t length) {
+        static const char zeros[CHECKPOINT_RIBS_ALIGNMENT] = { 0 };
+        while (length > 0 && ok) {
+            uint64_t chunk = std::min(length, (uint64_t) sizeof(zeros));
+            ok = fwrite(zeros, 1, chunk, f) == chunk;
+            position += chunk;
+            length -= chunk;
+        }
+    }
+
+    void BeginSection(CHECKPOINT_SECTION section, uint64_t alignment = CHECKPOINT_SECTION_ALIGNMENT) {
+        Pad((alignment - position % alignment) % alignment);
+        header.sectionOffsets[section] = position;
+    }
+
+    void Write(CHECKPOINT_SECTION section, const void *data, uint64_t length) {
+        if (length > 0 && ok)
+            ok = fwrite(data, 1, length, f) == length;
+
+        position += length;
+        header.sectionSizes[section] += length;
+    }
+
+    template <typename T>
+    void WriteSection(CHECKPOINT_SECTION section, const std::vector<T> &values) {
+        BeginSection(section);
+        Write(section, values.data(), values.size() * sizeof(T));
+    }
+
+    bool Finish() {
+        ok = ok && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+        return ok;
+    }
+};
+
+/**
+ * Flattens a list of neighbor lists into offsets + one contiguous list (compressed sparse rows)
+ */
+static void WriteAdjacency(CheckpointWriter &writer, CHECKPOINT_SECTION offsetSection, CHECKPOINT_SECTION dataSection, const std::vector<std::vector<ASN_ASNID_PAIR>> &adjacency) {
+    std::vector<uint64_t> offsets(1, 0);
+    for (auto &neighbors : adjacency)
+        offsets.push_back(offsets.back() + neighbors.size());
+
+    writer.WriteSection(offsetSection, offsets);
+
+    writer.BeginSection(dataSection);
+    for (auto &neighbors : adjacency)
+        writer.Write(dataSection, neighbors.data(), neighbors.size() * sizeof(ASN_ASNID_PAIR));
+}
+
+bool Graph::WriteCheckpoint(const std::string& filePath) const {
+    FILE *f = fopen(filePath.c_str(), "wb");
+    if (f == nullptr) {
+        std::cout << "Could not open checkpoint file for writing: " << filePath << std::endl;
+        return false;
+    }
+
+    CheckpointWriter writer(f);
+    CheckpointHeader &header = writer.header;
+
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.announcementSize = sizeof(AnnouncementCachedData);
+    header.numASes = GetNumASes();
+    header.numPrefixes = GetNumPrefixes();
+    header.numStaticData = announcementStaticData.size();
+    header.numRanks = rankToIDs.size();
+    header.stubRemoval = stubRemoval;
+    header.retainSeededPaths = retainSeededPaths;
+
+    // ***** Topology
+    writer.WriteSection(ID_TO_ASN, idToASN);
+
+    std::vector<uint64_t> rankOffsets(1, 0);
+    writer.BeginSection(RANK_IDS);
+    for (auto &ids : rankToIDs) {
+        writer.Write(RANK_IDS, ids.data(), ids.size() * sizeof(ASN_ID));
+        rankOffsets.push_back(rankOffsets.back() + ids.size());
+    }
+    writer.WriteSection(RANK_OFFSETS, rankOffsets);
+
+    WriteAdjacency(writer, PROVIDER_OFFSETS, PROVIDERS, asIDToProviderIDs);
+    WriteAdjacency(writer, PEER_OFFSETS, PEERS, asIDToPeerIDs);
+    WriteAdjacency(writer, CUSTOMER_OFFSETS, CUSTOMERS, asIDToCustomerIDs);
+
+    std::vector<CheckpointStub> stubs;
+    for (auto &stub : asnTable.GetStubs())
+        stubs.push_back({ stub.first, stub.second });
+    writer.WriteSection(STUBS, stubs);
+
+    std::vector<CheckpointRelationshipPriority> priorities;
+    for (auto &kv : relationshipPriority)
+        priorities.push_back({ kv.first.first, kv.first.second, kv.second });
+    writer.WriteSection(RELATIONSHIP_PRIORITIES, priorities);
+
+    std::vector<ASN> preferences;
+    for (auto &kv : customerToProviderPreferences) {
+        preferences.push_back(kv.first);
+        preferences.push_back(kv.second.size());
+        preferences.insert(preferences.end(), kv.second.begin(), kv.second.end());
+    }
+    writer.WriteSection(PROVIDER_PREFERENCES, preferences);
+
+    // ***** Announcements
+    std::vector<CheckpointStaticData> staticRecords;
+    std::vector<char> stringPool;
+    std::vector<ASN> paths;
+    for (const AnnouncementStaticData &staticData : announcementStaticData) {
+        CheckpointStaticData record;
+        record.originASN = staticData.originASN;
+        record.globalID = staticData.prefix.global_id;
+        record.blockID = staticData.prefix.block_id;
+        record.timestamp = staticData.timestamp;
+        record.prefixStringOffset = stringPool.size();
+        record.prefixStringLength = staticData.prefixString.size();
+        stringPool.insert(stringPool.end(), staticData.prefixString.begin(), staticData.prefixString.end());
+
+        // Paths are written next to each other in static data order, which compacts the arena
+        record.seededPathOffset = paths.size();
+        record.seededPathLength = retainSeededPaths ? staticData.seededPathLength : 0;
+        if (record.seededPathLength > 0)
+            paths.insert(paths.end(), seededPaths.begin() + staticData.seededPathOffset, seededPaths.begin() + staticData.seededPathOffset + staticData.seededPathLength);
+
+        staticRecords.push_back(record);
+    }
+
+    writer.WriteSection(STATIC_DATA, staticRecords);
+    writer.WriteSection(STRING_POOL, stringPool);
+    writer.WriteSection(SEEDED_PATHS, paths);
+    writer.WriteSection(FREE_STATIC_DATA, freeStaticDataIndices);
+
+    writer.BeginSection(RIBS, CHECKPOINT_RIBS_ALIGNMENT);
+    if (localRibs.IsASMajor()) {
+        writer.Write(RIBS, localRibs.GetArena(), localRibs.GetArenaSize() * sizeof(AnnouncementCachedData));
+    } else {
+        // Tiled (file backed) ribs are written out AS major, one contiguous run per AS per tile
+        const size_t tileLength = localRibs.GetTileLength();
+        for (ASN_ID id = 0; id < GetNumASes(); id++) {
+            for (size_t tileBegin = 0; tileBegin < GetNumPrefixes(); tileBegin += tileLength) {
+                size_t length = std::min(tileLength, GetNumPrefixes() - tileBegin);
+                writer.Write(RIBS, &localRibs.GetAnnouncement_ReadOnly(id, tileBegin), length * sizeof(AnnouncementCachedData));
+            }
+        }
+    }
+
+    bool ok = writer.Finish();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok)
+        std::cout << "Failed writing checkpoint file: " << filePath << std::endl;
+
+    return ok;
+}
+
+/**
+ * Typed access to the sections of a mapped checkpoint
+ */
+class CheckpointReader {
+private:
+    const char *data;
+    size_t size;
+
+public:
+    const CheckpointHeader *header;
+
+    CheckpointReader(const char *data, size_t size) : data(data), size(size), header(nullptr) {
+        if (size >= sizeof(CheckpointHeader))
+            header = (const CheckpointHeader*) data;
+    }
+
+    bool Validate(std::string &reason) const {
+        if (header == nullptr || memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+            reason = "not a checkpoint file";
+            return false;
+        }
+
+        if (header->version != CHECKPOINT_VERSION || header->announcementSize != sizeof(AnnouncementCachedData)) {
+            reason = "checkpoint was written by a different version of the extrapolator";
+            return false;
+        }
+
+        for (int i = 0; i < NUM_CHECKPOINT_SECTIONS; i++) {
+            if (header->sectionOffsets[i] > size || header->sectionSizes[i] > size - header->sectionOffsets[i]) {
+                reason = "checkpoint is truncated";
+                return false;
+            }
+        }
+
+        if (header->sectionSizes[RIBS] != header->numASes * header->numPrefixes * sizeof(AnnouncementCachedData)) {
+            reason = "checkpoint rib arena has the wrong size";
+            return false;
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    inline const T* Get(CHECKPOINT_SECTION section) const {
+        return (const T*) (data + header->sectionOffsets[section]);
+    }
+
+    template <typename T>
+    inline size_t Count(CHECKPOINT_SECTION section) const {
+        return header->sectionSizes[section] / sizeof(T);
+    }
+};
+
+static void ReadAdjacency(const CheckpointReader &reader, CHECKPOINT_SECTION offsetSection, CHECKPOINT_SECTION dataSection, std::vector<std::vector<ASN_ASNID_PAIR>> &adjacency) {
+    const uint64_t *offsets = reader.Get<uint64_t>(offsetSection);
+    const ASN_ASNID_PAIR *pairs = reader.Get<ASN_ASNID_PAIR>(dataSection);
+
+    for (size_t i = 0; i < adjacency.size(); i++)
+        adjacency[i].assign(pairs + offsets[i], pairs + offsets[i + 1]);
+}
+
+std::unique_ptr<Graph> Graph::LoadCheckpoint(const std::string& filePath) {
+    std::shared_ptr<MappedFile> mapping(new MappedFile());
+    if (!mapping->Open(filePath)) {
+        std::cout << "Could not open checkpoint file: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    CheckpointReader reader(mapping->GetData(), mapping->GetSize());
+    std::string reason;
+    if (!reader.Validate(reason)) {
+        std::cout << "Could not load checkpoint " << filePath << ": " << reason << std::endl;
+        return nullptr;
+    }
+
+    const CheckpointHeader &header = *reader.header;
+    std::unique_ptr<Graph> graph(new Graph());
+
+    graph->stubRemoval = header.stubRemoval != 0;
+    graph->retainSeededPaths = header.retainSeededPaths != 0;
+
+    // ***** Topology
+    const ASN *idToASN = reader.Get<ASN>(ID_TO_ASN);
+    graph->idToASN.assign(idToASN, idToASN + header.numASes);
+    for (ASN_ID id = 0; id < header.numASes; id++)
+        graph->idToImportPolicy.push_back(std::unique_ptr<BGPPolicy>(new BGPPolicy(idToASN[id], id)));
+
+    const uint64_t *rankOffsets = reader.Get<uint64_t>(RANK_OFFSETS);
+    const ASN_ID *rankIDs = reader.Get<ASN_ID>(RANK_IDS);
+    graph->rankToIDs.resize(header.numRanks);
+    for (size_t rank = 0; rank < header.numRanks; rank++)
+        graph->rankToIDs[rank].assign(rankIDs + rankOffsets[rank], rankIDs + rankOffsets[rank + 1]);
+
+    graph->asIDToProviderIDs.resize(header.numASes);
+    graph->asIDToPeerIDs.resize(header.numASes);
+    graph->asIDToCustomerIDs.resize(header.numASes);
+    ReadAdjacency(reader, PROVIDER_OFFSETS, PROVIDERS, graph->asIDToProviderIDs);
+    ReadAdjacency(reader, PEER_OFFSETS, PEERS, graph->asIDToPeerIDs);
+    ReadAdjacency(reader, CUSTOMER_OFFSETS, CUSTOMERS, graph->asIDToCustomerIDs);
+
+    const CheckpointStub *stubs = reader.Get<CheckpointStub>(STUBS);
+    std::vector<std::pair<ASN, ASN_ID>> stubToProviderID;
+    for (size_t i = 0; i < reader.Count<CheckpointStub>(STUBS); i++)
+        stubToProviderID.push_back(std::make_pair(stubs[i].stubASN, stubs[i].providerID));
+    graph->asnTable.Build(graph->idToASN, stubToProviderID);
+
+    const CheckpointRelationshipPriority *priorities = reader.Get<CheckpointRelationshipPriority>(RELATIONSHIP_PRIORITIES);
+    for (size_t i = 0; i < reader.Count<CheckpointRelationshipPriority>(RELATIONSHIP_PRIORITIES); i++)
+        graph->relationshipPriority.insert({ std::make_pair(priorities[i].from, priorities[i].to), (uint8_t) priorities[i].priority });
+
+    const ASN *preferences = reader.Get<ASN>(PROVIDER_PREFERENCES);
+    const ASN *preferencesEnd = preferences + reader.Count<ASN>(PROVIDER_PREFERENCES);
+    while (preferences < preferencesEnd) {
+        ASN customer = preferences[0];
+        ASN count = preferences[1];
+        graph->customerToProviderPreferences[customer].assign(preferences + 2, preferences + 2 + count);
+        preferences += 2 + count;
+    }
+
+    // ***** Announcements
+    const CheckpointStaticData *staticRecords = reader.Get<CheckpointStaticData>(STATIC_DATA);
+    const char *stringPool = reader.Get<char>(STRING_POOL);
+    graph->announcementStaticData.resize(header.numStaticData);
+    for (size_t i = 0; i < header.numStaticData; i++) {
+        const CheckpointStaticData &record = staticRecords[i];
+        AnnouncementStaticData &staticData = graph->announcementStaticData[i];
+
+        staticData.originASN = record.originASN;
+        staticData.prefix.global_id = record.globalID;
+        staticData.prefix.block_id = record.blockID;
+        staticData.timestamp = record.timestamp;
+        staticData.prefixString.assign(stringPool + record.prefixStringOffset, record.prefixStringLength);
+        staticData.seededPathOffset = record.seededPathOffset;
+        staticData.seededPathLength = record.seededPathLength;
+    }
+
+    const ASN *paths = reader.Get<ASN>(SEEDED_PATHS);
+    graph->seededPaths.assign(paths, paths + reader.Count<ASN>(SEEDED_PATHS));
+
+    const uint32_t *freeIndices = reader.Get<uint32_t>(FREE_STATIC_DATA);
+    graph->freeStaticDataIndices.assign(freeIndices, freeIndices + reader.Count<uint32_t>(FREE_STATIC_DATA));
+
+    // The ribs are used straight from the mapping, pages are only read in when touched
+    AnnouncementCachedData *ribs = (AnnouncementCachedData*) (mapping->GetData() + header.sectionOffsets[RIBS]);
+    graph->localRibs.AttachMapping(mapping, ribs, header.numASes, header.numPrefixes);
+
+    return graph;
+}
+
+bool Graph::ApplyAnnouncementsDelta(const std::string& filePathDiff, const SeedingConfiguration& config) {
+    if (!retainSeededPaths) {
+        std::cout << "Delta mode requires the seeded paths of the previous run. Save the state with seeded paths retained." << std::endl;
+        return false;
+    }
+
+    rapidcsv::Document diffCSV(filePathDiff, rapidcsv::LabelParams(0, -1), rapidcsv::SeparatorParams(SEPARATED_VALUES_DELIMETER));
+
+    std::set<uint32_t> affectedBlocks;
+    for (size_t rowIndex = 0; rowIndex < diffCSV.GetRowCount(); rowIndex++)
+        affectedBlocks.insert(diffCSV.GetCell<uint32_t>("prefix_block_id", rowIndex));
+
+    if (affectedBlocks.empty())
+        return true;
+
+    // Live announcements of each affected block, in static data order. Single pass over the static data
+    std::map<uint32_t, std::vector<uint32_t>> blockToStaticDataIndices;
+    std::vector<bool> isFree(announcementStaticData.size(), false);
+    for (uint32_t index : freeStaticDataIndices)
+        isFree[index] = true;
+
+    for (uint32_t index = 0; index < announcementStaticData.size(); index++) {
+        const AnnouncementStaticData &staticData = announcementStaticData[index];
+        if (isFree[index] || staticData.seededPathLength == 0 || affectedBlocks.count(staticData.prefix.block_id) == 0)
+            continue;
+
+        blockToStaticDataIndices[staticData.prefix.block_id].push_back(index);
+    }
+
+    // Finds the live announcement of a block with the given vantage point. Returns false if there is none
+    auto findAnnouncement = [&](const uint32_t prefixBlockID, const ASN vantagePoint, std::vector<uint32_t>::iterator &result) {
+        std::vector<uint32_t> &indices = blockToStaticDataIndices[prefixBlockID];
+        for (result = indices.begin(); result != indices.end(); result++) {
+            const AnnouncementStaticData &staticData = announcementStaticData[*result];
+            if (seededPaths[staticData.seededPathOffset] == vantagePoint)
+                return true;
+        }
+        return false;
+    };
+
+    //***** Checked against the live announcements before anything changes, so a refused diff leaves the graph as it was
+    // An announcement is identified by its prefix block and vantage point, which must then be unique within the affected blocks
+    std::map<std::pair<uint32_t, ASN>, size_t> identityCounts;
+    for (auto &kv : blockToStaticDataIndices) {
+        for (uint32_t index : kv.second)
+            identityCounts[std::make_pair(kv.first, seededPaths[announcementStaticData[index].seededPathOffset])]++;
+    }
+
+    for (auto &kv : identityCounts) {
+        if (kv.second > 1) {
+            std::cout << "Prefix block " << kv.first.first << " has " << kv.second << " announcements from vantage point " << kv.first.second
+                << ", the announcements diff cannot tell them apart. Run the announcements in full instead." << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::vector<ASN>> rowPaths(diffCSV.GetRowCount());
+    for (size_t rowIndex = 0; rowIndex < diffCSV.GetRowCount(); rowIndex++) {
+        std::string change = diffCSV.GetCell<std::string>("change", rowIndex);
+        uint32_t prefixBlockID = diffCSV.GetCell<uint32_t>("prefix_block_id", rowIndex);
+        Util::parseASNList(diffCSV.GetCell<std::string>("as_path", rowIndex), rowPaths[rowIndex]);
+
+        if (rowPaths[rowIndex].empty())
+            continue;
+
+        size_t &count = identityCounts[std::make_pair(prefixBlockID, rowPaths[rowIndex][0])];
+        if (change == "removed" || change == "changed") {
+            if (count == 0) {
+                std::cout << "Row " << rowIndex << " of the announcements diff is " << change << ", but prefix block " << prefixBlockID
+                    << " has no announcement from vantage point " << rowPaths[rowIndex][0] << std::endl;
+                return false;
+            }
+
+            if (change == "removed")
+                count = 0;
+        } else if (change == "added") {
+            if (count > 0) {
+                std::cout << "Row " << rowIndex << " of the announcements diff is added, but prefix block " << prefixBlockID
+                    << " already has an announcement from vantage point " << rowPaths[rowIndex][0] << " (changed?)" << std::endl;
+                return false;
+            }
+
+            count = 1;
+        } else {
+            std::cout << "Unknown change \"" << change << "\" on row " << rowIndex << " of the announcements diff" << std::endl;
+            return false;
+        }
+    }
+
+    //***** Applied
+    // The new paths are held until the affected columns have been reset, then everything in those blocks is seeded together
+    std::map<uint32_t, std::vector<ASN>> pendingPaths;
+    uint32_t maximumBlockID = *affectedBlocks.rbegin();
+
+    for (size_t rowIndex = 0; rowIndex < diffCSV.GetRowCount(); rowIndex++) {
+        std::string change = diffCSV.GetCell<std::string>("change", rowIndex);
+        std::vector<ASN> &asPath = rowPaths[rowIndex];
+        uint32_t prefixBlockID = diffCSV.GetCell<uint32_t>("prefix_block_id", rowIndex);
+
+        if (asPath.empty())
+            continue;
+
+        // Removed and changed rows have their announcement, added rows have none (checked above)
+        std::vector<uint32_t>::iterator existing;
+        uint32_t staticDataIndex;
+        if (change == "removed") {
+            findAnnouncement(prefixBlockID, asPath[0], existing);
+            freeStaticDataIndices.push_back(*existing);
+            announcementStaticData[*existing] = AnnouncementStaticData();
+            blockToStaticDataIndices[prefixBlockID].erase(existing);
+            continue;
+        } else if (change == "changed") {
+            findAnnouncement(prefixBlockID, asPath[0], existing);
+            staticDataIndex = *existing;
+            blockToStaticDataIndices[prefixBlockID].erase(existing);
+        } else if (freeStaticDataIndices.empty()) {
+            staticDataIndex = announcementStaticData.size();
+            announcementStaticData.push_back(AnnouncementStaticData());
+        } else {
+            staticDataIndex = freeStaticDataIndices.back();
+            freeStaticDataIndices.pop_back();
+        }
+
+        // Everything except the path is filled in now. A path that fits where the old one was overwrites it, any other is appended by SeedPath
+        AnnouncementStaticData &staticData = announcementStaticData[staticDataIndex];
+        staticData.prefix.global_id = diffCSV.GetCell<uint32_t>("prefix_id", rowIndex);
+        staticData.prefix.block_id = prefixBlockID;
+        staticData.prefixString = diffCSV.GetCell<std::string>("prefix", rowIndex);
+        staticData.timestamp = diffCSV.GetCell<int64_t>("timestamp", rowIndex);
+        if (asPath.size() <= staticData.seededPathLength) {
+            std::copy(asPath.begin(), asPath.end(), seededPaths.begin() + staticData.seededPathOffset);
+            staticData.seededPathLength = asPath.size();
+        } else {
+            staticData.seededPathLength = 0;
+        }
+
+        pendingPaths[staticDataIndex].swap(asPath);
+        blockToStaticDataIndices[prefixBlockID].push_back(staticDataIndex);
+    }
+
+    // New prefix blocks may have shown up
+    if (maximumBlockID >= GetNumPrefixes())
+        localRibs.SetNumPrefixes(maximumBlockID + 1);
+
+    for (uint32_t prefixBlockID : affectedBlocks)
+        ResetPrefixBlock(prefixBlockID);
+
+    // Seeding is order dependent (tiebreaks, stubs), so each block is seeded in static data order like SeedBlock would.
+    // Changed announcements keep their slot, so they are seeded in the same position as in the announcements file
+    statisticsProfile = PropagationStatisticsProfile();
+    const PropagationStatistics statisticsStart = DefaultStatistics::ReadThread();
+
+    std::vector<ASN> asPath;
+    for (auto &kv : blockToStaticDataIndices) {
+        std::sort(kv.second.begin(), kv.second.end());
+
+        for (uint32_t index : kv.second) {
+            AnnouncementStaticData &staticData = announcementStaticData[index];
+
+            auto pendingSearch = pendingPaths.find(index);
+            if (pendingSearch != pendingPaths.end())
+                asPath.swap(pendingSearch->second);
+            else
+                asPath.assign(seededPaths.begin() + staticData.seededPathOffset, seededPaths.begin() + staticData.seededPathOffset + staticData.seededPathLength);
+
+            SeedPath(asPath, index, staticData.prefix, staticData.prefixString, staticData.timestamp, config);
+        }
+    }
+
+    statisticsProfile.seeding = DefaultStatistics::ReadThread().Since(statisticsStart);
+
+    // Removed and outgrown paths are left behind in the arena. Once they make up half of it, the live paths are moved together
+    size_t livePathLength = 0;
+    for (const AnnouncementStaticData &staticData : announcementStaticData)
+        livePathLength += staticData.seededPathLength;
+
+    if (livePathLength * 2 < seededPaths.size()) {
+        std::vector<ASN> compacted;
+        compacted.reserve(livePathLength);
+        for (AnnouncementStaticData &staticData : announcementStaticData) {
+            const uint64_t offset = compacted.size();
+            compacted.insert(compacted.end(), seededPaths.begin() + staticData.seededPathOffset, seededPaths.begin() + staticData.seededPathOffset + staticData.seededPathLength);
+            staticData.seededPathOffset = offset;
+        }
+        seededPaths.swap(compacted);
+    }
+
+    // Propagate each run of consecutive affected blocks together
+    propagationTimings = PropagationTimings();
+    propagationProfile = PropagationProfile();
+    auto it = affectedBlocks.begin();
+    while (it != affectedBlocks.end()) {
+        uint32_t runBegin = *it;
+        uint32_t runEnd = runBegin + 1;
+        for (it++; it != affectedBlocks.end() && *it == runEnd; it++)
+            runEnd++;
+
+        Propagate(runBegin, runEnd);
+    }
+
+    return true;
+}
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <ctype.h>
+#include <string.h>
+
+#include "Graphs/ResultsFilter.hpp"
+
+static bool ParseIPv4(const std::string &text, uint8_t *address) {
+    size_t octet = 0, position = 0;
+    while (octet < 4) {
+        size_t digits = 0;
+        unsigned value = 0;
+        while (position < text.size() && text[position] >= '0' && text[position] <= '9' && digits < 3) {
+            value = value * 10 + (text[position++] - '0');
+            digits++;
+        }
+
+        if (digits == 0 || value > 255)
+            return false;
+        address[octet++] = (uint8_t) value;
+
+        if (octet < 4 && (position >= text.size() || text[position++] != '.'))
+            return false;
+    }
+
+    return position == text.size();
+}
+
+static bool ParseIPv6(const std::string &text, uint8_t *address) {
+    // Groups before and after the "::", if any
+    uint16_t head[8], tail[8];
+    size_t numHead = 0, numTail = 0;
+    bool compressed = false;
+
+    size_t position = 0;
+    if (text.compare(0, 2, "::") == 0) {
+        compressed = true;
+        position = 2;
+    }
+
+    while (position < text.size()) {
+        size_t digits = 0;
+        unsigned value = 0;
+        while (position < text.size() && isxdigit((unsigned char) text[position]) && digits < 4) {
+            const char c = text[position++];
+            value = value * 16 + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+            digits++;
+        }
+
+        if (digits == 0 || numHead + numTail == 8)
+            return false;
+        (compressed ? tail[numTail++] : head[numHead++]) = (uint16_t) value;
+
+        if (position == text.size())
+            break;
+        if (text[position++] != ':')
+            return false;
+
+        if (position < text.size() && text[position] == ':') {
+            if (compressed)
+                return false;
+            compressed = true;
+            position++;
+        } else if (position == text.size()) {
+            return false;
+        }
+    }
+
+    if (compressed ? numHead + numTail > 7 : numHead != 8)
+        return false;
+
+    memset(address, 0, 16);
+    for (size_t i = 0; i < numHead; i++) {
+        address[2 * i] = head[i] >> 8;
+        address[2 * i + 1] = head[i] & 0xFF;
+    }
+    for (size_t i = 0; i < numTail; i++) {
+        address[16 - 2 * (numTail - i)] = tail[i] >> 8;
+        address[16 - 2 * (numTail - i) + 1] = tail[i] & 0xFF;
+    }
+
+    return true;
+}
+
+bool PrefixRange::Parse(const std::string &text, PrefixRange &range) {
+    range = PrefixRange();
+
+    const size_t slash = text.find('/');
+    const std::string address = text.substr(0, slash);
+    range.ipv6 = address.find(':') != std::string::npos;
+    if (!(range.ipv6 ? ParseIPv6(address, range.address) : ParseIPv4(address, range.address)))
+        return false;
+
+    const unsigned maximumLength = range.ipv6 ? 128 : 32;
+    if (slash == std::string::npos) {
+        range.length = maximumLength;
+        return true;
+    }
+
+    const std::string length = text.substr(slash + 1);
+    if (length.empty() || length.size() > 3 || length.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+
+    const unsigned value = std::stoul(length);
+    if (value > maximumLength)
+        return false;
+
+    range.length = (uint8_t) value;
+    return true;
+}
+
+bool PrefixRange::Contains(const PrefixRange &prefix) const {
+    if (prefix.ipv6 != ipv6 || prefix.length < length)
+        return false;
+
+    const size_t fullBytes = length / 8;
+    if (memcmp(address, prefix.address, fullBytes) != 0)
+        return false;
+
+    const unsigned remainingBits = length % 8;
+    if (remainingBits == 0)
+        return true;
+
+    const uint8_t mask = (uint8_t) (0xFF << (8 - remainingBits));
+    return (address[fullBytes] & mask) == (prefix.address[fullBytes] & mask);
+}
+
+bool ResultsFilter::MatchesAnnouncement(const std::string &prefixString, const ASN originASN) const {
+    if (!originASNs.empty() && !std::binary_search(originASNs.begin(), originASNs.end(), originASN))
+        return false;
+
+    if (prefixRanges.empty())
+        return true;
+
+    // An announcement whose prefix cannot be read falls within no range
+    PrefixRange prefix;
+    if (!PrefixRange::Parse(prefixString, prefix))
+        return false;
+
+    for (auto &range : prefixRanges)
+        if (range.Contains(prefix))
+            return true;
+
+    return false;
+}
+
+bool ResultsFilter::FromJSON(const nlohmann::json &json, ResultsFilter &filter, std::string &error) {
+    auto prefixes_search = json.find("results_filter_prefixes");
+    if (prefixes_search != json.end()) {
+        if (!prefixes_search.value().is_array()) {
+            error = "Expected a list of prefixes to filter the results by!";
+            return false;
+        }
+
+        filter.prefixRanges.clear();
+        for (auto &prefix : prefixes_search.value()) {
+            PrefixRange range;
+            if (!prefix.is_string() || !PrefixRange::Parse(prefix.get<std::string>(), range)) {
+                error = "Could not read the prefix to filter the results by: " + prefix.dump();
+                return false;
+            }
+
+            filter.prefixRanges.push_back(range);
+        }
+    }
+
+    auto origins_search = json.find("results_filter_origins");
+    if (origins_search != json.end()) {
+        if (!origins_search.value().is_array()) {
+            error = "Expected a list of origin ASNs to filter the results by!";
+            return false;
+        }
+
+        filter.originASNs = origins_search.value().get<std::vector<ASN>>();
+        std::sort(filter.originASNs.begin(), filter.originASNs.end());
+    }
+
+    auto relationships_search = json.find("results_filter_relationships");
+    if (relationships_search != json.end()) {
+        if (!relationships_search.value().is_array()) {
+            error = "Expected a list of relationships to filter the results by!";
+            return false;
+        }
+
+        filter.relationships = 0;
+        for (auto &relationship : relationships_search.value()) {
+            std::string name = relationship.is_string() ? relationship.get<std::string>() : "";
+            if (name == "origin") {
+                filter.relationships |= 1 << RELATIONSHIP_PRIORITY_ORIGIN;
+            } else if (name == "customer_to_provider") {
+                filter.relationships |= 1 << RELATIONSHIP_PRIORITY_CUSTOMER_TO_PROVIDER;
+            } else if (name == "peer_to_peer") {
+                filter.relationships |= 1 << RELATIONSHIP_PRIORITY_PEER_TO_PEER;
+            } else if (name == "provider_to_customer") {
+                filter.relationships |= 1 << RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER;
+            } else {
+                error = "Unknown relationship to filter the results by: " + relationship.dump();
+                return false;
+            }
+        }
+    }
+
+    auto propagated_only_search = json.find("results_propagated_only");
+    if (propagated_only_search != json.end()) {
+        if (!propagated_only_search.value().is_boolean()) {
+            error = "Expected a boolean for propagated only results!";
+            return false;
+        }
+
+        filter.propagatedOnly = propagated_only_search.value().get<bool>();
+    }
+
+    return true;
+}
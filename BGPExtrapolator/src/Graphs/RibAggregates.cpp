@@ -0,0 +1,471 @@
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+#include "Graphs/Graph.hpp"
+#include "Graphs/RibAggregates.hpp"
+#include "TraceRecorder.hpp"
+
+// Prefix blocks read together: the cells of an AS for neighboring blocks share cache lines (same as the traceback passes)
+static const uint32_t AGGREGATE_BLOCKS_PER_PASS = 32;
+
+// Depth of an AS that is being resolved, a path that comes back to it is a cycle
+static const uint8_t DEPTH_RESOLVING = 0xFF;
+
+/**
+ * What one thread counted for one lane, by AS ID (and written AS) rather than ASN until the threads are added up
+ */
+struct LaneCounts {
+    std::vector<uint64_t> pathLengths;
+    std::unordered_map<ASN, OriginReach> originReach;
+
+    // RELATIONSHIP_PRIORITY_* of the routes of every AS ID, and of every removed stub written (by its index among them)
+    std::vector<uint64_t> relationships;
+    std::vector<uint64_t> stubRelationships;
+
+    std::vector<uint64_t> nextHopRoutes;
+    std::vector<uint64_t> transitRoutes;
+    // Next hops without an ID: origins that are removed stubs, or not in the graph
+    std::unordered_map<ASN, uint64_t> originNextHopRoutes;
+
+    LaneCounts(const size_t numASes, const size_t numStubs, const unsigned outputs) : pathLengths(AGGREGATE_MAX_PATH_LENGTH + 1, 0) {
+        if (outputs & AGGREGATE_RELATIONSHIPS) {
+            relationships.assign(numASes * NUM_RELATIONSHIP_PRIORITIES, 0);
+            stubRelationships.assign(numStubs * NUM_RELATIONSHIP_PRIORITIES, 0);
+        }
+
+        if (outputs & AGGREGATE_TRANSIT) {
+            nextHopRoutes.assign(numASes, 0);
+            transitRoutes.assign(numASes, 0);
+        }
+    }
+
+    void Add(const LaneCounts &other) {
+        for (size_t i = 0; i < pathLengths.size(); i++)
+            pathLengths[i] += other.pathLengths[i];
+        for (size_t i = 0; i < relationships.size(); i++)
+            relationships[i] += other.relationships[i];
+        for (size_t i = 0; i < stubRelationships.size(); i++)
+            stubRelationships[i] += other.stubRelationships[i];
+        for (size_t i = 0; i < nextHopRoutes.size(); i++) {
+            nextHopRoutes[i] += other.nextHopRoutes[i];
+            transitRoutes[i] += other.transitRoutes[i];
+        }
+
+        for (auto &kv : other.originReach) {
+            originReach[kv.first].prefixBlocks += kv.second.prefixBlocks;
+            originReach[kv.first].routes += kv.second.routes;
+        }
+        for (auto &kv : other.originNextHopRoutes)
+            originNextHopRoutes[kv.first] += kv.second;
+    }
+};
+
+/**
+ * Scratch of one thread: the cells of a pass of prefix blocks, block major, and the forest of the block being counted
+ */
+struct AggregateScratch {
+    std::vector<AnnouncementCachedData> cells;
+
+    // ASes on the path of every AS (0: not resolved yet), and the written ASes whose route goes through it (itself included)
+    std::vector<uint8_t> depth;
+    std::vector<uint32_t> weight;
+    std::vector<ASN_ID> chain;
+
+    // Removed stubs written whose route goes through their provider (the stub is not the origin)
+    std::vector<uint32_t> stubsVia;
+
+    // The ASes with a route sorted by depth, deepest last
+    std::vector<uint32_t> depthBegin;
+    std::vector<ASN_ID> byDepth;
+
+    std::vector<std::pair<ASN, uint64_t>> blockOrigins;
+    std::vector<LaneCounts> lanes;
+};
+
+/**
+ * @return whether the written AS path of the AS ends with an origin that is not in the graph, rather than at an AS of the graph
+ */
+static bool EndsAtMissingOrigin(const AnnouncementCachedData *cells, ASN_ID id) {
+    for (size_t length = 1; length < 99; length++) {
+        if (cells[id].GetRecievedFromID() == id)
+            return cells[id].GetPathLength() == 2;
+
+        id = cells[id].GetRecievedFromID();
+    }
+
+    return false;
+}
+
+std::vector<RibAggregates> Graph::ComputeRibAggregates(const std::vector<ASN> &localRibsToDump, const unsigned outputs) {
+    const size_t numASes = GetNumASes();
+
+    // Written ASes with an ID count as often as they are listed. Removed stubs are counted through their provider
+    std::vector<ASN_ID> dumpIDs;
+    std::vector<int64_t> dumpStubASNs;
+    ResolveDumpIDs(localRibsToDump, dumpIDs, dumpStubASNs);
+
+    std::vector<uint32_t> ownWeight(numASes, 0);
+    std::vector<uint32_t> stubBegin(numASes + 1, 0);
+    std::vector<ASN> stubASNs;
+    for (size_t i = 0; i < dumpIDs.size(); i++) {
+        if (dumpStubASNs[i] < 0)
+            ownWeight[dumpIDs[i]]++;
+        else
+            stubBegin[dumpIDs[i] + 1]++;
+    }
+
+    for (size_t id = 0; id < numASes; id++)
+        stubBegin[id + 1] += stubBegin[id];
+
+    // Removed stubs by provider, in the order of their stub relationship counts
+    stubASNs.resize(stubBegin[numASes]);
+    std::vector<uint32_t> position(stubBegin.begin(), stubBegin.end() - 1);
+    for (size_t i = 0; i < dumpIDs.size(); i++) {
+        if (dumpStubASNs[i] >= 0)
+            stubASNs[position[dumpIDs[i]]++] = (ASN) dumpStubASNs[i];
+    }
+
+    const bool needDepth = (outputs & (AGGREGATE_PATH_LENGTHS | AGGREGATE_TRANSIT)) != 0;
+    const size_t numThreads = threadPool->GetNumThreads();
+    std::vector<AggregateScratch> scratches(numThreads);
+
+    auto countBlock = [&](AggregateScratch &scratch, const AnnouncementCachedData *cells, const uint32_t prefixBlockID) {
+        LaneCounts &lane = scratch.lanes[prefixBlockID % numLanes];
+        scratch.blockOrigins.clear();
+        size_t lastOrigin = 0;
+
+        //***** Depths, following the received from IDs the way Traceback does (cut at 99), every AS resolved once
+        if (needDepth) {
+            std::fill(scratch.depth.begin(), scratch.depth.end(), 0);
+            for (ASN_ID id = 0; id < numASes; id++) {
+                if (cells[id].isDefaultState() || scratch.depth[id] != 0)
+                    continue;
+
+                scratch.chain.clear();
+                ASN_ID node = id;
+                size_t base;
+                while (true) {
+                    if (scratch.depth[node] == DEPTH_RESOLVING || scratch.chain.size() >= 99) {
+                        base = 99;
+                        break;
+                    }
+
+                    if (scratch.depth[node] != 0) {
+                        base = scratch.depth[node];
+                        break;
+                    }
+
+                    const AnnouncementCachedData &ann = cells[node];
+                    if (ann.GetRecievedFromID() == node) {
+                        // The origin, and the origin that was not in the graph behind it (stub removal)
+                        scratch.depth[node] = ann.GetPathLength() == 2 ? 2 : 1;
+                        base = scratch.depth[node];
+                        break;
+                    }
+
+                    scratch.depth[node] = DEPTH_RESOLVING;
+                    scratch.chain.push_back(node);
+                    node = ann.GetRecievedFromID();
+                }
+
+                for (size_t i = scratch.chain.size(); i-- > 0;) {
+                    base = std::min(base + 1, (size_t) 99);
+                    scratch.depth[scratch.chain[i]] = (uint8_t) base;
+                }
+            }
+        }
+
+        //***** Routes of the written ASes
+        for (ASN_ID id = 0; id < numASes; id++) {
+            const AnnouncementCachedData &ann = cells[id];
+            if (ann.isDefaultState())
+                continue;
+
+            const uint32_t stubCount = stubBegin[id + 1] - stubBegin[id];
+            if (outputs & AGGREGATE_TRANSIT)
+                scratch.stubsVia[id] = 0;
+            if (ownWeight[id] == 0 && stubCount == 0)
+                continue;
+
+            const ASN originASN = GetStaticData_ReadOnly(ann.GetStaticDataIndex()).originASN;
+            uint64_t routes = ownWeight[id];
+
+            lane.pathLengths[needDepth ? scratch.depth[id] : 0] += ownWeight[id];
+            if (outputs & AGGREGATE_RELATIONSHIPS)
+                lane.relationships[id * NUM_RELATIONSHIP_PRIORITIES + ann.GetRelationship()] += ownWeight[id];
+
+            // A removed stub has the route of its provider, with itself in front, unless it is the origin at the end of the provider's path
+            for (uint32_t stub = stubBegin[id]; stub < stubBegin[id + 1]; stub++) {
+                const bool stubOrigin = stubASNs[stub] == originASN && EndsAtMissingOrigin(cells, id);
+                lane.pathLengths[!needDepth ? 0 : stubOrigin ? 1 : scratch.depth[id] + 1]++;
+                if (outputs & AGGREGATE_RELATIONSHIPS)
+                    lane.stubRelationships[stub * NUM_RELATIONSHIP_PRIORITIES + (stubOrigin ? RELATIONSHIP_PRIORITY_ORIGIN : RELATIONSHIP_PRIORITY_PROVIDER_TO_CUSTOMER)]++;
+                if ((outputs & AGGREGATE_TRANSIT) && !stubOrigin)
+                    scratch.stubsVia[id]++;
+                routes++;
+            }
+
+            if (outputs & AGGREGATE_ORIGIN_REACH) {
+                // Neighboring ASes mostly share the origin of the last one
+                if (lastOrigin >= scratch.blockOrigins.size() || scratch.blockOrigins[lastOrigin].first != originASN) {
+                    lastOrigin = 0;
+                    while (lastOrigin < scratch.blockOrigins.size() && scratch.blockOrigins[lastOrigin].first != originASN)
+                        lastOrigin++;
+
+                    if (lastOrigin == scratch.blockOrigins.size())
+                        scratch.blockOrigins.push_back(std::make_pair(originASN, 0));
+                }
+                scratch.blockOrigins[lastOrigin].second += routes;
+            }
+        }
+
+        for (auto &origin : scratch.blockOrigins) {
+            if (origin.second == 0)
+                continue;
+
+            OriginReach &reach = lane.originReach[origin.first];
+            reach.prefixBlocks++;
+            reach.routes += origin.second;
+        }
+
+        if (!(outputs & AGGREGATE_TRANSIT))
+            return;
+
+        //***** Transit: the written ASes under every AS of the received from forest, added up from the deepest ASes to the origins
+        std::fill(scratch.depthBegin.begin(), scratch.depthBegin.end(), 0);
+        for (ASN_ID id = 0; id < numASes; id++) {
+            if (!cells[id].isDefaultState())
+                scratch.depthBegin[scratch.depth[id] + 1]++;
+        }
+        for (size_t d = 1; d < scratch.depthBegin.size(); d++)
+            scratch.depthBegin[d] += scratch.depthBegin[d - 1];
+
+        for (ASN_ID id = 0; id < numASes; id++) {
+            if (cells[id].isDefaultState())
+                continue;
+
+            scratch.byDepth[scratch.depthBegin[scratch.depth[id]]++] = id;
+            scratch.weight[id] = ownWeight[id] + scratch.stubsVia[id];
+        }
+
+        // depthBegin now holds where every depth ends, the deepest ASes are at the back
+        const size_t numRouted = scratch.depthBegin.back();
+        for (size_t i = numRouted; i-- > 0;) {
+            const ASN_ID id = scratch.byDepth[i];
+            const AnnouncementCachedData &ann = cells[id];
+            lane.nextHopRoutes[id] += scratch.stubsVia[id];
+
+            if (ann.GetRecievedFromID() == id) {
+                if (ann.GetPathLength() == 2) {
+                    // Received from the origin that is not in the graph, which is not transit
+                    lane.transitRoutes[id] += scratch.weight[id] - ownWeight[id];
+                    if (ownWeight[id] > 0)
+                        lane.originNextHopRoutes[GetStaticData_ReadOnly(ann.GetStaticDataIndex()).originASN] += ownWeight[id];
+                }
+                continue;
+            }
+
+            lane.transitRoutes[id] += scratch.weight[id] - ownWeight[id];
+            lane.nextHopRoutes[ann.GetRecievedFromID()] += ownWeight[id];
+            scratch.weight[ann.GetRecievedFromID()] += scratch.weight[id];
+        }
+    };
+
+    //***** One pass over the local ribs, tile by tile, the prefix blocks of a tile split over the threads
+    const size_t tileLength = localRibs.GetTileLength();
+    for (size_t tileBegin = 0; tileBegin < GetNumPrefixes(); tileBegin += tileLength) {
+        BGPX_TRACE_SCOPE_ARG("aggregate_tile", "write", "prefix_begin", tileBegin);
+        const uint32_t tileEnd = std::min(tileBegin + tileLength, GetNumPrefixes());
+        localRibs.PrefetchTile(tileBegin + tileLength);
+
+        threadPool->ParallelFor(tileBegin, tileEnd, [&](size_t threadIndex, size_t begin, size_t end) {
+            AggregateScratch &scratch = scratches[threadIndex];
+            if (scratch.lanes.empty()) {
+                scratch.cells.resize(AGGREGATE_BLOCKS_PER_PASS * numASes);
+                scratch.depth.resize(numASes);
+                scratch.weight.resize(numASes);
+                scratch.stubsVia.resize(numASes);
+                scratch.depthBegin.resize(AGGREGATE_MAX_PATH_LENGTH + 1);
+                scratch.byDepth.resize(numASes);
+                for (size_t lane = 0; lane < numLanes; lane++)
+                    scratch.lanes.emplace_back(numASes, stubASNs.size(), outputs);
+            }
+
+            for (uint32_t passBegin = begin; passBegin < end; passBegin += AGGREGATE_BLOCKS_PER_PASS) {
+                const uint32_t passEnd = std::min((size_t) passBegin + AGGREGATE_BLOCKS_PER_PASS, end);
+                for (ASN_ID id = 0; id < numASes; id++) {
+                    for (uint32_t prefixBlockID = passBegin; prefixBlockID < passEnd; prefixBlockID++)
+                        scratch.cells[(prefixBlockID - passBegin) * numASes + id] = GetCachedData_ReadOnly(id, prefixBlockID);
+                }
+
+                for (uint32_t prefixBlockID = passBegin; prefixBlockID < passEnd; prefixBlockID++)
+                    countBlock(scratch, scratch.cells.data() + (prefixBlockID - passBegin) * numASes, prefixBlockID);
+            }
+        });
+
+        localRibs.ReleaseTile(tileBegin);
+    }
+
+    //***** Threads added up, then keyed by ASN
+    std::vector<LaneCounts> totals;
+    for (size_t lane = 0; lane < numLanes; lane++)
+        totals.emplace_back(numASes, stubASNs.size(), outputs);
+    for (auto &scratch : scratches) {
+        for (size_t lane = 0; lane < scratch.lanes.size(); lane++)
+            totals[lane].Add(scratch.lanes[lane]);
+    }
+
+    std::vector<RibAggregates> aggregates(numLanes);
+    for (size_t lane = 0; lane < numLanes; lane++) {
+        const LaneCounts &counts = totals[lane];
+        RibAggregates &aggregate = aggregates[lane];
+
+        if (outputs & AGGREGATE_PATH_LENGTHS)
+            aggregate.pathLengths = counts.pathLengths;
+
+        if (outputs & AGGREGATE_ORIGIN_REACH)
+            aggregate.originReach.insert(counts.originReach.begin(), counts.originReach.end());
+
+        if (outputs & AGGREGATE_RELATIONSHIPS) {
+            for (ASN_ID id = 0; id < numASes; id++) {
+                if (ownWeight[id] == 0)
+                    continue;
+
+                std::vector<uint64_t> &relationships = aggregate.relationships[idToASN[id]];
+                relationships.resize(NUM_RELATIONSHIP_PRIORITIES, 0);
+                for (size_t r = 0; r < NUM_RELATIONSHIP_PRIORITIES; r++)
+                    relationships[r] += counts.relationships[id * NUM_RELATIONSHIP_PRIORITIES + r];
+            }
+
+            for (size_t stub = 0; stub < stubASNs.size(); stub++) {
+                std::vector<uint64_t> &relationships = aggregate.relationships[stubASNs[stub]];
+                relationships.resize(NUM_RELATIONSHIP_PRIORITIES, 0);
+                for (size_t r = 0; r < NUM_RELATIONSHIP_PRIORITIES; r++)
+                    relationships[r] += counts.stubRelationships[stub * NUM_RELATIONSHIP_PRIORITIES + r];
+            }
+        }
+
+        if (outputs & AGGREGATE_TRANSIT) {
+            for (ASN_ID id = 0; id < numASes; id++) {
+                if (counts.nextHopRoutes[id] == 0 && counts.transitRoutes[id] == 0)
+                    continue;
+
+                RouteTransit &transit = aggregate.transit[idToASN[id]];
+                transit.nextHopRoutes += counts.nextHopRoutes[id];
+                transit.transitRoutes += counts.transitRoutes[id];
+            }
+
+            for (auto &kv : counts.originNextHopRoutes)
+                aggregate.transit[kv.first].nextHopRoutes += kv.second;
+        }
+    }
+
+    return aggregates;
+}
+
+unsigned RibAggregates::ParseOutput(const std::string &name) {
+    if (name == "path_lengths")
+        return AGGREGATE_PATH_LENGTHS;
+    if (name == "origin_reach")
+        return AGGREGATE_ORIGIN_REACH;
+    if (name == "relationships")
+        return AGGREGATE_RELATIONSHIPS;
+    if (name == "transit")
+        return AGGREGATE_TRANSIT;
+    return 0;
+}
+
+/**
+ * Opens an aggregate file and writes its header
+ *
+ * @return nullptr if it cannot be opened (reason printed)
+ */
+static FILE* OpenAggregateFile(const std::string &filePath, const char *header) {
+    FILE *f = fopen(filePath.c_str(), "w");
+    if (f == nullptr) {
+        std::cout << "Could not open the aggregate file for writing: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    fputs(header, f);
+    return f;
+}
+
+/**
+ * Closes an aggregate file and adds its size to the bytes written
+ *
+ * @return false if a write or the close failed (reason printed)
+ */
+static bool CloseAggregateFile(FILE *f, const std::string &filePath, size_t &bytesWritten) {
+    const long size = ftell(f);
+    const bool written = !ferror(f) && size >= 0;
+    if (fclose(f) != 0 || !written) {
+        std::cout << "Could not write the aggregate file: " << filePath << std::endl;
+        return false;
+    }
+
+    bytesWritten += size;
+    return true;
+}
+
+bool RibAggregates::Write(const unsigned outputs, const std::string &outputFolder, const std::string &suffix, size_t &bytesWritten) const {
+    bytesWritten = 0;
+    std::string filePath;
+    FILE *f;
+
+    if (outputs & AGGREGATE_PATH_LENGTHS) {
+        filePath = outputFolder + "PathLengths" + suffix + ".tsv";
+        if ((f = OpenAggregateFile(filePath, "path_length\troutes\n")) == nullptr)
+            return false;
+
+        for (size_t length = 1; length < pathLengths.size(); length++) {
+            if (pathLengths[length] > 0)
+                fprintf(f, "%zu\t%llu\n", length, (unsigned long long) pathLengths[length]);
+        }
+        if (!CloseAggregateFile(f, filePath, bytesWritten))
+            return false;
+    }
+
+    if (outputs & AGGREGATE_ORIGIN_REACH) {
+        filePath = outputFolder + "OriginReach" + suffix + ".tsv";
+        if ((f = OpenAggregateFile(filePath, "origin\tprefix_blocks\troutes\n")) == nullptr)
+            return false;
+
+        for (auto &kv : originReach)
+            fprintf(f, "%u\t%llu\t%llu\n", kv.first, (unsigned long long) kv.second.prefixBlocks, (unsigned long long) kv.second.routes);
+        if (!CloseAggregateFile(f, filePath, bytesWritten))
+            return false;
+    }
+
+    if (outputs & AGGREGATE_RELATIONSHIPS) {
+        std::string header = "asn";
+        for (size_t r = NUM_RELATIONSHIP_PRIORITIES; r-- > 0;)
+            header += std::string("\t") + PropagationStatistics::GetRelationshipName(r);
+        filePath = outputFolder + "RouteRelationships" + suffix + ".tsv";
+        if ((f = OpenAggregateFile(filePath, (header + "\n").c_str())) == nullptr)
+            return false;
+
+        for (auto &kv : relationships) {
+            fprintf(f, "%u", kv.first);
+            for (size_t r = NUM_RELATIONSHIP_PRIORITIES; r-- > 0;)
+                fprintf(f, "\t%llu", (unsigned long long) kv.second[r]);
+            fputc('\n', f);
+        }
+        if (!CloseAggregateFile(f, filePath, bytesWritten))
+            return false;
+    }
+
+    if (outputs & AGGREGATE_TRANSIT) {
+        filePath = outputFolder + "Transit" + suffix + ".tsv";
+        if ((f = OpenAggregateFile(filePath, "asn\tnext_hop_routes\ttransit_routes\n")) == nullptr)
+            return false;
+
+        for (auto &kv : transit)
+            fprintf(f, "%u\t%llu\t%llu\n", kv.first, (unsigned long long) kv.second.nextHopRoutes, (unsigned long long) kv.second.transitRoutes);
+        if (!CloseAggregateFile(f, filePath, bytesWritten))
+            return false;
+    }
+
+    return true;
+}
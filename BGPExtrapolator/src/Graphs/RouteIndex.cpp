@@ -0,0 +1,203 @@
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "Graphs/RouteIndex.hpp"
+#include "Graphs/Graph.hpp"
+
+static inline size_t CountBits(const uint64_t word) {
+#ifdef _MSC_VER
+    return __popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+static inline size_t LowestBit(const uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+RouteIndex::RouteIndex(const Graph &graph, ThreadPool &threadPool, const std::vector<std::pair<ASN, ASN_ID>> &removedStubs)
+    : numASes(graph.GetNumASes()), numWords((graph.GetNumASes() + 63) / 64), blocks(graph.GetNumPrefixes())
+{
+    // Removed stubs by provider, counted then placed
+    stubBegin.assign(numASes + 1, 0);
+    for (auto &stub : removedStubs)
+        stubBegin[stub.second + 1]++;
+    for (size_t id = 0; id < numASes; id++)
+        stubBegin[id + 1] += stubBegin[id];
+
+    stubASNs.resize(removedStubs.size());
+    std::vector<uint32_t> position(stubBegin.begin(), stubBegin.end() - 1);
+    for (auto &stub : removedStubs)
+        stubASNs[position[stub.second]++] = stub.first;
+
+    // Blocks are independent, every thread indexes a contiguous range of them
+    threadPool.ParallelFor(0, blocks.size(), [&](size_t, size_t begin, size_t end) {
+        std::vector<uint32_t> nextHopCounts(numASes, 0);
+        for (size_t prefixBlockID = begin; prefixBlockID < end; prefixBlockID++)
+            BuildBlock(graph, prefixBlockID, nextHopCounts);
+    });
+
+    for (uint32_t prefixBlockID = 0; prefixBlockID < blocks.size(); prefixBlockID++) {
+        if (blocks[prefixBlockID].prefixString != nullptr)
+            prefixToBlocks[*blocks[prefixBlockID].prefixString].push_back(prefixBlockID);
+    }
+}
+
+void RouteIndex::BuildBlock(const Graph &graph, const uint32_t prefixBlockID, std::vector<uint32_t> &nextHopCounts) {
+    BlockIndex &block = blocks[prefixBlockID];
+    std::vector<ASN_ID> nextHopIDs;
+
+    //***** Origin sets, and how many ASes every next hop has
+    size_t lastOrigin = 0;
+    for (ASN_ID id = 0; id < numASes; id++) {
+        const AnnouncementCachedData &ann = graph.GetCachedData_ReadOnly(id, prefixBlockID);
+        if (ann.isDefaultState())
+            continue;
+
+        const AnnouncementStaticData &staticData = graph.GetStaticData_ReadOnly(ann.GetStaticDataIndex());
+        const ASN originASN = staticData.originASN;
+        block.prefixString = &staticData.prefixString;
+
+        // Neighboring ASes mostly share the origin of the last one
+        if (lastOrigin >= block.origins.size() || block.origins[lastOrigin].first != originASN) {
+            lastOrigin = 0;
+            while (lastOrigin < block.origins.size() && block.origins[lastOrigin].first != originASN)
+                lastOrigin++;
+
+            if (lastOrigin == block.origins.size()) {
+                block.origins.push_back(std::make_pair(originASN, (uint32_t) block.originWords.size()));
+                block.originWords.resize(block.originWords.size() + numWords, 0);
+            }
+        }
+        block.originWords[block.origins[lastOrigin].second + id / 64] |= ((uint64_t) 1) << (id % 64);
+
+        const ASN_ID parentID = ann.GetRecievedFromID();
+        if (parentID == id) {
+            // The origin was not in the graph (stub removal)
+            if (ann.GetPathLength() == 2)
+                block.stubNextHops.push_back(std::make_pair(originASN, id));
+            continue;
+        }
+
+        if (nextHopCounts[parentID]++ == 0)
+            nextHopIDs.push_back(parentID);
+    }
+
+    std::sort(block.origins.begin(), block.origins.end());
+
+    //***** Next hop groups, counts turned into where the next member of every group goes
+    std::sort(nextHopIDs.begin(), nextHopIDs.end());
+    block.nextHops.reserve(nextHopIDs.size());
+    uint32_t numMembers = 0;
+    for (ASN_ID nextHopID : nextHopIDs) {
+        block.nextHops.push_back(std::make_pair(nextHopID, numMembers));
+        const uint32_t count = nextHopCounts[nextHopID];
+        nextHopCounts[nextHopID] = numMembers;
+        numMembers += count;
+    }
+
+    block.nextHopMembers.resize(numMembers);
+    for (ASN_ID id = 0; id < numASes && numMembers > 0; id++) {
+        const AnnouncementCachedData &ann = graph.GetCachedData_ReadOnly(id, prefixBlockID);
+        if (ann.isDefaultState() || ann.GetRecievedFromID() == id)
+            continue;
+
+        block.nextHopMembers[nextHopCounts[ann.GetRecievedFromID()]++] = id;
+    }
+
+    for (ASN_ID nextHopID : nextHopIDs)
+        nextHopCounts[nextHopID] = 0;
+}
+
+const uint64_t* RouteIndex::GetOriginSet(const uint32_t prefixBlockID, const ASN originASN) const {
+    if (prefixBlockID >= blocks.size())
+        return nullptr;
+
+    const BlockIndex &block = blocks[prefixBlockID];
+    auto search = std::lower_bound(block.origins.begin(), block.origins.end(), std::make_pair(originASN, (uint32_t) 0));
+    if (search == block.origins.end() || search->first != originASN)
+        return nullptr;
+
+    return block.originWords.data() + search->second;
+}
+
+void RouteIndex::GetOriginMembers(const uint32_t prefixBlockID, const ASN originASN, std::vector<ASN_ID> &ids) const {
+    ids.clear();
+    const uint64_t *words = GetOriginSet(prefixBlockID, originASN);
+    if (words == nullptr)
+        return;
+
+    for (size_t word = 0; word < numWords; word++) {
+        for (uint64_t bits = words[word]; bits != 0; bits &= bits - 1)
+            ids.push_back(word * 64 + LowestBit(bits));
+    }
+}
+
+void RouteIndex::GetOrigins(const uint32_t prefixBlockID, std::vector<std::pair<ASN, size_t>> &origins) const {
+    origins.clear();
+    if (prefixBlockID >= blocks.size())
+        return;
+
+    const BlockIndex &block = blocks[prefixBlockID];
+    for (auto &origin : block.origins) {
+        size_t count = 0;
+        for (size_t word = 0; word < numWords; word++)
+            count += CountBits(block.originWords[origin.second + word]);
+        origins.push_back(std::make_pair(origin.first, count));
+    }
+}
+
+void RouteIndex::GetNextHopMembers(const uint32_t prefixBlockID, const ASN_ID nextHopID, const ASN_ID *&begin, const ASN_ID *&end) const {
+    begin = end = nullptr;
+    if (prefixBlockID >= blocks.size())
+        return;
+
+    const BlockIndex &block = blocks[prefixBlockID];
+    auto search = std::lower_bound(block.nextHops.begin(), block.nextHops.end(), std::make_pair(nextHopID, (uint32_t) 0));
+    if (search == block.nextHops.end() || search->first != nextHopID)
+        return;
+
+    begin = block.nextHopMembers.data() + search->second;
+    end = block.nextHopMembers.data() + (search + 1 == block.nextHops.end() ? block.nextHopMembers.size() : (search + 1)->second);
+}
+
+const std::vector<uint32_t>& RouteIndex::GetPrefixBlocks(const std::string &prefixString) const {
+    static const std::vector<uint32_t> none;
+
+    auto search = prefixToBlocks.find(prefixString);
+    return search == prefixToBlocks.end() ? none : search->second;
+}
+
+void RouteIndex::GetStubNextHopMembers(const uint32_t prefixBlockID, const ASN stubASN, std::vector<ASN_ID> &ids) const {
+    ids.clear();
+    if (prefixBlockID >= blocks.size())
+        return;
+
+    for (auto &stubNextHop : blocks[prefixBlockID].stubNextHops)
+        if (stubNextHop.first == stubASN)
+            ids.push_back(stubNextHop.second);
+}
+
+size_t RouteIndex::GetMemoryUsage() const {
+    size_t bytes = blocks.capacity() * sizeof(BlockIndex) + stubBegin.capacity() * sizeof(uint32_t) + stubASNs.capacity() * sizeof(ASN);
+    for (auto &block : blocks) {
+        bytes += block.origins.capacity() * sizeof(std::pair<ASN, uint32_t>) + block.originWords.capacity() * sizeof(uint64_t)
+            + block.nextHops.capacity() * sizeof(std::pair<ASN_ID, uint32_t>) + block.nextHopMembers.capacity() * sizeof(ASN_ID)
+            + block.stubNextHops.capacity() * sizeof(std::pair<ASN, ASN_ID>);
+    }
+
+    for (auto &kv : prefixToBlocks)
+        bytes += sizeof(kv) + 2 * sizeof(void*) + kv.first.capacity() + kv.second.capacity() * sizeof(uint32_t);
+
+    return bytes;
+}
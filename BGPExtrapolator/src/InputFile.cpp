@@ -0,0 +1,268 @@
+#include <string.h>
+#include <iostream>
+
+#ifdef BGPX_HAS_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef BGPX_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "InputFile.hpp"
+
+InputFile::InputFile() : file(nullptr), compression(INPUT_COMPRESSION::NONE), chunkPosition(0), endOfInput(true), chunks(QUEUED_CHUNKS), corrupt(false) {
+
+}
+
+InputFile::~InputFile() {
+    Close();
+}
+
+INPUT_COMPRESSION InputFile::DetectCompression(const std::string &filePath) {
+    unsigned char magic[4] = { 0, 0, 0, 0 };
+    FILE *f = fopen(filePath.c_str(), "rb");
+    if (f == nullptr)
+        return INPUT_COMPRESSION::NONE;
+
+    size_t numRead = fread(magic, 1, sizeof(magic), f);
+    fclose(f);
+
+    if (numRead >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        return INPUT_COMPRESSION::GZIP;
+    if (numRead == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        return INPUT_COMPRESSION::ZSTD;
+    return INPUT_COMPRESSION::NONE;
+}
+
+bool InputFile::IsSupported(const INPUT_COMPRESSION compression) {
+    switch (compression) {
+        case INPUT_COMPRESSION::GZIP:
+#ifdef BGPX_HAS_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case INPUT_COMPRESSION::ZSTD:
+#ifdef BGPX_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+bool InputFile::Open(const std::string &filePath) {
+    Close();
+
+    compression = DetectCompression(filePath);
+    if (!IsSupported(compression)) {
+        std::cout << filePath << " is " << (compression == INPUT_COMPRESSION::GZIP ? "gzip" : "zstd")
+            << " compressed, but this build cannot decompress it (the library was not found when building)" << std::endl;
+        return false;
+    }
+
+    file = fopen(filePath.c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    chunk.clear();
+    chunkPosition = 0;
+    endOfInput = false;
+    corrupt = false;
+
+    if (compression != INPUT_COMPRESSION::NONE) {
+        chunks.Reopen();
+        decompressor = std::thread(&InputFile::Decompress, this);
+    }
+
+    return true;
+}
+
+void InputFile::Close() {
+    if (decompressor.joinable()) {
+        // A decompressor waiting on a full queue gives up
+        chunks.Close();
+        decompressor.join();
+    }
+
+    if (file != nullptr) {
+        fclose(file);
+        file = nullptr;
+    }
+
+    chunk.clear();
+    chunkPosition = 0;
+    endOfInput = true;
+}
+
+bool InputFile::NextChunk() {
+    chunkPosition = 0;
+
+    if (compression == INPUT_COMPRESSION::NONE) {
+        chunk.resize(CHUNK_BYTES);
+        size_t numRead = fread(chunk.data(), 1, CHUNK_BYTES, file);
+        chunk.resize(numRead);
+        return numRead > 0;
+    }
+
+    if (!chunks.Pop(chunk)) {
+        chunk.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool InputFile::ReadLine(std::string &line) {
+    line.clear();
+    if (endOfInput)
+        return false;
+
+    bool readAnything = false;
+    while (true) {
+        if (chunkPosition >= chunk.size() && !NextChunk()) {
+            endOfInput = true;
+            break;
+        }
+
+        readAnything = true;
+        const char *begin = chunk.data() + chunkPosition;
+        const char *newline = (const char*) memchr(begin, '\n', chunk.size() - chunkPosition);
+        if (newline == nullptr) {
+            line.append(begin, chunk.size() - chunkPosition);
+            chunkPosition = chunk.size();
+            continue;
+        }
+
+        line.append(begin, newline - begin);
+        chunkPosition += newline - begin + 1;
+        break;
+    }
+
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+    return readAnything;
+}
+
+void InputFile::Decompress() {
+    if (compression == INPUT_COMPRESSION::GZIP)
+        DecompressGzip();
+    else if (compression == INPUT_COMPRESSION::ZSTD)
+        DecompressZstd();
+
+    chunks.Close();
+}
+
+void InputFile::DecompressGzip() {
+#ifdef BGPX_HAS_ZLIB
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 32: gzip (or zlib) header detected automatically
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        corrupt = true;
+        return;
+    }
+
+    std::vector<unsigned char> input(CHUNK_BYTES);
+    std::vector<char> output(CHUNK_BYTES);
+    stream.next_out = (Bytef*) output.data();
+    stream.avail_out = output.size();
+
+    // Whether the input so far ends at the end of a member, so running out of input is only fine then
+    bool memberEnded = false;
+    while (true) {
+        if (stream.avail_in == 0) {
+            stream.avail_in = fread(input.data(), 1, input.size(), file);
+            stream.next_in = input.data();
+            if (stream.avail_in == 0) {
+                if (!memberEnded)
+                    corrupt = true;
+                break;
+            }
+        }
+
+        int result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            // Concatenated members (as written by pigz, or by appending gzip files) are one stream
+            memberEnded = true;
+            inflateReset(&stream);
+        } else if (result == Z_OK || result == Z_BUF_ERROR) {
+            memberEnded = false;
+        } else {
+            corrupt = true;
+            break;
+        }
+
+        if (stream.avail_out == 0) {
+            if (!chunks.Push(std::move(output)))
+                break;
+
+            output.assign(CHUNK_BYTES, 0);
+            stream.next_out = (Bytef*) output.data();
+            stream.avail_out = output.size();
+        }
+    }
+
+    output.resize(output.size() - stream.avail_out);
+    if (!output.empty())
+        chunks.Push(std::move(output));
+
+    inflateEnd(&stream);
+#endif
+}
+
+void InputFile::DecompressZstd() {
+#ifdef BGPX_HAS_ZSTD
+    ZSTD_DStream *stream = ZSTD_createDStream();
+    if (stream == nullptr) {
+        corrupt = true;
+        return;
+    }
+    ZSTD_initDStream(stream);
+
+    std::vector<char> input(ZSTD_DStreamInSize());
+    ZSTD_inBuffer in = { input.data(), 0, 0 };
+    std::vector<char> output(CHUNK_BYTES);
+    ZSTD_outBuffer out = { output.data(), output.size(), 0 };
+
+    // 0 once a frame has been fully decoded, so running out of input is only fine then
+    size_t remaining = 0;
+    while (true) {
+        if (in.pos == in.size) {
+            in.size = fread(input.data(), 1, input.size(), file);
+            in.pos = 0;
+            if (in.size == 0) {
+                if (remaining != 0)
+                    corrupt = true;
+                break;
+            }
+        }
+
+        remaining = ZSTD_decompressStream(stream, &out, &in);
+        if (ZSTD_isError(remaining)) {
+            corrupt = true;
+            break;
+        }
+
+        if (out.pos == out.size) {
+            if (!chunks.Push(std::move(output)))
+                break;
+
+            output.assign(CHUNK_BYTES, 0);
+            out.dst = output.data();
+            out.size = output.size();
+            out.pos = 0;
+        }
+    }
+
+    output.resize(out.pos);
+    if (!output.empty())
+        chunks.Push(std::move(output));
+
+    ZSTD_freeDStream(stream);
+#endif
+}
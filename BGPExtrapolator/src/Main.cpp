@@ -1,8 +1,15 @@
 ﻿#include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
 #include "Graphs/Graph.hpp"
 #include "Testing.hpp"
+#include "RunReport.hpp"
+#include "TraceRecorder.hpp"
+#include "MemoryPlanner.hpp"
+#include "ExperimentServer.hpp"
+#include "ShardCoordinator.hpp"
+#include "BlockPipeline.hpp"
 
 #include <chrono>
+#include <numeric>
 
 const char pathSeparator =
 #ifdef _WIN32
@@ -11,103 +18,182 @@ const char pathSeparator =
     '/';
 #endif
 
+// argv[0], to start worker processes with where the executable cannot be looked up
+std::string executableName = "BGPExtrapolator";
+
 void Usage(bool incorrect) {
     if (incorrect)
         std::cout << "Incorrect usage, please see the correct options below." << std::endl;
     std::cout << "Usage: " << std::endl;
     std::cout << "  --help: prints the usage of the Extrapolator" << std::endl;
     std::cout << "  --config <filename>: accepts a launch configuration and performs the experiment" << std::endl;
+    std::cout << "  --serve <filename>: loads the graph of a launch configuration once and runs the experiments requested on stdin (or server_socket)" << std::endl;
+}
+
+/**
+ * Counters and cells of a profile entry, with the per cell figures (cycles per compared cell, etc.)
+ */
+nlohmann::json ProfileEntryToJSON(const PropagationProfileEntry &entry) {
+    nlohmann::json json;
+    json["cells_compared"] = entry.cellsCompared;
+    json["cells_replaced"] = entry.cellsReplaced;
+
+    for (size_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+        std::string name = PerfCounters::GetName((PERF_COUNTER) i);
+        json[name] = entry.counters[i];
+        json[name + "_per_cell"] = entry.cellsCompared > 0 ? (double) entry.counters[i] / entry.cellsCompared : 0;
+    }
+
+    json["instructions_per_cycle"] = entry.counters[PERF_COUNTER_CYCLES] > 0 ?
+        (double) entry.counters[PERF_COUNTER_INSTRUCTIONS] / entry.counters[PERF_COUNTER_CYCLES] : 0;
+
+    return json;
+}
+
+/**
+ * Kernel decisions by rule, and replacements by relationship (only the non zero ones)
+ */
+nlohmann::json StatisticsToJSON(const PropagationStatistics &statistics) {
+    nlohmann::json json;
+    for (size_t i = 0; i < COMPARISON_RULE_COUNT; i++) {
+        if (statistics.comparisons[i] == 0)
+            continue;
+
+        std::string name = PropagationStatistics::GetComparisonRuleName((COMPARISON_RULE) i);
+        json["comparisons"][name]["decided"] = statistics.comparisons[i];
+        json["comparisons"][name]["replaced"] = statistics.comparisonReplacements[i];
+    }
+
+    for (size_t i = 0; i < NUM_RELATIONSHIP_PRIORITIES; i++) {
+        if (statistics.relationshipReplacements[i] > 0)
+            json["replaced_by_relationship"][PropagationStatistics::GetRelationshipName(i)] = statistics.relationshipReplacements[i];
+    }
+
+    for (size_t i = 0; i < SEEDING_RULE_COUNT; i++) {
+        if (statistics.seedingDecisions[i] == 0)
+            continue;
+
+        std::string name = PropagationStatistics::GetSeedingRuleName((SEEDING_RULE) i);
+        json["seeding"][name]["decided"] = statistics.seedingDecisions[i];
+        json["seeding"][name]["replaced"] = statistics.seedingReplacements[i];
+    }
+
+    return json;
 }
 
-void RunExperimentFromConfig(const std::string &launchJSONPath) {
+/**
+ * Reads a provider_preferences object: customer ASN -> list of the provider ASNs it may propagate up to
+ *
+ * @return false if it is not such an object
+ */
+bool ParseProviderPreferences(const nlohmann::json &json, std::unordered_map<ASN, std::vector<ASN>> &customerToProviderPreferences) {
+    if (!json.is_object())
+        return false;
+
+    for (auto it : json.items())
+    {
+        if (!it.value().is_array())
+            return false;
+
+        ASN customer = std::stoi(it.key());
+        customerToProviderPreferences.insert( { customer, it.value().get<std::vector<ASN>>() } );
+    }
+
+    return true;
+}
+
+/**
+ * Runs the experiment of a launch configuration, see DefaultLaunch.json
+ *
+ * @return false if the configuration is invalid, the run is refused (memory limit) or fails
+ */
+bool RunExperimentFromConfig(const std::string &launchJSONPath) {
     std::ifstream launchFile(launchJSONPath);
     nlohmann::json launchJSON = nlohmann::json::parse(launchFile, nullptr, true, true);
 
     // File Locations
-    auto rel_search = launchJSON.find("relationships_file");
-    if (rel_search == launchJSON.end()) {
-        std::cout << "Expected path to relationships TSV file!" << std::endl;
-        return;
-    }
-
     auto output_search = launchJSON.find("output_folder");
     if (output_search == launchJSON.end()) {
         std::cout << "Expected path to output TSV file!" << std::endl;
-        return;
+        return false;
+    }
+
+    // Start from the checkpoint of a previous run rather than the relationships and announcements.
+    // If a diff is also given, only the changed announcements are applied (delta mode). Otherwise the results are written straight from the checkpoint
+    std::string previousStateFilePath, announcementsDiffFilePath;
+    auto previous_state_search = launchJSON.find("previous_state_file");
+    if (previous_state_search != launchJSON.end()) {
+        previousStateFilePath = previous_state_search.value();
+
+        auto diff_search = launchJSON.find("announcements_diff_file");
+        if (diff_search != launchJSON.end())
+            announcementsDiffFilePath = diff_search.value();
+    }
+
+    bool fromCheckpoint = !previousStateFilePath.empty();
+
+    // Only the topology of the checkpoint is used and the announcements file is seeded on it (how the workers of a sharded run start)
+    bool checkpointTopologyOnly = false;
+    auto checkpoint_topology_only_search = launchJSON.find("checkpoint_topology_only");
+    if (checkpoint_topology_only_search != launchJSON.end()) {
+        if (checkpoint_topology_only_search.value().is_boolean()) {
+            checkpointTopologyOnly = checkpoint_topology_only_search.value().get<bool>();
+        } else {
+            std::cout << "Expected a boolean for using only the topology of the checkpoint!" << std::endl;
+            return false;
+        }
+    }
+
+    bool seedingFromFile = !fromCheckpoint || checkpointTopologyOnly;
+
+    auto rel_search = launchJSON.find("relationships_file");
+    if (rel_search == launchJSON.end() && !fromCheckpoint) {
+        std::cout << "Expected path to relationships TSV file!" << std::endl;
+        return false;
     }
 
     auto announcements_search = launchJSON.find("announcements_file");
-    if (announcements_search == launchJSON.end()) {
+    if (announcements_search == launchJSON.end() && seedingFromFile) {
         std::cout << "Expected path to output TSV file!" << std::endl;
-        return;
+        return false;
     }
 
-    std::string relationshipsFilePath = rel_search.value();
+    std::string stateOutputFilePath, seedingStateOutputFilePath;
+    auto state_output_search = launchJSON.find("state_output_file");
+    if (state_output_search != launchJSON.end())
+        stateOutputFilePath = state_output_search.value();
+
+    auto seeding_state_output_search = launchJSON.find("seeding_state_output_file");
+    if (seeding_state_output_search != launchJSON.end())
+        seedingStateOutputFilePath = seeding_state_output_search.value();
+
+    std::string relationshipsFilePath = fromCheckpoint ? "" : rel_search.value();
     std::string outputFilePath = output_search.value();
-    std::string announcementsFilePath = announcements_search.value();
+    std::string announcementsFilePath = seedingFromFile ? announcements_search.value() : "";
 
     if (outputFilePath == "") {
         std::cout << "Output Folder cannot be an empty string!" << std::endl;
-        return;
+        return false;
     } else if (outputFilePath.back() != pathSeparator) {
         outputFilePath += pathSeparator;
     }
 
-    if (relationshipsFilePath == "") {
+    if (relationshipsFilePath == "" && !fromCheckpoint) {
         std::cout << "Relationships file path cannot be an empty string!" << std::endl;
-        return;
+        return false;
     }
 
-    if (announcementsFilePath == "") {
+    if (announcementsFilePath == "" && seedingFromFile) {
         std::cout << "Announcements file path cannot be an empty string!" << std::endl;
-        return;
+        return false;
     }
 
     // Seeding Options
     SeedingConfiguration config;
-
-    auto origin_only_search = launchJSON.find("seeding_origin_only");
-    if (origin_only_search == launchJSON.end()) {
-        config.originOnly = false;
-    } else {
-        if(!origin_only_search.value().is_boolean()) {
-            std::cout << "Expected boolean value for origin only!" << std::endl;
-            return;
-        }
-
-        config.originOnly = origin_only_search.value().get<bool>();
-    }
-
-    auto tiebraking_search = launchJSON.find("seeding_tiebraking_method");
-    if (tiebraking_search == launchJSON.end()) {
-        config.tiebrakingMethod = TIEBRAKING_METHOD::PREFER_LOWEST_ASN;
-    } else {
-        std::string method = tiebraking_search.value();
-        if (method == "prefer_lowest_asn") {
-            config.tiebrakingMethod = TIEBRAKING_METHOD::PREFER_LOWEST_ASN;
-        } else if (method == "random") {
-            config.tiebrakingMethod = TIEBRAKING_METHOD::RANDOM;
-        } else {
-            std::cout << "Unknown tiebraking method!" << std::endl;
-            return;
-        }
-    }
-
-    auto timestamp_search = launchJSON.find("propagation_timestamp_comparison_method");
-    if (timestamp_search == launchJSON.end()) {
-        config.timestampComparison = TIMESTAMP_COMPARISON::PREFER_NEWER;
-    } else {
-        std::string method = timestamp_search.value();
-        if (method == "prefer_newer") {
-            config.timestampComparison = TIMESTAMP_COMPARISON::PREFER_NEWER;
-        } else if (method == "prefer_older") {
-            config.timestampComparison = TIMESTAMP_COMPARISON::PREFER_OLDER;
-        } else if (method == "disabled") {
-            config.timestampComparison = TIMESTAMP_COMPARISON::DISABLED;
-        } else {
-            std::cout << "Unknown Timestamp comparison method!" << std::endl;
-            return;
-        }
+    std::string seedingError;
+    if (!SeedingConfiguration::FromJSON(launchJSON, config, seedingError)) {
+        std::cout << seedingError << std::endl;
+        return false;
     }
 
     bool stubRemoval = false;
@@ -117,7 +203,7 @@ void RunExperimentFromConfig(const std::string &launchJSONPath) {
             stubRemoval = stubRemovalSearch.value().get<bool>();
         } else {
             std::cout << "Unknown value for stub removal" << std::endl;
-            return;
+            return false;
         }
     }
     
@@ -128,25 +214,83 @@ void RunExperimentFromConfig(const std::string &launchJSONPath) {
             controlPlaneASNs = control_plane_trace_ASNs_search.value().get<std::vector<ASN>>();
         } else {
             std::cout << "Expected list of ASNs for control plane traceback!" << std::endl;
-            return;
+            return false;
         }
     }
 
+    ResultsFilter resultsFilter;
+    std::string resultsFilterError;
+    if (!ResultsFilter::FromJSON(launchJSON, resultsFilter, resultsFilterError)) {
+        std::cout << resultsFilterError << std::endl;
+        return false;
+    }
+
     std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences;
     auto provider_preferences_search = launchJSON.find("provider_preferences");
-    if (provider_preferences_search != launchJSON.end()) {
-        if (provider_preferences_search.value().is_object()) {
-            for (auto it : provider_preferences_search->items())
-            {
-                ASN customer = std::stoi(it.key());
-                customerToProviderPreferences.insert( { customer, it.value().get<std::vector<ASN>>() } );
+    if (provider_preferences_search != launchJSON.end() && !ParseProviderPreferences(provider_preferences_search.value(), customerToProviderPreferences)) {
+        std::cout << "Expected an object of provider_preferences!" << std::endl;
+        return false;
+    }
+
+    // Configurations evaluated side by side in a single propagation (lanes). Each one starts from the seeding options and provider
+    // preferences above and overrides what it gives. Results go to Results_<name>.tsv
+    std::vector<LaneConfiguration> lanes;
+    std::vector<std::string> laneNames;
+    auto configurations_search = launchJSON.find("configurations");
+    if (configurations_search != launchJSON.end()) {
+        if (!configurations_search.value().is_array() || configurations_search.value().empty()) {
+            std::cout << "Expected a list of configurations!" << std::endl;
+            return false;
+        }
+
+        for (auto &configurationJSON : configurations_search.value()) {
+            if (!configurationJSON.is_object()) {
+                std::cout << "Expected an object for every configuration!" << std::endl;
+                return false;
             }
-        } else {
-            std::cout << "Expected an object of provider_preferences!" << std::endl;
-            return;
+
+            LaneConfiguration lane;
+            lane.seeding = config;
+            if (!SeedingConfiguration::FromJSON(configurationJSON, lane.seeding, seedingError)) {
+                std::cout << seedingError << std::endl;
+                return false;
+            }
+
+            lane.customerToProviderPreferences = customerToProviderPreferences;
+            auto lane_preferences_search = configurationJSON.find("provider_preferences");
+            if (lane_preferences_search != configurationJSON.end()) {
+                lane.customerToProviderPreferences.clear();
+                if (!ParseProviderPreferences(lane_preferences_search.value(), lane.customerToProviderPreferences)) {
+                    std::cout << "Expected an object of provider_preferences!" << std::endl;
+                    return false;
+                }
+            }
+
+            auto name_search = configurationJSON.find("name");
+            if (name_search != configurationJSON.end() && name_search.value().is_string())
+                laneNames.push_back(name_search.value().get<std::string>());
+            else
+                laneNames.push_back(std::to_string(lanes.size()));
+
+            lanes.push_back(lane);
+        }
+
+        if (!seedingFromFile || !stateOutputFilePath.empty() || !seedingStateOutputFilePath.empty()) {
+            std::cout << "Configurations cannot be combined with checkpoints!" << std::endl;
+            return false;
         }
     }
 
+    // One results file, or one per configuration
+    auto resultsFilePaths = [&](const std::string &name) {
+        std::vector<std::string> paths;
+        if (lanes.empty())
+            paths.push_back(outputFilePath + name + ".tsv");
+        for (auto &laneName : laneNames)
+            paths.push_back(outputFilePath + name + "_" + laneName + ".tsv");
+        return paths;
+    };
+
     bool dump_after_seeding = false;
     auto dump_after_seeding_search = launchJSON.find("write_results_after_seeding");
     if (dump_after_seeding_search != launchJSON.end()) {
@@ -154,44 +298,673 @@ void RunExperimentFromConfig(const std::string &launchJSONPath) {
             dump_after_seeding = dump_after_seeding_search.value().get<bool>();
         } else {
             std::cout << "Expected a boolean for dump after seeding!" << std::endl;
-            return;
+            return false;
+        }
+    }
+
+    size_t numThreads = 1;
+    auto num_threads_search = launchJSON.find("num_threads");
+    if (num_threads_search != launchJSON.end()) {
+        if (num_threads_search.value().is_number_unsigned()) {
+            numThreads = num_threads_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive integer for the number of threads!" << std::endl;
+            return false;
+        }
+    }
+
+    std::string ribBackingFilePath = "";
+    auto rib_backing_file_search = launchJSON.find("rib_backing_file");
+    if (rib_backing_file_search != launchJSON.end()) {
+        if (rib_backing_file_search.value().is_string()) {
+            ribBackingFilePath = rib_backing_file_search.value().get<std::string>();
+        } else {
+            std::cout << "Expected a file path for the local rib backing file!" << std::endl;
+            return false;
+        }
+    }
+
+    size_t ribTileMemory = 256 * 1024 * 1024;
+    auto rib_tile_memory_search = launchJSON.find("rib_tile_memory");
+    if (rib_tile_memory_search != launchJSON.end()) {
+        if (rib_tile_memory_search.value().is_number_unsigned()) {
+            ribTileMemory = rib_tile_memory_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive number of bytes for the local rib tile memory!" << std::endl;
+            return false;
+        }
+    }
+
+    bool numaPlacement = false;
+    auto numa_placement_search = launchJSON.find("numa_placement");
+    if (numa_placement_search != launchJSON.end()) {
+        if (numa_placement_search.value().is_boolean()) {
+            numaPlacement = numa_placement_search.value().get<bool>();
+        } else {
+            std::cout << "Expected a boolean for NUMA placement!" << std::endl;
+            return false;
+        }
+    }
+
+    bool profileHardwareCounters = false;
+    auto profile_search = launchJSON.find("profile_hardware_counters");
+    if (profile_search != launchJSON.end()) {
+        if (profile_search.value().is_boolean()) {
+            profileHardwareCounters = profile_search.value().get<bool>();
+        } else {
+            std::cout << "Expected a boolean for hardware counter profiling!" << std::endl;
+            return false;
+        }
+    }
+
+    size_t memoryLimit = 0;
+    auto memory_limit_search = launchJSON.find("memory_limit");
+    if (memory_limit_search != launchJSON.end()) {
+        if (memory_limit_search.value().is_number_unsigned()) {
+            memoryLimit = memory_limit_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive number of bytes for the memory limit!" << std::endl;
+            return false;
+        }
+    }
+
+    size_t workerProcesses = 1;
+    auto worker_processes_search = launchJSON.find("worker_processes");
+    if (worker_processes_search != launchJSON.end()) {
+        if (worker_processes_search.value().is_number_unsigned() && worker_processes_search.value().get<size_t>() > 0) {
+            workerProcesses = worker_processes_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive number of worker processes!" << std::endl;
+            return false;
+        }
+    }
+
+    // The shard results only add up to the results of the run, a checkpoint of the whole run is never in one process
+    if (workerProcesses > 1 && (fromCheckpoint || !stateOutputFilePath.empty() || !seedingStateOutputFilePath.empty())) {
+        std::cout << "Worker processes cannot be combined with checkpoints!" << std::endl;
+        return false;
+    }
+
+    size_t pipelineBatchRows = 0;
+    auto pipeline_batch_rows_search = launchJSON.find("pipeline_batch_rows");
+    if (pipeline_batch_rows_search != launchJSON.end()) {
+        if (pipeline_batch_rows_search.value().is_number_unsigned()) {
+            pipelineBatchRows = pipeline_batch_rows_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive number of rows for the pipeline batches!" << std::endl;
+            return false;
+        }
+    }
+
+    // Batches are written as soon as they are propagated, there is never a state of every block to checkpoint or dump after seeding
+    if (pipelineBatchRows > 0 && (!seedingFromFile || !stateOutputFilePath.empty() || !seedingStateOutputFilePath.empty() || dump_after_seeding)) {
+        std::cout << "Pipelined batches cannot be combined with checkpoints or writing the results after seeding!" << std::endl;
+        return false;
+    }
+
+    // Aggregates of the routes written instead of the routes themselves
+    unsigned aggregateOutputs = 0;
+    auto aggregate_outputs_search = launchJSON.find("aggregate_outputs");
+    if (aggregate_outputs_search != launchJSON.end()) {
+        if (!aggregate_outputs_search.value().is_array()) {
+            std::cout << "Expected a list of aggregate outputs!" << std::endl;
+            return false;
+        }
+
+        for (auto &output : aggregate_outputs_search.value()) {
+            unsigned flag = output.is_string() ? RibAggregates::ParseOutput(output.get<std::string>()) : 0;
+            if (flag == 0) {
+                std::cout << "Unknown aggregate output!" << std::endl;
+                return false;
+            }
+
+            aggregateOutputs |= flag;
+        }
+    }
+
+    if (aggregateOutputs != 0 && (workerProcesses > 1 || pipelineBatchRows > 0)) {
+        std::cout << "Aggregate outputs cannot be combined with worker processes or pipelined batches!" << std::endl;
+        return false;
+    }
+
+    if (aggregateOutputs != 0 && !resultsFilter.IsEmpty()) {
+        std::cout << "Aggregate outputs cannot be combined with results filters!" << std::endl;
+        return false;
+    }
+
+    std::string traceFilePath = "";
+    auto trace_file_search = launchJSON.find("trace_file");
+    if (trace_file_search != launchJSON.end()) {
+        if (trace_file_search.value().is_string()) {
+            traceFilePath = trace_file_search.value().get<std::string>();
+        } else {
+            std::cout << "Expected a file path for the trace file!" << std::endl;
+            return false;
         }
     }
 
     launchFile.close();
 
-    Graph g(relationshipsFilePath, customerToProviderPreferences, stubRemoval);
+#ifdef BGPX_TRACE
+    if (!traceFilePath.empty())
+        TraceRecorder::Get().Enable();
+#else
+    if (!traceFilePath.empty())
+        std::cout << "Tracing is not compiled in (build with the BGPX_TRACE option), no trace will be written" << std::endl;
+#endif
 
-    std::cout << "Seeding!" << std::endl;
+    RunReport report;
+    Stopwatch stopwatch;
+    double milliseconds;
 
-    auto t1 = std::chrono::high_resolution_clock::now();
-    g.SeedBlock(announcementsFilePath, config);
-    auto t2 = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<Graph> graph;
+    if (fromCheckpoint) {
+        // Stub removal and provider preferences come from the checkpoint
+        BGPX_TRACE_BEGIN(loadSpan, "checkpoint_load", "phase");
+        graph = Graph::LoadCheckpoint(previousStateFilePath);
+        BGPX_TRACE_END(loadSpan);
+        if (!graph)
+            return false;
 
-    auto time = std::chrono::duration_cast<std::chrono::seconds>(t2 - t1);
-    std::cout << "Seeding Time: " << time.count() << std::endl;
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("checkpoint_load", milliseconds);
+        std::cout << "Checkpoint Load Time: " << milliseconds << "ms" << std::endl;
+    } else {
+        BGPX_TRACE_BEGIN(loadSpan, "graph_load", "phase");
+        graph.reset(new Graph(relationshipsFilePath, customerToProviderPreferences, stubRemoval, numThreads));
+        BGPX_TRACE_END(loadSpan);
 
-    if (dump_after_seeding) {
-        t1 = std::chrono::high_resolution_clock::now();
-        g.GenerateTracebackResultsCSV(outputFilePath + "Results_Seeding.tsv", controlPlaneASNs);
-        t2 = std::chrono::high_resolution_clock::now();
-        
-        std::cout << "Writing Time: " << time.count() << "s" << std::endl;
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("graph_load", milliseconds);
+        std::cout << "Graph Load Time: " << milliseconds << "ms" << std::endl;
+
+        if (graph->GetNumASes() == 0) {
+            std::cout << "No ASes in the relationships file!" << std::endl;
+            return false;
+        }
+    }
+
+    Graph &g = *graph;
+
+    if (workerProcesses > 1) {
+        std::cout << "Running " << workerProcesses << " prefix block shards in worker processes!" << std::endl;
+
+        stopwatch.Restart();
+        LocalProcessTransport transport(LocalProcessTransport::GetCurrentExecutablePath(executableName));
+        ShardCoordinator coordinator(transport);
+        bool ok = coordinator.Run(launchJSON, g, announcementsFilePath, outputFilePath, workerProcesses, report);
+
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("sharded_run", milliseconds);
+        report["graph"]["num_ases"] = g.GetNumASes();
+        report["graph"]["num_worker_processes"] = workerProcesses;
+        report["memory"]["peak_rss_bytes"] = RunReport::GetPeakRSSBytes();
+        report.Write(outputFilePath + "RunReport.json");
+
+        if (ok)
+            std::cout << "Sharded Run Time: " << milliseconds << "ms" << std::endl;
+        else
+            std::cout << "The sharded run failed!" << std::endl;
+        return ok;
+    }
+
+    g.SetNumThreads(numThreads);
+    if (!ribBackingFilePath.empty())
+        g.SetRibBacking(ribBackingFilePath, ribTileMemory);
+    if (numaPlacement)
+        g.SetNumaPlacement(true);
+    if (profileHardwareCounters && !g.SetProfiling(true))
+        std::cout << "Could not open the hardware counters (is perf_event_paranoid above 2?), only cells will be counted" << std::endl;
+    if (!stateOutputFilePath.empty() || !seedingStateOutputFilePath.empty())
+        g.SetRetainSeededPaths(true);
+
+    bool propagated = false;
+    if (!seedingFromFile) {
+        if (!announcementsDiffFilePath.empty()) {
+            std::cout << "Applying announcements delta!" << std::endl;
+
+            stopwatch.Restart();
+            BGPX_TRACE_BEGIN(deltaSpan, "delta", "phase");
+            if (!g.ApplyAnnouncementsDelta(announcementsDiffFilePath, config))
+                return false;
+            BGPX_TRACE_END(deltaSpan);
+
+            milliseconds = stopwatch.ElapsedMilliseconds();
+            report.AddTiming("delta", milliseconds);
+            std::cout << "Delta Time: " << milliseconds << "ms" << std::endl;
+            propagated = true;
+        }
+    } else {
+        // Plan the memory before seeding allocates anything big, and refuse the run rather than running out of memory part way
+        AnnouncementsScan scan;
+        if (!MemoryPlanner::ScanAnnouncements(announcementsFilePath, scan)) {
+            std::cout << "Could not read the announcements file: " << announcementsFilePath << std::endl;
+            return false;
+        }
+
+        MemoryPlan plan = MemoryPlanner::Plan(g, scan, memoryLimit, numThreads, !stateOutputFilePath.empty() || !seedingStateOutputFilePath.empty(),
+            !ribBackingFilePath.empty(), ribTileMemory, controlPlaneASNs.size(), std::max(lanes.size(), (size_t) 1), numaPlacement ? 0 : pipelineBatchRows);
+
+        nlohmann::json &planSection = report["memory_plan"];
+        planSection["memory_limit"] = memoryLimit;
+        planSection["graph_bytes"] = plan.graphBytes;
+        planSection["announcements_document_bytes"] = plan.documentBytes;
+        planSection["pipeline_batches_bytes"] = plan.batchBytes;
+        planSection["static_data_bytes"] = plan.staticDataBytes;
+        planSection["seeded_path_bytes"] = plan.seededPathBytes;
+        planSection["local_ribs_bytes"] = plan.ribBytes;
+        planSection["resident_local_ribs_bytes"] = plan.residentRibBytes;
+        planSection["peer_staging_bytes"] = plan.peerStagingBytes;
+        planSection["output_bytes"] = plan.outputBytes;
+        planSection["seeding_peak_bytes"] = plan.seedingPeakBytes;
+        planSection["propagation_peak_bytes"] = plan.propagationPeakBytes;
+        planSection["fits"] = plan.fits;
+        planSection["out_of_core"] = plan.useFileBacking;
+        planSection["tile_memory_bytes"] = plan.tileMemoryBytes;
+        planSection["pipeline_batch_rows"] = plan.pipelineBatchRows;
+        planSection["num_threads"] = plan.numThreads;
+
+        // The local ribs and announcements in memory at once: a tile budget out of core, two batches of ribs and the batches in flight pipelined
+        std::cout << "Planned Peak Memory: " << plan.peakBytes / (1024 * 1024) << "MB (local ribs " << plan.residentRibBytes / (1024 * 1024) << "MB";
+        if (plan.useFileBacking)
+            std::cout << " resident of " << plan.ribBytes / (1024 * 1024) << "MB out of core";
+        if (plan.pipelineBatchRows > 0)
+            std::cout << " for two batches, announcements " << plan.batchBytes / (1024 * 1024) << "MB in flight)" << std::endl;
+        else
+            std::cout << ", announcements " << plan.documentBytes / (1024 * 1024) << "MB while seeding)" << std::endl;
+
+        if (!plan.fits) {
+            std::cout << "The run does not fit in the memory limit of " << memoryLimit / (1024 * 1024) << "MB in any layout, refusing to run" << std::endl;
+            report.Write(outputFilePath + "RunReport.json");
+            return false;
+        }
+
+        if (plan.useFileBacking && ribBackingFilePath.empty()) {
+            ribBackingFilePath = outputFilePath + "LocalRibs.scratch";
+            std::cout << "Local ribs do not fit in memory, keeping them out of core in " << ribBackingFilePath << ", "
+                << plan.tileMemoryBytes / (1024 * 1024) << "MB per tile" << std::endl;
+        }
+
+        if (plan.pipelineBatchRows > 0 && plan.pipelineBatchRows != pipelineBatchRows) {
+            std::cout << "Using pipelined batches of " << plan.pipelineBatchRows << " rows to fit in the memory limit" << std::endl;
+            pipelineBatchRows = plan.pipelineBatchRows;
+        }
+
+        if (plan.numThreads != g.GetNumThreads()) {
+            std::cout << "Using " << plan.numThreads << " threads to fit in the memory limit" << std::endl;
+            g.SetNumThreads(plan.numThreads);
+        }
+
+        if (plan.useFileBacking)
+            g.SetRibBacking(ribBackingFilePath, plan.tileMemoryBytes);
+
+        if (pipelineBatchRows > 0 && (!ribBackingFilePath.empty() || numaPlacement)) {
+            std::cout << "Pipelined batches need their local ribs in memory (no file backing or NUMA placement), running the blocks all at once" << std::endl;
+            pipelineBatchRows = 0;
+        }
+
+        if (pipelineBatchRows > 0) {
+            std::cout << "Seeding, propagating and writing in pipelined batches of " << pipelineBatchRows << " rows!" << std::endl;
+
+            stopwatch.Restart();
+            BlockPipeline pipeline(g, pipelineBatchRows);
+            std::vector<size_t> laneBytesWritten;
+            bool ok = pipeline.Run(announcementsFilePath, config, lanes, resultsFilePaths("Results"), controlPlaneASNs, resultsFilter, laneBytesWritten);
+            size_t bytesWritten = std::accumulate(laneBytesWritten.begin(), laneBytesWritten.end(), (size_t) 0);
+
+            milliseconds = stopwatch.ElapsedMilliseconds();
+            const PipelineTimings &pipelineTimings = pipeline.GetTimings();
+            report.AddTiming("pipeline", milliseconds);
+            report.AddTiming("pipeline_plan", pipelineTimings.planMilliseconds);
+            report.AddTiming("parse", pipelineTimings.parseMilliseconds);
+            report.AddTiming("seeding", pipelineTimings.seedingMilliseconds);
+            report.AddTiming("propagation", pipelineTimings.propagationMilliseconds);
+            report.AddTiming("results_write", pipelineTimings.writeMilliseconds);
+            report.AddTiming("parse_stall", pipelineTimings.parseStallMilliseconds);
+            report.AddTiming("write_stall", pipelineTimings.writeStallMilliseconds);
+
+            const PropagationTimings &timings = pipeline.GetPropagationTimings();
+            report["propagation"]["up_ms"] = timings.upMilliseconds;
+            report["propagation"]["peers_ms"] = timings.peersMilliseconds;
+            report["propagation"]["down_ms"] = timings.downMilliseconds;
+            report["propagation"]["up_rank_ms"] = timings.upRankMilliseconds;
+            report["propagation"]["down_rank_ms"] = timings.downRankMilliseconds;
+
+            report["pipeline"]["batch_rows"] = pipelineBatchRows;
+            report["pipeline"]["num_batches"] = pipeline.GetNumBatches();
+            report["throughput"]["seeding_rows"] = pipeline.GetNumRows();
+            report["throughput"]["results_bytes_written"] = bytesWritten;
+            report["throughput"]["results_bytes_written_per_second"] = milliseconds > 0 ? bytesWritten / (milliseconds / 1000) : 0;
+            report["graph"]["num_ases"] = g.GetNumASes();
+            report["graph"]["num_threads"] = g.GetNumThreads();
+            report["graph"]["num_lanes"] = g.GetNumLanes();
+            report["memory"]["peak_rss_bytes"] = RunReport::GetPeakRSSBytes();
+            report.Write(outputFilePath + "RunReport.json");
+
+#ifdef BGPX_TRACE
+            if (!traceFilePath.empty()) {
+                TraceRecorder::Get().Disable();
+                if (!TraceRecorder::Get().Write(traceFilePath))
+                    std::cout << "Could not write the trace file: " << traceFilePath << std::endl;
+            }
+#endif
+
+            if (ok)
+                std::cout << "Pipelined Run Time: " << milliseconds << "ms (parse " << pipelineTimings.parseMilliseconds << "ms, seeding "
+                    << pipelineTimings.seedingMilliseconds << "ms, propagation " << pipelineTimings.propagationMilliseconds << "ms, writing "
+                    << pipelineTimings.writeMilliseconds << "ms)" << std::endl;
+            else
+                std::cout << "The pipelined run failed!" << std::endl;
+            return ok;
+        }
+
+        if (!lanes.empty())
+            std::cout << "Evaluating " << lanes.size() << " configurations side by side" << std::endl;
+
+        std::cout << "Seeding!" << std::endl;
+
+        stopwatch.Restart();
+        BGPX_TRACE_BEGIN(seedingSpan, "seeding", "phase");
+        if (lanes.empty())
+            g.SeedBlock(announcementsFilePath, config);
+        else
+            g.SeedBlock(announcementsFilePath, lanes);
+        BGPX_TRACE_END(seedingSpan);
+
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("seeding", milliseconds);
+        report["throughput"]["seeding_rows"] = g.GetNumStaticData();
+        report["throughput"]["seeding_rows_per_second"] = milliseconds > 0 ? g.GetNumStaticData() / (milliseconds / 1000) : 0;
+        std::cout << "Seeding Time: " << milliseconds << "ms" << std::endl;
+
+        if (!seedingStateOutputFilePath.empty()) {
+            stopwatch.Restart();
+            BGPX_TRACE_BEGIN(checkpointSpan, "seeding_checkpoint_write", "phase");
+            if (!g.WriteCheckpoint(seedingStateOutputFilePath))
+                return false;
+            BGPX_TRACE_END(checkpointSpan);
+            report.AddTiming("seeding_checkpoint_write", stopwatch.ElapsedMilliseconds());
+        }
+
+        if (dump_after_seeding) {
+            stopwatch.Restart();
+            BGPX_TRACE_BEGIN(writeSpan, "seeding_results_write", "phase");
+            // Everything is seeded at this point
+            ResultsFilter seedingFilter = resultsFilter;
+            seedingFilter.propagatedOnly = false;
+
+            std::vector<size_t> laneBytesWritten;
+            if (!g.GenerateTracebackResultsCSV(resultsFilePaths("Results_Seeding"), controlPlaneASNs, laneBytesWritten, seedingFilter))
+                return false;
+            size_t bytesWritten = std::accumulate(laneBytesWritten.begin(), laneBytesWritten.end(), (size_t) 0);
+            BGPX_TRACE_END(writeSpan);
+
+            milliseconds = stopwatch.ElapsedMilliseconds();
+            report.AddTiming("seeding_results_write", milliseconds);
+            report["throughput"]["seeding_results_bytes_written"] = bytesWritten;
+            std::cout << "Writing Time: " << milliseconds << "ms" << std::endl;
+        }
+
+        stopwatch.Restart();
+        BGPX_TRACE_BEGIN(propagationSpan, "propagation", "phase");
+        g.Propagate();
+        BGPX_TRACE_END(propagationSpan);
+
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("propagation", milliseconds);
+        std::cout << "Propatation Time: " << milliseconds << "ms" << std::endl;
+        propagated = true;
+    }
+
+    if (propagated) {
+        const PropagationTimings &timings = g.GetPropagationTimings();
+        report["propagation"]["up_ms"] = timings.upMilliseconds;
+        report["propagation"]["peers_ms"] = timings.peersMilliseconds;
+        report["propagation"]["down_ms"] = timings.downMilliseconds;
+        report["propagation"]["up_rank_ms"] = timings.upRankMilliseconds;
+        report["propagation"]["down_rank_ms"] = timings.downRankMilliseconds;
+
+        if (g.IsProfiling()) {
+            const PropagationProfile &profile = g.GetPropagationProfile();
+            nlohmann::json &counters = report["hardware_counters"];
+            counters["up"] = ProfileEntryToJSON(profile.up);
+            counters["peers"] = ProfileEntryToJSON(profile.peers);
+            counters["down"] = ProfileEntryToJSON(profile.down);
+
+            counters["up_ranks"] = nlohmann::json::array();
+            for (auto &entry : profile.upRanks)
+                counters["up_ranks"].push_back(ProfileEntryToJSON(entry));
+
+            counters["down_ranks"] = nlohmann::json::array();
+            for (auto &entry : profile.downRanks)
+                counters["down_ranks"].push_back(ProfileEntryToJSON(entry));
+
+            const char *phaseNames[] = { "Up", "Peers", "Down" };
+            const PropagationProfileEntry *phases[] = { &profile.up, &profile.peers, &profile.down };
+            for (size_t i = 0; i < 3; i++) {
+                double cells = phases[i]->cellsCompared > 0 ? phases[i]->cellsCompared : 1;
+                std::cout << "Propagate " << phaseNames[i] << ": " << phases[i]->cellsCompared << " cells compared, "
+                    << phases[i]->cellsReplaced << " replaced, "
+                    << phases[i]->counters[PERF_COUNTER_CYCLES] / cells << " cycles/cell, "
+                    << phases[i]->counters[PERF_COUNTER_LLC_MISSES] / cells << " LLC misses/cell, "
+                    << phases[i]->counters[PERF_COUNTER_BRANCH_MISSES] / cells << " branch misses/cell, "
+                    << phases[i]->counters[PERF_COUNTER_DTLB_MISSES] / cells << " dTLB misses/cell" << std::endl;
+            }
+        }
+    }
+
+    if (DefaultStatistics::enabled) {
+        const PropagationStatisticsProfile &statistics = g.GetPropagationStatistics();
+        nlohmann::json &section = report["statistics"];
+        section["seeding"] = StatisticsToJSON(statistics.seeding);
+        section["up"] = StatisticsToJSON(statistics.up);
+        section["peers"] = StatisticsToJSON(statistics.peers);
+        section["down"] = StatisticsToJSON(statistics.down);
+
+        section["up_ranks"] = nlohmann::json::array();
+        for (auto &rank : statistics.upRanks)
+            section["up_ranks"].push_back(StatisticsToJSON(rank));
+
+        section["down_ranks"] = nlohmann::json::array();
+        for (auto &rank : statistics.downRanks)
+            section["down_ranks"].push_back(StatisticsToJSON(rank));
+
+        PropagationStatistics total;
+        total.Add(statistics.up);
+        total.Add(statistics.peers);
+        total.Add(statistics.down);
+        for (size_t i = 0; i < COMPARISON_RULE_COUNT; i++) {
+            std::cout << "Comparisons decided by " << PropagationStatistics::GetComparisonRuleName((COMPARISON_RULE) i) << ": "
+                << total.comparisons[i] << " (" << total.comparisonReplacements[i] << " replaced)" << std::endl;
+        }
+    }
+
+    if (numaPlacement) {
+        std::vector<size_t> ribBytesPerNode = g.GetRibBytesPerNode();
+        report["memory"]["local_ribs_bytes_per_numa_node"] = ribBytesPerNode;
+        for (size_t node = 0; node < ribBytesPerNode.size(); node++)
+            std::cout << "Local Ribs on NUMA Node " << node << ": " << ribBytesPerNode[node] / (1024 * 1024) << "MB" << std::endl;
+    }
+
+    if (!stateOutputFilePath.empty()) {
+        stopwatch.Restart();
+        BGPX_TRACE_BEGIN(checkpointSpan, "checkpoint_write", "phase");
+        if (!g.WriteCheckpoint(stateOutputFilePath))
+            return false;
+        BGPX_TRACE_END(checkpointSpan);
+        report.AddTiming("checkpoint_write", stopwatch.ElapsedMilliseconds());
     }
 
-    t1 = std::chrono::high_resolution_clock::now();
-    g.Propagate();
-    t2 = std::chrono::high_resolution_clock::now();
+    stopwatch.Restart();
+    if (aggregateOutputs != 0) {
+        BGPX_TRACE_BEGIN(aggregateSpan, "aggregates_write", "phase");
+        std::vector<RibAggregates> aggregates = g.ComputeRibAggregates(controlPlaneASNs, aggregateOutputs);
+        size_t bytesWritten = 0;
+        for (size_t lane = 0; lane < aggregates.size(); lane++) {
+            size_t laneBytesWritten;
+            if (!aggregates[lane].Write(aggregateOutputs, outputFilePath, lanes.empty() ? "" : "_" + laneNames[lane], laneBytesWritten))
+                return false;
+            bytesWritten += laneBytesWritten;
+        }
+        BGPX_TRACE_END(aggregateSpan);
 
-    time = std::chrono::duration_cast<std::chrono::seconds>(t2 - t1);
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("aggregates_write", milliseconds);
+        report["throughput"]["aggregates_bytes_written"] = bytesWritten;
+        std::cout << "Aggregates Time: " << milliseconds << "ms" << std::endl;
+    } else {
+        BGPX_TRACE_BEGIN(writeSpan, "results_write", "phase");
+        std::vector<size_t> laneBytesWritten;
+        if (!g.GenerateTracebackResultsCSV(resultsFilePaths("Results"), controlPlaneASNs, laneBytesWritten, resultsFilter))
+            return false;
+        size_t bytesWritten = std::accumulate(laneBytesWritten.begin(), laneBytesWritten.end(), (size_t) 0);
+        BGPX_TRACE_END(writeSpan);
+
+        milliseconds = stopwatch.ElapsedMilliseconds();
+        report.AddTiming("results_write", milliseconds);
+        report["throughput"]["results_bytes_written"] = bytesWritten;
+        report["throughput"]["results_bytes_written_per_second"] = milliseconds > 0 ? bytesWritten / (milliseconds / 1000) : 0;
+        std::cout << "Writing Time: " << milliseconds << "ms" << std::endl;
+    }
 
-    std::cout << "Propatation Time: " << time.count() << "s" << std::endl;
+    report["graph"]["num_ases"] = g.GetNumASes();
+    report["graph"]["num_prefixes"] = g.GetNumPrefixes();
+    report["graph"]["num_static_data"] = g.GetNumStaticData();
+    report["graph"]["num_threads"] = g.GetNumThreads();
+    report["graph"]["num_lanes"] = g.GetNumLanes();
 
-    t1 = std::chrono::high_resolution_clock::now();
-    g.GenerateTracebackResultsCSV(outputFilePath + "Results.tsv", controlPlaneASNs);
-    t2 = std::chrono::high_resolution_clock::now();
+    for (auto &structure : g.GetMemoryUsage())
+        report["memory"]["structure_bytes"][structure.first] = structure.second;
+    report["memory"]["peak_rss_bytes"] = RunReport::GetPeakRSSBytes();
 
-    std::cout << "Writing Time: " << time.count() << "s" << std::endl;
+    report.Write(outputFilePath + "RunReport.json");
+
+#ifdef BGPX_TRACE
+    if (!traceFilePath.empty()) {
+        TraceRecorder::Get().Disable();
+        if (!TraceRecorder::Get().Write(traceFilePath))
+            std::cout << "Could not write the trace file: " << traceFilePath << std::endl;
+    }
+#endif
+
+    return true;
+}
+
+/**
+ * Loads the graph of a launch configuration (relationships, stub removal, provider preferences and the local rib options) and keeps it
+ *  loaded, running the experiments requested as JSON lines, see ExperimentServer.hpp. Requests come from stdin and responses go to stdout,
+ *  or both go over the UNIX socket given by server_socket. Anything else the extrapolator prints goes to stderr.
+ */
+void ServeExperimentsFromConfig(const std::string &launchJSONPath) {
+    std::ifstream launchFile(launchJSONPath);
+    nlohmann::json launchJSON = nlohmann::json::parse(launchFile, nullptr, true, true);
+    launchFile.close();
+
+    auto rel_search = launchJSON.find("relationships_file");
+    if (rel_search == launchJSON.end() || rel_search.value() == "") {
+        std::cout << "Expected path to relationships TSV file!" << std::endl;
+        return;
+    }
+
+    std::string relationshipsFilePath = rel_search.value();
+
+    bool stubRemoval = false;
+    auto stubRemovalSearch = launchJSON.find("stub_removal");
+    if (stubRemovalSearch != launchJSON.end()) {
+        if (stubRemovalSearch.value().is_boolean()) {
+            stubRemoval = stubRemovalSearch.value().get<bool>();
+        } else {
+            std::cout << "Unknown value for stub removal" << std::endl;
+            return;
+        }
+    }
+
+    std::unordered_map<ASN, std::vector<ASN>> customerToProviderPreferences;
+    auto provider_preferences_search = launchJSON.find("provider_preferences");
+    if (provider_preferences_search != launchJSON.end() && !ParseProviderPreferences(provider_preferences_search.value(), customerToProviderPreferences)) {
+        std::cout << "Expected an object of provider_preferences!" << std::endl;
+        return;
+    }
+
+    size_t numThreads = 1;
+    auto num_threads_search = launchJSON.find("num_threads");
+    if (num_threads_search != launchJSON.end()) {
+        if (num_threads_search.value().is_number_unsigned()) {
+            numThreads = num_threads_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive integer for the number of threads!" << std::endl;
+            return;
+        }
+    }
+
+    std::string ribBackingFilePath = "";
+    auto rib_backing_file_search = launchJSON.find("rib_backing_file");
+    if (rib_backing_file_search != launchJSON.end()) {
+        if (rib_backing_file_search.value().is_string()) {
+            ribBackingFilePath = rib_backing_file_search.value().get<std::string>();
+        } else {
+            std::cout << "Expected a file path for the local rib backing file!" << std::endl;
+            return;
+        }
+    }
+
+    size_t ribTileMemory = 256 * 1024 * 1024;
+    auto rib_tile_memory_search = launchJSON.find("rib_tile_memory");
+    if (rib_tile_memory_search != launchJSON.end()) {
+        if (rib_tile_memory_search.value().is_number_unsigned()) {
+            ribTileMemory = rib_tile_memory_search.value().get<size_t>();
+        } else {
+            std::cout << "Expected a positive number of bytes for the local rib tile memory!" << std::endl;
+            return;
+        }
+    }
+
+    bool numaPlacement = false;
+    auto numa_placement_search = launchJSON.find("numa_placement");
+    if (numa_placement_search != launchJSON.end()) {
+        if (numa_placement_search.value().is_boolean()) {
+            numaPlacement = numa_placement_search.value().get<bool>();
+        } else {
+            std::cout << "Expected a boolean for NUMA placement!" << std::endl;
+            return;
+        }
+    }
+
+    std::string socketPath = "";
+    auto server_socket_search = launchJSON.find("server_socket");
+    if (server_socket_search != launchJSON.end()) {
+        if (server_socket_search.value().is_string()) {
+            socketPath = server_socket_search.value().get<std::string>();
+        } else {
+            std::cout << "Expected a file path for the server socket!" << std::endl;
+            return;
+        }
+    }
+
+    // stdout carries the responses when serving stdin, everything else is printed to stderr
+    std::ostream responses(std::cout.rdbuf());
+    std::streambuf *stdoutBuffer = std::cout.rdbuf();
+    if (socketPath.empty())
+        std::cout.rdbuf(std::cerr.rdbuf());
+
+    Stopwatch stopwatch;
+    Graph g(relationshipsFilePath, customerToProviderPreferences, stubRemoval, numThreads);
+    std::cout << "Graph Load Time: " << stopwatch.ElapsedMilliseconds() << "ms" << std::endl;
+
+    g.SetNumThreads(numThreads);
+    if (!ribBackingFilePath.empty())
+        g.SetRibBacking(ribBackingFilePath, ribTileMemory);
+    if (numaPlacement)
+        g.SetNumaPlacement(true);
+
+    ExperimentServer server(g);
+    if (socketPath.empty())
+        server.Serve(std::cin, responses);
+    else
+        server.ServeSocket(socketPath);
+
+    std::cout << "Served " << server.GetNumServed() << " experiments" << std::endl;
+    std::cout.rdbuf(stdoutBuffer);
 }
 
 /**
@@ -214,11 +987,17 @@ void RunExperimentFromConfig(const std::string &launchJSONPath) {
  *      - However, the neighbor recieved from ID would have to lookup the ASN if doing an ASN comparison
  */
 int main(int argc, char *argv[]) {
+    if (argc > 0)
+        executableName = argv[0];
+
     if (argc == 3) {
         std::string command(argv[1]);
         std::string value(argv[2]);
         if (command == "--config") {
-            RunExperimentFromConfig(value);
+            if (!RunExperimentFromConfig(value))
+                return 1;
+        } else if (command == "--serve") {
+            ServeExperimentsFromConfig(value);
         } else {
             Usage(true);
         }
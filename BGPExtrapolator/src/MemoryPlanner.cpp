@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "MemoryPlanner.hpp"
+#include "InputFile.hpp"
+
+// Strings up to this long live inside the std::string itself (libstdc++), longer ones on the heap
+static const size_t SMALL_STRING_CAPACITY = 15;
+
+// Address space reserved for the stack of every worker thread (glibc default)
+static const size_t THREAD_STACK_BYTES = 8 * 1024 * 1024;
+
+// Out of core ribs hold the tile being worked on and the one being prefetched
+static const size_t RESIDENT_TILES = 2;
+
+// A pipelined run propagates into one local rib allocation while the results of the other are written,
+//  and holds the announcements of a batch being parsed, one queued, one seeded and one being written
+static const size_t PIPELINE_RIB_BUFFERS = 2;
+static const size_t PIPELINE_BATCHES_IN_FLIGHT = 4;
+
+// Code, libraries and allocator slack of the process itself
+static const size_t RUNTIME_BYTES = 16 * 1024 * 1024;
+
+// The write buffer of GenerateTracebackResultsCSV
+static const size_t RESULTS_BUFFER_BYTES = 10000;
+
+// The results writer formats the paths of TRACEBACK_BLOCKS_PER_PASS prefix blocks at a time, keeping a few bytes of bookkeeping
+//  and the path text (a few ASNs, "12345,") for every AS and block
+static const size_t TRACEBACK_BYTES_PER_AS = 12 + 48;
+
+/**
+ * Bytes malloc hands out for a string of the given length (glibc: 8 bytes of header, 16 byte granularity, 32 at least)
+ */
+static size_t StringHeapBytes(const size_t length) {
+    if (length <= SMALL_STRING_CAPACITY)
+        return 0;
+
+    size_t chunk = (length + 1 + 8 + 15) & ~((size_t) 15);
+    return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * Capacity of a vector after appending count elements to one of the given size and capacity (libstdc++ growth: double, or grow to fit)
+ */
+static size_t GrowCapacity(const size_t size, const size_t capacity, const size_t count) {
+    if (size + count <= capacity)
+        return capacity;
+
+    return size + std::max(size, count);
+}
+
+/**
+ * Capacity of a vector that had count elements pushed back one at a time
+ */
+static size_t PushBackCapacity(const size_t count) {
+    size_t capacity = 0;
+    for (size_t size = 0; size < count; size++)
+        capacity = GrowCapacity(size, capacity, 1);
+
+    return capacity;
+}
+
+bool MemoryPlanner::ScanAnnouncements(const std::string &filePath, AnnouncementsScan &scan) {
+    // Compressed files are scanned as they will be parsed, decompressed
+    InputFile input;
+    if (!input.Open(filePath))
+        return false;
+
+    scan = AnnouncementsScan();
+
+    size_t prefixColumn = (size_t) -1, pathColumn = (size_t) -1;
+    size_t seededPathSize = 0;
+
+    // A line at a time, the columns found by counting separators
+    std::string current;
+    bool header = true;
+    while (input.ReadLine(current)) {
+        scan.fileBytes += current.size() + 1;
+
+        size_t column = 0, cellBegin = 0;
+        for (size_t i = 0; i <= current.size(); i++) {
+            if (i < current.size() && current[i] != SEPARATED_VALUES_DELIMETER)
+                continue;
+
+            const size_t cellLength = i - cellBegin;
+            if (header) {
+                std::string name = current.substr(cellBegin, cellLength);
+                if (name == "prefix")
+                    prefixColumn = column;
+                else if (name == "as_path")
+                    pathColumn = column;
+            } else {
+                if (column == prefixColumn)
+                    scan.prefixStringHeapBytes += StringHeapBytes(cellLength);
+
+                if (column == pathColumn && cellLength > 2) {
+                    // "{1,2,3}" -> one more ASN than commas
+                    size_t pathLength = 1;
+                    for (size_t j = cellBegin; j < i; j++)
+                        pathLength += current[j] == ',';
+
+                    scan.totalPathASNs += pathLength;
+                    scan.seededPathCapacity = GrowCapacity(seededPathSize, scan.seededPathCapacity, pathLength);
+                    seededPathSize += pathLength;
+                }
+            }
+
+            // The header row is a row of the document too
+            scan.cellHeapBytes += StringHeapBytes(cellLength);
+            column++;
+            cellBegin = i + 1;
+        }
+
+        if (header)
+            scan.numColumns = column;
+        else
+            scan.numRows++;
+
+        header = false;
+    }
+
+    if (input.IsCorrupt()) {
+        std::cout << "The announcements file is corrupt or truncated: " << filePath << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Peer staging buffer of PropagatePeers for a range of the given number of prefixes
+ */
+static size_t GetPeerStagingBytes(const size_t numASes, const size_t rangeLength) {
+    if (numASes == 0 || rangeLength == 0)
+        return 0;
+
+    size_t chunkLength = std::max(PEER_STAGING_BUDGET_BYTES / (numASes * sizeof(AnnouncementCachedData)), (size_t) 1);
+    return numASes * std::min(chunkLength, rangeLength) * sizeof(AnnouncementCachedData);
+}
+
+MemoryPlan MemoryPlanner::Plan(const Graph &graph, const AnnouncementsScan &scan, const size_t memoryLimit, const size_t numThreads,
+        const bool retainSeededPaths, const bool fileBacking, const size_t tileMemoryBytes, const size_t numDumpedASes, const size_t numLanes,
+        const size_t pipelineBatchRows) {
+    MemoryPlan plan;
+    plan.numThreads = std::max(numThreads, (size_t) 1);
+
+    const size_t numASes = graph.GetNumASes();
+    const size_t lanes = std::max(numLanes, (size_t) 1);
+    const size_t numPrefixes = scan.numRows * lanes; // SeedBlock sizes the local ribs by the number of rows, for every lane
+    const size_t bytesPerPrefix = std::max(numASes, (size_t) 1) * sizeof(AnnouncementCachedData);
+
+    for (auto &structure : graph.GetMemoryUsage())
+        plan.graphBytes += structure.second;
+
+    // The CSV document: a vector of rows, each a vector of cell strings
+    const size_t numDocumentRows = scan.numRows + 1;
+    plan.documentBytes = PushBackCapacity(numDocumentRows) * sizeof(std::vector<std::string>)
+        + numDocumentRows * PushBackCapacity(scan.numColumns) * sizeof(std::string) + scan.cellHeapBytes;
+
+    plan.staticDataBytes = scan.numRows * sizeof(AnnouncementStaticData) + scan.prefixStringHeapBytes;
+    plan.seededPathBytes = retainSeededPaths ? scan.seededPathCapacity * sizeof(ASN) : 0;
+    plan.ribBytes = numASes * numPrefixes * sizeof(AnnouncementCachedData);
+
+    const size_t numDumped = numDumpedASes > 0 ? numDumpedASes : numASes + graph.GetNumStubs();
+    plan.outputBytes = RESULTS_BUFFER_BYTES + numDumped * (sizeof(ASN) + sizeof(ASN_ID) + sizeof(int64_t))
+        + numASes * TRACEBACK_BLOCKS_PER_PASS * TRACEBACK_BYTES_PER_AS;
+
+    // Everything but the local ribs, the document and the staging buffer
+    auto fixedBytes = [&](const size_t threads) {
+        return RUNTIME_BYTES + plan.graphBytes + plan.staticDataBytes + plan.seededPathBytes + plan.outputBytes + (threads - 1) * THREAD_STACK_BYTES;
+    };
+
+    // Seeding holds the document and the ribs at once, propagation the ribs and the staging buffer
+    auto evaluate = [&](const size_t threads, const size_t residentRibBytes, const size_t rangeLength) {
+        plan.numThreads = threads;
+        plan.residentRibBytes = residentRibBytes;
+        plan.batchBytes = 0;
+        plan.peerStagingBytes = GetPeerStagingBytes(numASes, rangeLength);
+        plan.seedingPeakBytes = fixedBytes(threads) + plan.documentBytes + residentRibBytes;
+        plan.propagationPeakBytes = fixedBytes(threads) + residentRibBytes + plan.peerStagingBytes;
+        plan.peakBytes = std::max(plan.seedingPeakBytes, plan.propagationPeakBytes);
+        return memoryLimit == 0 || plan.peakBytes <= memoryLimit;
+    };
+
+    // Parsed announcement (path and prefix string) and static data of a row of a batch
+    const size_t bytesPerBatchRow = sizeof(ScenarioAnnouncement)
+        + (scan.numRows > 0 ? (plan.staticDataBytes + scan.prefixStringHeapBytes + scan.totalPathASNs * sizeof(ASN)) / scan.numRows : 0);
+
+    // Pipelined: the local ribs of two batches and the announcements of the batches in flight, rather than the whole file and its document
+    auto evaluatePipelined = [&](const size_t threads, const size_t batchRows) {
+        const size_t rows = std::min(batchRows, scan.numRows);
+        plan.numThreads = threads;
+        plan.residentRibBytes = PIPELINE_RIB_BUFFERS * rows * lanes * bytesPerPrefix;
+        plan.peerStagingBytes = GetPeerStagingBytes(numASes, rows * lanes);
+
+        plan.batchBytes = PIPELINE_BATCHES_IN_FLIGHT * rows * bytesPerBatchRow;
+        const size_t batchesBytes = fixedBytes(threads) - plan.staticDataBytes + plan.batchBytes;
+        plan.seedingPeakBytes = batchesBytes + plan.residentRibBytes;
+        plan.propagationPeakBytes = batchesBytes + plan.residentRibBytes + plan.peerStagingBytes;
+        plan.peakBytes = std::max(plan.seedingPeakBytes, plan.propagationPeakBytes);
+        return memoryLimit == 0 || plan.peakBytes <= memoryLimit;
+    };
+
+    // Pipelined batches need the local ribs in memory
+    const bool pipelined = pipelineBatchRows > 0 && !fileBacking;
+
+    // Tile length as LocalRibs rounds it: a power of two
+    auto tileLengthFor = [&](const size_t memory) {
+        size_t prefixesPerTile = std::max(memory / bytesPerPrefix, (size_t) 1);
+        size_t powerOfTwo = 1;
+        while (powerOfTwo * 2 <= prefixesPerTile)
+            powerOfTwo *= 2;
+        return std::min(powerOfTwo, std::max(numPrefixes, (size_t) 1));
+    };
+
+    //***** As configured
+    if (fileBacking) {
+        size_t tileLength = tileLengthFor(tileMemoryBytes);
+        plan.useFileBacking = true;
+        plan.tileMemoryBytes = tileMemoryBytes;
+        plan.fits = evaluate(plan.numThreads, std::min(RESIDENT_TILES * tileLength * bytesPerPrefix, plan.ribBytes), tileLength);
+    } else if (pipelined) {
+        plan.pipelineBatchRows = pipelineBatchRows;
+        plan.fits = evaluatePipelined(plan.numThreads, pipelineBatchRows);
+    } else {
+        plan.fits = evaluate(plan.numThreads, plan.ribBytes, numPrefixes);
+    }
+
+    if (plan.fits)
+        return plan;
+
+    //***** Smaller pipelined batches, halving the rows. Threads are only given up if not even a batch of one row fits
+    if (pipelined) {
+        for (size_t threads = std::max(numThreads, (size_t) 1); threads >= 1; threads--) {
+            for (size_t batchRows = pipelineBatchRows; batchRows >= 1; batchRows /= 2) {
+                if (evaluatePipelined(threads, batchRows)) {
+                    plan.fits = true;
+                    plan.pipelineBatchRows = batchRows;
+                    return plan;
+                }
+            }
+        }
+    }
+
+    // Out of core ribs are not pipelined
+    plan.pipelineBatchRows = 0;
+
+    //***** Out of core, with the largest tiles that fit. Threads are only given up if not even a single prefix tile fits
+    size_t maxTileLength = 1;
+    while (maxTileLength < numPrefixes)
+        maxTileLength *= 2;
+
+    for (size_t threads = std::max(numThreads, (size_t) 1); threads >= 1; threads--) {
+        for (size_t tileLength = maxTileLength; tileLength >= 1; tileLength /= 2) {
+            if (evaluate(threads, std::min(RESIDENT_TILES * tileLength * bytesPerPrefix, plan.ribBytes), tileLength)) {
+                plan.fits = true;
+                plan.useFileBacking = true;
+                plan.tileMemoryBytes = tileLength * bytesPerPrefix;
+                return plan;
+            }
+        }
+    }
+
+    // Does not fit in any layout, the figures are those of the layout asked for
+    if (fileBacking) {
+        size_t tileLength = tileLengthFor(tileMemoryBytes);
+        evaluate(std::max(numThreads, (size_t) 1), std::min(RESIDENT_TILES * tileLength * bytesPerPrefix, plan.ribBytes), tileLength);
+    } else if (pipelined) {
+        plan.pipelineBatchRows = pipelineBatchRows;
+        evaluatePipelined(std::max(numThreads, (size_t) 1), pipelineBatchRows);
+    } else {
+        evaluate(std::max(numThreads, (size_t) 1), plan.ribBytes, numPrefixes);
+    }
+
+    plan.fits = false;
+    plan.useFileBacking = fileBacking;
+    plan.tileMemoryBytes = tileMemoryBytes;
+    return plan;
+}
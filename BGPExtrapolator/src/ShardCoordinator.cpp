@@ -0,0 +1,411 @@
+#include <stdio.h>
+#include <errno.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "ShardCoordinator.hpp"
+#include "InputFile.hpp"
+
+//***** Local processes
+
+LocalProcessTransport::LocalProcessTransport(const std::string &executablePath) : executablePath(executablePath) {
+
+}
+
+bool LocalProcessTransport::Launch(const size_t worker, const std::string &launchFilePath, const std::string &logFilePath) {
+#ifndef _WIN32
+    // Whatever is buffered would otherwise be written twice
+    std::cout.flush();
+    fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid < 0)
+        return false;
+
+    if (pid == 0) {
+        // Only async signal safe calls from here on, the parent may have had threads running
+        int fd = open(logFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+
+        execl(executablePath.c_str(), executablePath.c_str(), "--config", launchFilePath.c_str(), (char*) nullptr);
+        _exit(127);
+    }
+
+    if (workerPIDs.size() <= worker)
+        workerPIDs.resize(worker + 1, -1);
+    workerPIDs[worker] = pid;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool LocalProcessTransport::Wait(const size_t worker) {
+#ifndef _WIN32
+    if (worker >= workerPIDs.size() || workerPIDs[worker] < 0)
+        return false;
+
+    int status;
+    pid_t pid = workerPIDs[worker];
+    workerPIDs[worker] = -1;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    return false;
+#endif
+}
+
+std::string LocalProcessTransport::GetCurrentExecutablePath(const std::string &argv0) {
+#ifdef __linux__
+    char path[4096];
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length > 0)
+        return std::string(path, length);
+#endif
+
+    return argv0;
+}
+
+//***** Coordinator
+
+/**
+ * Finds the cell of the given column in a line of separated values
+ *
+ * @return false if the line has fewer columns
+ */
+static bool FindCell(const std::string &line, const size_t column, size_t &cellBegin, size_t &cellEnd) {
+    cellBegin = 0;
+    for (size_t i = 0; i < column; i++) {
+        cellBegin = line.find(SEPARATED_VALUES_DELIMETER, cellBegin);
+        if (cellBegin == std::string::npos)
+            return false;
+        cellBegin++;
+    }
+
+    cellEnd = line.find(SEPARATED_VALUES_DELIMETER, cellBegin);
+    if (cellEnd == std::string::npos)
+        cellEnd = line.size();
+
+    return true;
+}
+
+static bool MakeDirectory(const std::string &path) {
+#ifndef _WIN32
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @return the names of the files in a folder that start and end as given
+ */
+static std::vector<std::string> ListFiles(const std::string &folder, const std::string &prefix, const std::string &suffix) {
+    std::vector<std::string> names;
+#ifndef _WIN32
+    DIR *directory = opendir(folder.c_str());
+    if (directory == nullptr)
+        return names;
+
+    while (struct dirent *entry = readdir(directory)) {
+        std::string name = entry->d_name;
+        if (name.size() >= prefix.size() + suffix.size() && name.compare(0, prefix.size(), prefix) == 0
+                && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+            names.push_back(name);
+    }
+
+    closedir(directory);
+#endif
+    return names;
+}
+
+ShardCoordinator::ShardCoordinator(WorkerTransport &transport) : transport(transport) {
+
+}
+
+bool ShardCoordinator::SplitAnnouncements(const std::string &announcementsFilePath, const std::vector<std::string> &shardFilePaths, std::vector<size_t> &rowsPerShard) {
+    const size_t numShards = shardFilePaths.size();
+    rowsPerShard.assign(numShards, 0);
+
+    InputFile input;
+    std::string header, line;
+    if (numShards == 0 || !input.Open(announcementsFilePath) || !input.ReadLine(header))
+        return false;
+
+    size_t blockColumn = 0, cellBegin, cellEnd;
+    while (FindCell(header, blockColumn, cellBegin, cellEnd) && header.compare(cellBegin, cellEnd - cellBegin, "prefix_block_id") != 0)
+        blockColumn++;
+
+    if (!FindCell(header, blockColumn, cellBegin, cellEnd)) {
+        std::cout << "No prefix_block_id column in " << announcementsFilePath << std::endl;
+        return false;
+    }
+
+    // First pass: rows of every prefix block
+    std::map<uint32_t, size_t> rowsPerBlock;
+    size_t numRows = 0;
+    while (input.ReadLine(line)) {
+        if (line.empty() || !FindCell(line, blockColumn, cellBegin, cellEnd))
+            continue;
+
+        rowsPerBlock[strtoul(line.c_str() + cellBegin, nullptr, 10)]++;
+        numRows++;
+    }
+
+    if (input.IsCorrupt()) {
+        std::cout << "The announcements file is corrupt or truncated: " << announcementsFilePath << std::endl;
+        return false;
+    }
+
+    // Contiguous block ranges of about numRows / numShards rows. Blocks are renumbered from 0 in every shard, the local ribs are sized by rows
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> blockToShardBlock;
+    size_t shard = 0, rowsSoFar = 0;
+    uint32_t nextBlockID = 0;
+    for (auto &kv : rowsPerBlock) {
+        while (shard + 1 < numShards && rowsSoFar >= numRows * (shard + 1) / numShards) {
+            shard++;
+            nextBlockID = 0;
+        }
+
+        blockToShardBlock[kv.first] = std::make_pair(shard, nextBlockID++);
+        rowsSoFar += kv.second;
+    }
+
+    // Second pass: every row to its shard. The shards are written uncompressed, they are only working files
+    std::vector<FILE*> outputs;
+    bool ok = true;
+    for (auto &shardFilePath : shardFilePaths) {
+        outputs.push_back(fopen(shardFilePath.c_str(), "w"));
+        if (outputs.back() == nullptr) {
+            std::cout << "Could not write " << shardFilePath << std::endl;
+            ok = false;
+        } else {
+            fprintf(outputs.back(), "%s\n", header.c_str());
+        }
+    }
+
+    ok = ok && input.Open(announcementsFilePath) && input.ReadLine(line);
+    while (ok && input.ReadLine(line)) {
+        if (line.empty() || !FindCell(line, blockColumn, cellBegin, cellEnd))
+            continue;
+
+        const std::pair<uint32_t, uint32_t> &shardBlock = blockToShardBlock[strtoul(line.c_str() + cellBegin, nullptr, 10)];
+        FILE *output = outputs[shardBlock.first];
+        fwrite(line.data(), 1, cellBegin, output);
+        fprintf(output, "%u", shardBlock.second);
+        fwrite(line.data() + cellEnd, 1, line.size() - cellEnd, output);
+        fputc('\n', output);
+
+        rowsPerShard[shardBlock.first]++;
+    }
+
+    if (input.IsCorrupt())
+        ok = false;
+
+    for (FILE *output : outputs) {
+        if (output != nullptr && fclose(output) != 0)
+            ok = false;
+    }
+
+    return ok;
+}
+
+size_t ShardCoordinator::ConcatenateResults(const std::vector<std::string> &shardFilePaths, const std::string &resultsFilePath) {
+    FILE *output = fopen(resultsFilePath.c_str(), "w");
+    if (output == nullptr)
+        return 0;
+
+    std::vector<char> buffer(1 << 20);
+    size_t bytesWritten = 0;
+    bool ok = true;
+    for (size_t i = 0; i < shardFilePaths.size() && ok; i++) {
+        FILE *input = fopen(shardFilePaths[i].c_str(), "r");
+        if (input == nullptr) {
+            ok = false;
+            break;
+        }
+
+        // Every shard has the header, only the first one is kept
+        if (i > 0) {
+            int c;
+            while ((c = fgetc(input)) != EOF && c != '\n');
+        }
+
+        size_t numRead;
+        while ((numRead = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+            if (fwrite(buffer.data(), 1, numRead, output) != numRead) {
+                ok = false;
+                break;
+            }
+            bytesWritten += numRead;
+        }
+
+        fclose(input);
+    }
+
+    if (fclose(output) != 0)
+        ok = false;
+
+    return ok ? bytesWritten : 0;
+}
+
+bool ShardCoordinator::Run(const nlohmann::json &launchJSON, const Graph &graph, const std::string &announcementsFilePath, const std::string &outputFolder,
+        const size_t numWorkers, RunReport &report) {
+    Stopwatch stopwatch;
+
+    const std::string shardsFolder = outputFolder + "shards/";
+    std::vector<std::string> shardFolders, shardAnnouncementsFilePaths;
+    bool ok = MakeDirectory(shardsFolder);
+    for (size_t i = 0; i < numWorkers && ok; i++) {
+        shardFolders.push_back(shardsFolder + "shard_" + std::to_string(i) + "/");
+        shardAnnouncementsFilePaths.push_back(shardFolders.back() + "Announcements.tsv");
+        ok = MakeDirectory(shardFolders.back());
+    }
+
+    if (!ok) {
+        std::cout << "Could not create the shard folders in " << shardsFolder << std::endl;
+        return false;
+    }
+
+    //***** Topology, written once and mapped by every worker
+    const std::string topologyFilePath = shardsFolder + "Topology.bin";
+    if (!graph.WriteCheckpoint(topologyFilePath))
+        return false;
+
+    report.AddTiming("topology_checkpoint_write", stopwatch.ElapsedMilliseconds());
+
+    //***** Announcements, by prefix block range
+    stopwatch.Restart();
+    std::vector<size_t> rowsPerShard;
+    if (!SplitAnnouncements(announcementsFilePath, shardAnnouncementsFilePaths, rowsPerShard)) {
+        std::cout << "Could not split the announcements file: " << announcementsFilePath << std::endl;
+        return false;
+    }
+
+    report.AddTiming("announcements_split", stopwatch.ElapsedMilliseconds());
+
+    //***** Workers. A shard is a run of its own, from the topology checkpoint
+    // They run at the same time, so they share the memory limit with the coordinator, which keeps the graph loaded meanwhile
+    const size_t numShards = std::count_if(rowsPerShard.begin(), rowsPerShard.end(), [](const size_t rows) { return rows > 0; });
+    size_t workerMemoryLimit = 0;
+    auto memoryLimitSearch = launchJSON.find("memory_limit");
+    if (memoryLimitSearch != launchJSON.end() && memoryLimitSearch.value().get<size_t>() > 0 && numShards > 0) {
+        const size_t memoryLimit = memoryLimitSearch.value().get<size_t>();
+        size_t graphBytes = 0;
+        for (auto &structure : graph.GetMemoryUsage())
+            graphBytes += structure.second;
+
+        if (memoryLimit <= graphBytes) {
+            std::cout << "The memory limit of " << memoryLimit / (1024 * 1024) << "MB does not leave anything for the workers next to the graph ("
+                << graphBytes / (1024 * 1024) << "MB)" << std::endl;
+            return false;
+        }
+
+        workerMemoryLimit = (memoryLimit - graphBytes) / numShards;
+        std::cout << "Every worker may use " << workerMemoryLimit / (1024 * 1024) << "MB of the memory limit" << std::endl;
+    }
+
+    stopwatch.Restart();
+    std::vector<size_t> launched;
+    for (size_t i = 0; i < numWorkers; i++) {
+        if (rowsPerShard[i] == 0)
+            continue;
+
+        nlohmann::json workerJSON = launchJSON;
+        for (auto key : { "worker_processes", "relationships_file", "provider_preferences", "stub_removal",
+                "state_output_file", "seeding_state_output_file", "announcements_diff_file" })
+            workerJSON.erase(key);
+
+        workerJSON["previous_state_file"] = topologyFilePath;
+        workerJSON["checkpoint_topology_only"] = true;
+        workerJSON["announcements_file"] = shardAnnouncementsFilePaths[i];
+        workerJSON["output_folder"] = shardFolders[i];
+        if (workerJSON.find("trace_file") != workerJSON.end())
+            workerJSON["trace_file"] = shardFolders[i] + "Trace.json";
+        if (workerJSON.find("rib_backing_file") != workerJSON.end())
+            workerJSON["rib_backing_file"] = shardFolders[i] + "LocalRibs.scratch";
+        if (workerMemoryLimit > 0)
+            workerJSON["memory_limit"] = workerMemoryLimit;
+
+        // Stale results of an earlier run would pass for those of this one
+        for (auto &name : ListFiles(shardFolders[i], "Results", ".tsv"))
+            remove((shardFolders[i] + name).c_str());
+
+        const std::string workerLaunchFilePath = shardFolders[i] + "Launch.json";
+        std::ofstream workerLaunchFile(workerLaunchFilePath);
+        workerLaunchFile << workerJSON.dump(4) << std::endl;
+        workerLaunchFile.close();
+
+        if (!transport.Launch(i, workerLaunchFilePath, shardFolders[i] + "log.txt")) {
+            std::cout << "Could not start worker " << i << std::endl;
+            ok = false;
+            break;
+        }
+
+        launched.push_back(i);
+    }
+
+    for (size_t i : launched) {
+        if (!transport.Wait(i) || ListFiles(shardFolders[i], "Results", ".tsv").empty()) {
+            std::cout << "Worker " << i << " failed, see " << shardFolders[i] << "log.txt" << std::endl;
+            ok = false;
+        }
+    }
+
+    report.AddTiming("workers", stopwatch.ElapsedMilliseconds());
+    remove(topologyFilePath.c_str());
+
+    nlohmann::json &shards = report["shards"];
+    for (size_t i = 0; i < numWorkers; i++) {
+        shards[i]["rows"] = rowsPerShard[i];
+        shards[i]["folder"] = shardFolders[i];
+        if (workerMemoryLimit > 0)
+            shards[i]["memory_limit"] = workerMemoryLimit;
+    }
+
+    if (!ok || launched.empty())
+        return false;
+
+    //***** Merge, every results file the workers wrote (Results.tsv, Results_Seeding.tsv, one per configuration, ...)
+    stopwatch.Restart();
+    size_t bytesWritten = 0;
+    for (auto &name : ListFiles(shardFolders[launched[0]], "Results", ".tsv")) {
+        std::vector<std::string> shardResultsFilePaths;
+        for (size_t i : launched)
+            shardResultsFilePaths.push_back(shardFolders[i] + name);
+
+        size_t fileBytes = ConcatenateResults(shardResultsFilePaths, outputFolder + name);
+        if (fileBytes == 0) {
+            std::cout << "Could not merge " << name << " of the shards into " << outputFolder << name << std::endl;
+            ok = false;
+        }
+
+        bytesWritten += fileBytes;
+        for (auto &shardResultsFilePath : shardResultsFilePaths)
+            remove(shardResultsFilePath.c_str());
+    }
+
+    for (size_t i : launched)
+        remove(shardAnnouncementsFilePaths[i].c_str());
+
+    report.AddTiming("results_merge", stopwatch.ElapsedMilliseconds());
+    report["throughput"]["results_bytes_written"] = bytesWritten;
+    return ok;
+}
@@ -1,7 +1,100 @@
+#include <algorithm>
+#include <iostream>
+
 #include "Testing.hpp"
+#include "Propagation_ImportPolicies/BGPDefaultImportPolicy.hpp"
+
+/**
+ * @param asns -> ASes to compare, removed stubs included
+ * @return whether every AS has the same route for every prefix block in both graphs (the differences are printed).
+ *  The local ribs may have more columns in one graph (seeding from a file sizes them by the rows), those must be empty
+ */
+static bool SameRoutes(const Graph &expected, const Graph &actual, const std::vector<ASN> &asns) {
+    const uint32_t numPrefixBlocks = std::max(expected.GetNumPrefixes(), actual.GetNumPrefixes());
+
+    bool same = true;
+    for (ASN asn : asns) {
+        for (uint32_t prefixBlockID = 0; prefixBlockID < numPrefixBlocks; prefixBlockID++) {
+            QueriedRoute expectedRoute, actualRoute;
+            const bool expectedFound = expected.QueryRoute(asn, prefixBlockID, expectedRoute);
+            const bool actualFound = actual.QueryRoute(asn, prefixBlockID, actualRoute);
+
+            if (expectedFound != actualFound || expectedRoute.prefixString != actualRoute.prefixString || expectedRoute.originASN != actualRoute.originASN
+                    || expectedRoute.timestamp != actualRoute.timestamp || expectedRoute.asPath != actualRoute.asPath) {
+                std::cout << "AS " << asn << " has a different route for prefix block " << prefixBlockID << std::endl;
+                same = false;
+            }
+        }
+    }
+
+    return same;
+}
+
+/**
+ * Applies Delta-Diff.tsv to a graph propagated from Delta-Announcements.tsv, which must give the routes of a full run over Delta-Announcements-After.tsv.
+ * The diff has every kind of change: a removed announcement, changed paths that are shorter and longer than before, and added announcements
+ *  (one in the slot the removed one left, one in a new prefix block). Diffs that do not identify their announcements must be refused.
+ */
+static bool TestAnnouncementsDelta(const bool stubRemoval) {
+    const std::string relationshipsFilePath = "TestCases/BGP_Prop-Relationships.tsv";
+    const std::string diffFilePath = "TestCases/Delta-Diff.tsv";
+    const std::vector<ASN> asns = { 1, 2, 3, 4, 5, 6, 777 };
+    SeedingConfiguration config;
+
+    Graph delta(relationshipsFilePath, {}, stubRemoval);
+    delta.SetRetainSeededPaths(true);
+    delta.SeedBlock("TestCases/Delta-Announcements.tsv", config);
+    delta.Propagate();
+    if (!delta.ApplyAnnouncementsDelta(diffFilePath, config)) {
+        std::cout << "The announcements diff was refused" << std::endl;
+        return false;
+    }
+
+    Graph full(relationshipsFilePath, {}, stubRemoval);
+    full.SeedBlock("TestCases/Delta-Announcements-After.tsv", config);
+    full.Propagate();
+    if (!SameRoutes(full, delta, asns))
+        return false;
+
+    // The announcement the diff removes is gone now
+    if (delta.ApplyAnnouncementsDelta(diffFilePath, config)) {
+        std::cout << "A diff removing an announcement that does not exist was applied" << std::endl;
+        return false;
+    }
+
+    // Two announcements of prefix block 0 from vantage point 777, the removed row of the diff cannot tell which one it is
+    std::vector<ScenarioAnnouncement> duplicates(2);
+    duplicates[0].asPath = { 777 };
+    duplicates[1].asPath = { 777, 5 };
+    for (ScenarioAnnouncement &announcement : duplicates) {
+        announcement.prefix.global_id = 0;
+        announcement.prefix.block_id = 0;
+        announcement.prefixString = "1.2.0.0/16";
+        announcement.timestamp = 1;
+    }
+
+    Graph ambiguous(relationshipsFilePath, {}, stubRemoval);
+    ambiguous.SetRetainSeededPaths(true);
+    ambiguous.SeedBlock(duplicates, 1, config);
+    ambiguous.Propagate();
+    if (ambiguous.ApplyAnnouncementsDelta(diffFilePath, config)) {
+        std::cout << "A diff over announcements with the same prefix block and vantage point was applied" << std::endl;
+        return false;
+    }
+
+    return true;
+}
 
 bool RunTestCases() {
     //Test Cases are now handled in the python framework.
     //TODO: There are probably some other tests we can run here. Write some at some point :)
-    return true;
+    bool passed = true;
+    for (bool stubRemoval : { false, true }) {
+        if (!TestAnnouncementsDelta(stubRemoval)) {
+            std::cout << "Announcements delta test failed, stub removal " << (stubRemoval ? "on" : "off") << std::endl;
+            passed = false;
+        }
+    }
+
+    return passed;
 }
@@ -1,23 +1,131 @@
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BGPX_SSE2_PARSING
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #include "Utils.hpp"
 
+static inline ASN ParseDigitsScalar(const char* digits, const size_t length) {
+    ASN value = 0;
+    for (size_t i = 0; i < length; i++)
+        value = value * 10 + (digits[i] - '0');
+    return value;
+}
+
+#ifdef BGPX_SSE2_PARSING
+static inline unsigned LowestBit(const uint32_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, word);
+    return index;
+#else
+    return __builtin_ctz(word);
+#endif
+}
+
+/**
+ * Converts the 8 digits of a little endian word at once (the most significant one in the lowest byte), pairs, then quads, then the whole.
+ * Bytes that are 0 count as leading zeros
+ */
+static inline uint32_t ParseEightDigits(uint64_t word) {
+    word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFULL;
+    word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFULL;
+    return (uint32_t) ((word * 10000 + (word >> 32)) & 0xFFFFFFFFULL);
+}
+
+/**
+ * @param digits -> Last byte of the run of digits at digits + length - 1, with at least 8 readable bytes before that end
+ */
+static inline ASN ParseDigits(const char* digits, const size_t length) {
+    if (length > 10)
+        return ParseDigitsScalar(digits, length);
+
+    // The 8 bytes that end with the run, the ones before the run (delimiters, or leading digits of a long one) zeroed
+    const size_t lowLength = length < 8 ? length : 8;
+    uint64_t word;
+    memcpy(&word, digits + length - 8, sizeof(word));
+    word = (word & 0x0F0F0F0F0F0F0F0FULL) & (~0ULL << (8 * (8 - lowLength)));
+
+    const ASN low = ParseEightDigits(word);
+    return length <= 8 ? low : ParseDigitsScalar(digits, length - 8) * 100000000 + low;
+}
+#endif
+
 std::vector<ASN> Util::parseASNList(const std::string& asPathString) {
     std::vector<ASN> asPath;
+    parseASNList(asPathString, asPath);
+    return asPath;
+}
+
+void Util::parseASNList(const char* begin, const char* end, std::vector<ASN>& asns) {
+    asns.clear();
+    const char* position = begin;
+
+#ifdef BGPX_SSE2_PARSING
+    // 16 bytes at a time: a mask of the digits, then every run of digits in it. The bytes are copied after 16 '0's,
+    //  so that the 8 bytes ending with a run can always be read (see ParseDigits)
+    alignas(16) char chunk[32];
+    memset(chunk, '0', 16);
+    const __m128i belowDigits = _mm_set1_epi8('0' - 1), aboveDigits = _mm_set1_epi8('9' + 1);
+
+    while (position < end) {
+        const bool full = end - position >= 16;
+        if (full) {
+            _mm_store_si128((__m128i*) (chunk + 16), _mm_loadu_si128((const __m128i*) position));
+        } else {
+            // Padding that is not a digit ends the last run within the chunk
+            memset(chunk + 16, 0, 16);
+            memcpy(chunk + 16, position, end - position);
+        }
 
-    if (asPathString == "{}" || asPathString == "{ }")
-        return asPath;
+        const __m128i bytes = _mm_load_si128((const __m128i*) (chunk + 16));
+        uint32_t digits = _mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(bytes, belowDigits), _mm_cmplt_epi8(bytes, aboveDigits)));
 
-    const char* asPathStringC = asPathString.c_str();
-    char* next;
-    long val = strtoul(asPathStringC + 1, &next, 10);
+        size_t consumed = 16;
+        while (digits != 0) {
+            const unsigned start = LowestBit(digits);
+            const unsigned length = LowestBit(~(digits >> start));
 
-    asPath.push_back(val);
+            if (full && start + length == 16) {
+                if (start > 0) {
+                    // The run may go on in the next bytes, the next chunk starts with it
+                    consumed = start;
+                } else {
+                    // More digits than a chunk holds (not an ASN, wraps around as the conversion does)
+                    const char* run = position;
+                    while (run < end && *run >= '0' && *run <= '9')
+                        run++;
+                    asns.push_back(ParseDigitsScalar(position, run - position));
+                    consumed = run - position;
+                }
+                break;
+            }
 
-    while (next < asPathStringC + asPathString.size() - 1) {
-        val = strtoul(next + 1, &next, 10);
-        asPath.push_back(val);
+            asns.push_back(ParseDigits(chunk + 16 + start, length));
+            digits &= ~0U << (start + length);
+        }
+
+        position += consumed;
     }
+#else
+    while (position < end) {
+        if (*position < '0' || *position > '9') {
+            position++;
+            continue;
+        }
 
-    return asPath;
+        const char* run = position;
+        while (position < end && *position >= '0' && *position <= '9')
+            position++;
+        asns.push_back(ParseDigitsScalar(run, position - run));
+    }
+#endif
 }
 
 bool Util::ASPathContainCycle(const std::vector<ASN> &asPath) {
@@ -36,3 +144,35 @@ bool Util::ASPathContainCycle(const std::vector<ASN> &asPath) {
 
     return cycle;
 }
+
+void Util::splitSeparatedValues(const std::string& line, std::vector<std::string>& cells) {
+    // The strings of the previous line are overwritten in place, a file of long cells (AS paths) allocates only for its first lines
+    size_t numCells = 0;
+    size_t cellBegin = 0;
+    for (size_t i = 0; i <= line.size(); i++) {
+        if (i < line.size() && line[i] != SEPARATED_VALUES_DELIMETER)
+            continue;
+
+        if (numCells == cells.size())
+            cells.push_back(std::string());
+        std::string &cell = cells[numCells++];
+
+        if (i - cellBegin >= 2 && line[cellBegin] == '"' && line[i - 1] == '"')
+            cell.assign(line, cellBegin + 1, i - cellBegin - 2);
+        else
+            cell.assign(line, cellBegin, i - cellBegin);
+
+        cellBegin = i + 1;
+    }
+
+    cells.resize(numCells);
+}
+
+int Util::findColumn(const std::vector<std::string>& header, const std::string& name) {
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name)
+            return i;
+    }
+
+    return -1;
+}